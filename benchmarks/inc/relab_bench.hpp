@@ -0,0 +1,49 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#ifndef BENCHMARKS_INC_RELAB_BENCH_HPP_
+#define BENCHMARKS_INC_RELAB_BENCH_HPP_
+
+#include <torch/extension.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "agents/memory/experience.hpp"
+#include "agents/memory/replay_buffer.hpp"
+#include "frame_source.hpp"
+
+#define BENCH_SCREEN_SIZE 84
+#define BENCH_N_EXPERIENCES 512
+
+namespace relab::bench::impl {
+
+using relab::agents::memory::Experience;
+using relab::agents::memory::ReplayBuffer;
+using relab::test::FrameSource;
+
+/**
+ * Retrieve the replay buffer arguments corresponding to a prioritized
+ * multistep replay buffer.
+ * @param n_steps the number of steps for which rewards are accumulated
+ * @return the replay buffer arguments
+ */
+std::map<std::string, float> getArgs(int n_steps);
+
+/**
+ * Append experiences generated by a frame source to a replay buffer, the
+ * experiences are generated a few at a time to bound memory usage.
+ * @param buffer the replay buffer
+ * @param source the frame source generating the experiences
+ * @param n the number of experiences to append
+ * @param stack_size the number of frames per observation
+ */
+void fillReplayBuffer(ReplayBuffer &buffer, FrameSource &source, int n, int stack_size);
+}  // namespace relab::bench::impl
+
+namespace relab::bench {
+using impl::fillReplayBuffer;
+using impl::getArgs;
+}  // namespace relab::bench
+
+#endif  // BENCHMARKS_INC_RELAB_BENCH_HPP_
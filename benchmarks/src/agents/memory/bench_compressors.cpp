@@ -0,0 +1,96 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <benchmark/benchmark.h>
+#include <torch/extension.h>
+
+#include <vector>
+
+#include "agents/memory/compressors.hpp"
+#include "agents/memory/frame_buffer.hpp"
+#include "frame_source.hpp"
+#include "relab_bench.hpp"
+
+using namespace relab::agents::memory;
+using namespace relab::bench;
+using namespace relab::test;
+
+namespace relab::bench::agents::memory {
+
+/**
+ * The number of distinct frames encoded and decoded by the benchmarks, which
+ * is a multiple of the delta compressor's keyframe interval.
+ */
+const int N_FRAMES = 64;
+
+/**
+ * The size of an uncompressed frame in bytes.
+ */
+const int FRAME_SIZE = BENCH_SCREEN_SIZE * BENCH_SCREEN_SIZE * sizeof(float);
+
+void BM_CompressorEncode(benchmark::State &state) {
+  // Create the compressor and the frames to encode.
+  auto type = static_cast<CompressorType>(state.range(0));
+  auto compressor = Compressor::create(BENCH_SCREEN_SIZE, BENCH_SCREEN_SIZE, type);
+  auto frames = FrameSource().getFrames(N_FRAMES);
+
+  // Encode the frames in order.
+  int t = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(compressor->encode(frames[t]));
+    t = (t + 1) % N_FRAMES;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * FRAME_SIZE);
+}
+BENCHMARK(BM_CompressorEncode)->ArgNames({"type"})->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+void BM_CompressorDecode(benchmark::State &state) {
+  // Create the compressor and encode the frames to decode.
+  auto type = static_cast<CompressorType>(state.range(0));
+  auto compressor = Compressor::create(BENCH_SCREEN_SIZE, BENCH_SCREEN_SIZE, type);
+  std::vector<torch::Tensor> encoded_frames;
+  for (auto frame : FrameSource().getFrames(N_FRAMES)) {
+    encoded_frames.push_back(compressor->encode(frame));
+  }
+
+  // Decode the frames in order, delta encoded frames require the previous frame in the output buffer.
+  auto output = torch::zeros({BENCH_SCREEN_SIZE, BENCH_SCREEN_SIZE});
+  int t = 0;
+  for (auto _ : state) {
+    compressor->decode(encoded_frames[t], output.data_ptr<float>());
+    benchmark::ClobberMemory();
+    t = (t + 1) % N_FRAMES;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * FRAME_SIZE);
+}
+BENCHMARK(BM_CompressorDecode)->ArgNames({"type"})->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+void BM_FrameBufferRetrieval(benchmark::State &state) {
+  // Create a full frame buffer, decoding observations with the requested number of threads.
+  int capacity = 10000;
+  int batch_size = state.range(0);
+  int stack_size = state.range(1);
+  auto type = static_cast<CompressorType>(state.range(2));
+  int n_threads = state.range(3);
+  FrameBuffer buffer(capacity, 1, 1, stack_size, BENCH_SCREEN_SIZE, type, n_threads);
+  FrameSource source;
+  for (int i = 0; i < capacity; i += BENCH_N_EXPERIENCES) {
+    for (auto experience : source.getExperiences(BENCH_N_EXPERIENCES, stack_size)) {
+      buffer.append(experience);
+    }
+  }
+
+  // Retrieve batches of observations.
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(buffer[torch::randint(0, capacity, {batch_size})]);
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_FrameBufferRetrieval)
+    ->ArgNames({"batch_size", "stack_size", "type", "n_threads"})
+    ->ArgsProduct({{32, 256}, {1, 4}, {0, 1, 2}, {1, 4, 8}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace relab::bench::agents::memory
@@ -0,0 +1,122 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <benchmark/benchmark.h>
+#include <torch/extension.h>
+
+#include <random>
+
+#include "agents/memory/priority_tree.hpp"
+#include "helpers/thread_pool.hpp"
+
+using namespace relab::agents::memory;
+using namespace relab::helpers;
+
+namespace relab::bench::agents::memory {
+
+/**
+ * Create a priority tree filled with random priorities.
+ * @param capacity the tree's capacity
+ * @param n_children the number of children each node has
+ * @param sum_tree_type the type of sum-tree used to store the sums of priorities
+ * @return the priority tree
+ */
+PriorityTree createPriorityTree(int capacity, int n_children, SumTreeType sum_tree_type = SumTreeType::N_ARY) {
+  PriorityTree tree(capacity, 1.0, n_children, sum_tree_type);
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> priorities(0.0, 10.0);
+  for (int i = 0; i < capacity; i++) {
+    tree.append(priorities(generator));
+  }
+  return tree;
+}
+
+void BM_PriorityTreeSampleIndices(benchmark::State &state) {
+  // Create a full priority tree.
+  int capacity = state.range(0);
+  int batch_size = state.range(1);
+  auto tree = createPriorityTree(capacity, state.range(2));
+
+  // Sample batches of indices.
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree.sampleIndices(batch_size));
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_PriorityTreeSampleIndices)
+    ->ArgNames({"capacity", "batch_size", "n_children"})
+    ->ArgsProduct({{1000, 100000, 1000000}, {32, 256}, {2, 10}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_PriorityTreeSet(benchmark::State &state) {
+  // Create a full priority tree, and the priorities to set.
+  int capacity = state.range(0);
+  auto tree = createPriorityTree(capacity, state.range(1));
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> indices(0, capacity - 1);
+  std::uniform_real_distribution<float> priorities(0.0, 10.0);
+
+  // Replace the priorities of random elements.
+  for (auto _ : state) {
+    tree.set(indices(generator), priorities(generator));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PriorityTreeSet)
+    ->ArgNames({"capacity", "n_children"})
+    ->ArgsProduct({{1000, 100000, 1000000}, {2, 10}})
+    ->Unit(benchmark::kNanosecond);
+
+void BM_SumTreeSampleIndices(benchmark::State &state) {
+  // Create a full priority tree using the requested sum-tree, whose nodes have ten children if it is an n-ary tree.
+  int capacity = state.range(0);
+  auto tree = createPriorityTree(capacity, 10, static_cast<SumTreeType>(state.range(1)));
+
+  // Sample batches of indices.
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree.sampleIndices(32));
+  }
+  state.SetItemsProcessed(state.iterations() * 32);
+}
+BENCHMARK(BM_SumTreeSampleIndices)
+    ->ArgNames({"capacity", "sum_tree_type"})
+    ->ArgsProduct({{1000000, 10000000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_SumTreeSet(benchmark::State &state) {
+  // Create a full priority tree using the requested sum-tree, and the priorities to set.
+  int capacity = state.range(0);
+  auto tree = createPriorityTree(capacity, 10, static_cast<SumTreeType>(state.range(1)));
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> indices(0, capacity - 1);
+  std::uniform_real_distribution<float> priorities(0.0, 10.0);
+
+  // Replace the priorities of random elements.
+  for (auto _ : state) {
+    tree.set(indices(generator), priorities(generator));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SumTreeSet)
+    ->ArgNames({"capacity", "sum_tree_type"})
+    ->ArgsProduct({{1000000, 10000000}, {0, 1}})
+    ->Unit(benchmark::kNanosecond);
+
+void BM_PriorityTreeAssignAll(benchmark::State &state) {
+  // Create a full priority tree, and the new priorities of all its elements.
+  int capacity = state.range(0);
+  auto tree = createPriorityTree(capacity, 10, static_cast<SumTreeType>(state.range(1)));
+  torch::Tensor priorities = torch::rand({capacity}) * 10;
+  ThreadPool pool(state.range(2));
+
+  // Replace all the priorities, rebuilding the trees.
+  for (auto _ : state) {
+    tree.assignAll(priorities, pool);
+  }
+  state.SetItemsProcessed(state.iterations() * capacity);
+}
+BENCHMARK(BM_PriorityTreeAssignAll)
+    ->ArgNames({"capacity", "sum_tree_type", "n_threads"})
+    ->ArgsProduct({{1000000}, {0, 1}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace relab::bench::agents::memory
@@ -0,0 +1,120 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <benchmark/benchmark.h>
+#include <torch/extension.h>
+
+#include <sstream>
+#include <vector>
+
+#include "agents/memory/replay_buffer.hpp"
+#include "frame_source.hpp"
+#include "relab_bench.hpp"
+
+using namespace relab::agents::memory;
+using namespace relab::bench;
+using namespace relab::test;
+
+namespace relab::bench::agents::memory {
+
+/**
+ * Create a replay buffer from the benchmark arguments, i.e., capacity, batch
+ * size, number of steps, stack size and compressor type.
+ * @param state the benchmark state
+ * @return the replay buffer
+ */
+ReplayBuffer createReplayBuffer(const benchmark::State &state) {
+  int capacity = state.range(0);
+  int batch_size = state.range(1);
+  int n_steps = state.range(2);
+  int stack_size = state.range(3);
+  auto type = static_cast<CompressorType>(state.range(4));
+  return ReplayBuffer(capacity, batch_size, 1, stack_size, BENCH_SCREEN_SIZE, type, getArgs(n_steps));
+}
+
+/**
+ * The arguments shared by all replay buffer benchmarks.
+ */
+const std::vector<std::string> REPLAY_BUFFER_ARG_NAMES = {"capacity", "batch_size", "n_steps", "stack_size", "type"};
+const std::vector<std::vector<int64_t>> REPLAY_BUFFER_ARGS = {{1000, 10000}, {32, 256}, {1, 3}, {4}, {0, 1, 2}};
+
+void BM_ReplayBufferAppend(benchmark::State &state) {
+  // Create the replay buffer and the experiences to append.
+  auto buffer = createReplayBuffer(state);
+  auto experiences = FrameSource().getExperiences(BENCH_N_EXPERIENCES, state.range(3));
+
+  // Append experiences, evicting older ones once the buffer is full. The
+  // experiences are appended repeatedly, as storing enough distinct
+  // experiences for all iterations would exhaust the memory.
+  int t = 0;
+  for (auto _ : state) {
+    buffer.append(experiences[t]);
+    t = (t + 1) % experiences.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReplayBufferAppend)
+    ->ArgNames(REPLAY_BUFFER_ARG_NAMES)
+    ->ArgsProduct(REPLAY_BUFFER_ARGS)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_ReplayBufferSample(benchmark::State &state) {
+  // Create a full replay buffer.
+  auto buffer = createReplayBuffer(state);
+  FrameSource source;
+  fillReplayBuffer(buffer, source, state.range(0), state.range(3));
+
+  // Sample batches of experiences.
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(buffer.sample());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_ReplayBufferSample)
+    ->ArgNames(REPLAY_BUFFER_ARG_NAMES)
+    ->ArgsProduct(REPLAY_BUFFER_ARGS)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+void BM_ReplayBufferReport(benchmark::State &state) {
+  // Create a full replay buffer, and sample a batch whose loss is reported.
+  auto buffer = createReplayBuffer(state);
+  FrameSource source;
+  fillReplayBuffer(buffer, source, state.range(0), state.range(3));
+  buffer.sample();
+  auto loss = torch::rand({state.range(1)});
+
+  // Report the loss of the batch, which updates the priorities.
+  for (auto _ : state) {
+    auto batch_loss = loss.clone();
+    benchmark::DoNotOptimize(buffer.report(batch_loss));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_ReplayBufferReport)
+    ->ArgNames(REPLAY_BUFFER_ARG_NAMES)
+    ->ArgsProduct({{1000, 10000}, {32, 256}, {1}, {4}, {1}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_ReplayBufferSaveAndLoad(benchmark::State &state) {
+  // Create a full replay buffer, and the replay buffer in which it is loaded.
+  auto buffer = createReplayBuffer(state);
+  FrameSource source;
+  fillReplayBuffer(buffer, source, state.range(0), state.range(3));
+  auto loaded_buffer = createReplayBuffer(state);
+
+  // Save the replay buffer in memory and load it back.
+  int64_t n_bytes = 0;
+  for (auto _ : state) {
+    std::stringstream checkpoint;
+    buffer.saveToFile(checkpoint);
+    n_bytes += checkpoint.tellp();
+    loaded_buffer.loadFromFile(checkpoint);
+  }
+  state.SetBytesProcessed(n_bytes);
+}
+BENCHMARK(BM_ReplayBufferSaveAndLoad)
+    ->ArgNames(REPLAY_BUFFER_ARG_NAMES)
+    ->ArgsProduct({{1000, 10000}, {32}, {1}, {4}, {1, 2}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace relab::bench::agents::memory
@@ -0,0 +1,25 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "relab_bench.hpp"
+#include <torch/extension.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace relab::bench::impl {
+
+std::map<std::string, float> getArgs(int n_steps) {
+  return {{"initial_priority", 1.0}, {"omega", 0.7}, {"omega_is", 0.5}, {"n_steps", static_cast<float>(n_steps)}};
+}
+
+void fillReplayBuffer(ReplayBuffer &buffer, FrameSource &source, int n, int stack_size) {
+  for (int i = 0; i < n; i += BENCH_N_EXPERIENCES) {
+    for (auto experience : source.getExperiences(std::min(BENCH_N_EXPERIENCES, n - i), stack_size)) {
+      buffer.append(experience);
+    }
+  }
+}
+
+}  // namespace relab::bench::impl
@@ -340,6 +340,16 @@ class AgentInterface(ABC):
             self.log_mean_metric("log_likelihood", self.log_likelihoods)
             self.log_mean_metric("kl_divergence", self.kl_divergences)
 
+        # Log the latency of the replay buffer operations, which are only
+        # recorded if the C++ library is compiled with instrumentation.
+        buffer = getattr(self, "buffer", None)
+        if buffer is not None and hasattr(buffer, "stats"):
+            for operation, stats in buffer.stats().items():
+                for name, value in stats.items():
+                    self.writer.add_scalar(
+                        f"replay_buffer/{operation}_{name}", value, self.current_step
+                    )
+
     def log_mean_metric(self, name: str, values: deque, scale: float = 1) -> None:
         """!
         Log the mean metric value in TensorBoard.
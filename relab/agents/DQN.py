@@ -33,7 +33,6 @@ from relab.agents.networks.RainbowDeepQNetwork import (
     RainbowImplicitQuantileNetwork,
 )
 from relab.agents.schedule.PiecewiseLinearSchedule import PiecewiseLinearSchedule
-from relab.cpp.agents.memory import Experience
 from relab.helpers.FileSystem import FileSystem
 from relab.helpers.Serialization import get_optimizer, safe_load, safe_load_state_dict
 from relab.helpers.Typing import ActionType, Checkpoint, Loss, ObservationType
@@ -444,8 +443,8 @@ class DQN(AgentInterface):
             obs, reward, terminated, truncated, _ = env.step(action)
             done = terminated or truncated
 
-            # Add the experience to the replay buffer.
-            self.buffer.append(Experience(old_obs, action, reward, done, obs))
+            # Add the experience to the replay buffer, which only reads the newest frames of the next observation.
+            self.buffer.append_arrays(old_obs, action, reward, done, obs)
 
             # Perform one iteration of training (if needed).
             if self.current_step >= self.learning_starts:
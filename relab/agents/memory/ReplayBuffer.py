@@ -1,7 +1,11 @@
-from typing import Optional
+from typing import Any, Dict, List, Optional
 
 import relab
-from relab.cpp.agents.memory import Experience, FastReplayBuffer
+from relab.cpp.agents.memory import (
+    Experience,
+    FastReplayBuffer,
+    SharedExperienceQueue,
+)
 from relab.helpers.Typing import Batch, Config
 from torch import Tensor
 
@@ -37,6 +41,7 @@ class ReplayBuffer:
         stack_size: Optional[int] = None,
         screen_size: Optional[int] = None,
         args: Optional[Config] = None,
+        cpu_affinity: Optional[List[int]] = None,
     ) -> None:
         """!
         Create a replay buffer.
@@ -52,18 +57,46 @@ class ReplayBuffer:
             - n_children: the maximum number of children each node of the priority-tree can have
             - n_steps: the number of steps for which rewards are accumulated in multistep Q-learning
             - gamma: the discount factor
+            - compress_checkpoint: 1 to compress the non-frame sections of the checkpoints, 0 otherwise
+            - dedup_window: the number of recent frames checked for duplicates before encoding a frame, 0 to disable
+            - dictionary_frames: the number of first frames used to train the compression dictionary, 0 to disable
+            - sum_tree_type: the type of sum-tree storing the sums of priorities, 0 for an n-ary tree, 1 for a Fenwick tree
+            - prioritization: 0 for proportional prioritization, 1 for rank-based prioritization where experiences are
+              sampled with a probability proportional to rank^-omega
+            - numa: 1 to spread the frames over the NUMA nodes and decode them with threads pinned to their node,
+              0 otherwise
+            - n_threads: the number of threads decoding the frames, 0 to use as many threads as the batch size, within
+              the number of allowed CPUs
+            - shared_pool: 1 to decode the frames with the thread pool shared by all the buffers of the process, 0 to
+              give the buffer its own thread pool; the buffers sharing the pool must request the same threads
+            - n_channels: the number of channels of the frames, e.g., 3 for RGB frames, which are then stored with shape
+              (channels, height, width) and may be added in channel-last order
+            - frame_height: the height of the frames, 0 to use the screen size
+            - frame_width: the width of the frames, 0 to use the screen size
+        @param cpu_affinity: the CPUs to which the threads decoding the frames are pinned, if None they run on any CPU
         """
 
+        # @var n_new_frames
+        # The number of frames of each next observation added to the buffer, i.e., min(frame_skip, stack_size).
+        frame_skip = relab.config("frame_skip", frame_skip)
+        stack_size = relab.config("stack_size", stack_size)
+        self.n_new_frames = min(frame_skip, stack_size)
+
+        # @var stack_size
+        # The number of stacked frames in each stored observation.
+        self.stack_size = stack_size
+
         # @var buffer
         # The C++ implementation of the replay buffer.
         self.buffer = FastReplayBuffer(
             capacity=capacity,
             batch_size=batch_size,
-            frame_skip=relab.config("frame_skip", frame_skip),
-            stack_size=relab.config("stack_size", stack_size),
+            frame_skip=frame_skip,
+            stack_size=stack_size,
             screen_size=relab.config("screen_size", screen_size),
             type=relab.config("compression_type"),
             args={} if args is None else args,
+            cpu_affinity=[] if cpu_affinity is None else cpu_affinity,
         )
 
     def append(self, experience: Experience) -> None:
@@ -73,9 +106,41 @@ class ReplayBuffer:
         """
         self.buffer.append(experience)
 
-    def sample(self) -> Batch:
+    def append_arrays(self, obs: Any, action: int, reward: float, done: bool, next_obs: Any) -> None:
+        """!
+        Add a new experience to the buffer, without copying the observations and only reading the newest frames of
+        the next observation, which are the only ones the buffer stores.
+        @param obs: the observation at time t, i.e., a tensor, a NumPy array, or a DLPack capsule
+        @param action: the action at time t
+        @param reward: the reward at time t + 1
+        @param done: true if episode ended, false otherwise
+        @param next_obs: the observation at time t + 1, i.e., a tensor, a NumPy array, or a DLPack capsule
+        """
+        self.buffer.append(Experience.from_arrays(obs, action, reward, done, next_obs, self.n_new_frames))
+
+    def begin_episode(self, initial_stack: Any) -> None:
+        """!
+        Begin a new episode, whose experiences are then added one frame at a time by append_step.
+        @param initial_stack: the first observation of the episode, i.e., a tensor, a NumPy array, or a DLPack capsule
+        """
+        self.buffer.begin_episode(initial_stack)
+
+    def append_step(self, frame: Any, action: int, reward: float, done: bool) -> None:
+        """!
+        Add the next experience of the current episode to the buffer, given only the frames it adds to the observation.
+        @param frame: the newest frame of the next observation, or its min(frame_skip, stack_size) newest frames
+        @param action: the action taken
+        @param reward: the reward received
+        @param done: true if the episode ended, in which case a new episode must begin before the next step
+        """
+        self.buffer.append_step(frame, action, reward, done)
+
+    def sample(self, stack_size: Optional[int] = None, stride: int = 1) -> Batch:
         """!
         Sample a batch from the replay buffer.
+        @param stack_size: the number of stacked frames in each observation, if None use the stack size of the buffer
+        @param stride: the distance between two consecutive stacked frames, where (stack_size - 1) * stride must be
+        smaller than the stack size of the buffer
         @return observations, actions, rewards, done, next_observations
         where:
         - observations: the batch of observations
@@ -84,7 +149,9 @@ class ReplayBuffer:
         - done: whether the environment stop after performing the actions
         - next_observations: the observations received after performing the actions
         """
-        return self.buffer.sample()
+        if stack_size is None and stride == 1:
+            return self.buffer.sample()
+        return self.buffer.sample(stack_size=self.stack_size if stack_size is None else stack_size, stride=stride)
 
     def load(self, checkpoint_path: str = "", checkpoint_name: str = "") -> None:
         """!
@@ -114,12 +181,53 @@ class ReplayBuffer:
         """
         return self.buffer.report(loss)
 
+    def report_all(self, loss: Tensor) -> None:
+        """!
+        Report the loss associated with all the transitions in the buffer, e.g., after
+        re-scoring the whole buffer with a new network.
+        @param loss: the loss of all transitions, where the i-th loss is the one of the
+        transition whose index is i
+        """
+        self.buffer.report_all(loss)
+
+    def drain(self, queue: SharedExperienceQueue, max_experiences: int = -1) -> int:
+        """!
+        Move the experiences pushed by an actor process into a shared experience queue
+        to the replay buffer. The experiences must all be pushed by actor 0, since the
+        buffer stores a single stream of episodes.
+        @param queue: the shared experience queue
+        @param max_experiences: the maximum number of experiences to move (-1 for all
+        the experiences in the queue)
+        @return the number of experiences moved
+        """
+        return self.buffer.drain(queue, max_experiences)
+
     def clear(self) -> None:
         """!
         Empty the replay buffer.
         """
         self.buffer.clear()
 
+    def stats(self) -> Dict[str, Dict[str, float]]:
+        """!
+        Retrieve the latency statistics of the replay buffer operations, which are only
+        recorded when the C++ library is compiled with RELAB_INSTRUMENTATION.
+        @return a dictionary whose keys are operation names and values are dictionaries
+        containing the number of calls, as well as the mean, median, 90th percentile,
+        99th percentile and maximum latency in microseconds
+        """
+        return self.buffer.stats()
+
+    def memory_stats(self) -> Dict[str, float]:
+        """!
+        Retrieve the memory used by the replay buffer.
+        @return a dictionary containing the bytes used by the compressed frames, the frame
+        metadata, the references, the data and the priority trees, their total, the number
+        of frames and their uncompressed size, the compression ratio of the frames, and the
+        total number of bytes projected when the buffer is full
+        """
+        return self.buffer.memory_stats()
+
     def __len__(self) -> int:
         """!
         Retrieve the number of elements in the buffer.
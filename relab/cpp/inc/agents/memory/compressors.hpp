@@ -11,6 +11,7 @@
 #include <zlib.h>
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace relab::agents::memory {
@@ -19,8 +20,9 @@ namespace relab::agents::memory {
  * Enumeration of all supported compression types.
  */
 enum class CompressorType {
-  RAW = 0,  // No compression.
-  ZLIB = 1  // Compression using the zlib deflate format.
+  RAW = 0,   // No compression.
+  ZLIB = 1,  // Compression using the zlib deflate format.
+  DELTA = 2  // Compression of the difference with the previous frame using the zlib deflate format.
 };
 
 /**
@@ -37,6 +39,16 @@ class Compressor {
    */
   static std::unique_ptr<Compressor> create(int height, int width, CompressorType type = CompressorType::ZLIB);
 
+  /**
+   * Create the requested compressor.
+   * @param shape the shape of the uncompressed images, i.e., (height, width) or
+   * (channels, height, width) with the channels stored one after the other
+   * @param type the type of compression to use
+   * @return the requested compressor
+   */
+  static std::unique_ptr<Compressor>
+  create(const std::vector<int64_t> &shape, CompressorType type = CompressorType::ZLIB);
+
   /**
    * Ensure the destructor of child classes are called.
    */
@@ -63,6 +75,53 @@ class Compressor {
    */
   virtual void decode(const torch::Tensor &input, float *output) = 0;
 
+  /**
+   * Retrieve the type of the compressor.
+   * @return the type of compression
+   */
+  virtual CompressorType getType() = 0;
+
+  /**
+   * Retrieve the number of frames separating an encoded frame from the
+   * keyframe it depends on, i.e., the number of previous frames that must be
+   * decoded before the frame itself can be decoded.
+   * @param tensor the encoded frame
+   * @return the distance to the keyframe, zero if the frame can be decoded on its own
+   */
+  virtual int keyframeDistance(const torch::Tensor &tensor);
+
+  /**
+   * Reset the state of the compressor, so that the next encoded frame does not
+   * depend on the previously encoded frames.
+   */
+  virtual void reset();
+
+  /**
+   * Train the compressor on sample frames, the frames encoded afterwards
+   * benefit from the structure shared with the samples.
+   * @param frames the uncompressed sample frames
+   */
+  virtual void train(const std::vector<torch::Tensor> &frames);
+
+  /**
+   * Check whether the compressor has been trained.
+   * @return true if the compressor has been trained, false otherwise
+   */
+  virtual bool isTrained();
+
+  /**
+   * Load the compressor's trained state from the checkpoint, checking that the
+   * checkpoint was saved by a compressor of the same type.
+   * @param checkpoint a stream reading from the checkpoint file
+   */
+  virtual void load(std::istream &checkpoint);
+
+  /**
+   * Save the compressor's type and trained state in the checkpoint.
+   * @param checkpoint a stream writing into the checkpoint file
+   */
+  virtual void save(std::ostream &checkpoint);
+
  protected:
   /**
    * Compute the size of the tensor in bytes.
@@ -83,10 +142,9 @@ class NoCompression : public Compressor {
   /**
    * Create an identity compressor, i.e., no compression of the tensors is
    * actually performed.
-   * @param height the height of the uncompressed images
-   * @param width the width of the uncompressed images
+   * @param shape the shape of the uncompressed images
    */
-  NoCompression(int height, int width);
+  explicit NoCompression(const std::vector<int64_t> &shape);
 
   /**
    * Destroy the identity compressor.
@@ -113,31 +171,83 @@ class NoCompression : public Compressor {
    * @param output the buffer in which to decompress the tensor
    */
   void decode(const torch::Tensor &input, float *output);
+
+  /**
+   * Retrieve the type of the compressor.
+   * @return the type of compression, i.e., RAW
+   */
+  CompressorType getType();
+};
+
+/**
+ * @brief A class storing the zlib streams and scratch buffers used by one
+ * thread to compress and decompress images.
+ *
+ * @details
+ * The streams are initialized once and reset before each use, which avoids
+ * allocating the zlib state every time an image is compressed or decompressed.
+ */
+class ZContext {
+ public:
+  // The deflate and inflate zlib streams.
+  z_stream deflate_stream;
+  z_stream inflate_stream;
+
+  // The buffer receiving the compressed image, and a buffer as large as an uncompressed image.
+  std::vector<float> compressed_output;
+  std::vector<uint32_t> scratch;
+
+ public:
+  /**
+   * Create a compression context.
+   */
+  ZContext();
+
+  /**
+   * Destroy the compression context, releasing the zlib streams.
+   */
+  ~ZContext();
+
+  // The zlib streams store pointers to themselves, so a context cannot be copied.
+  ZContext(const ZContext &) = delete;
+  ZContext &operator=(const ZContext &) = delete;
+
+  /**
+   * Grow the buffers of the context, so that they can hold the images of a compressor.
+   * @param uncompressed_size the size of the uncompressed images in bytes
+   * @param max_compressed_size the maximum size of the compressed images in bytes
+   */
+  void reserve(int uncompressed_size, int max_compressed_size);
 };
 
 /**
  * @brief A class using zlib to compress and decompress torch tensors of type
  * float.
+ *
+ * @details
+ * Each thread compressing or decompressing an image uses its own compression
+ * context, so the compressor can be used by several threads at once, e.g., by
+ * the workers of a thread pool, without any locking.
  */
 class ZCompressor : public Compressor {
  private:
-  // The deflate zlib stream.
-  z_stream deflate_stream;
-
   // Precomputed values used to speed up compression.
   int uncompressed_size;
   int n_dims;
   int max_compressed_size;
-  std::vector<float> compressed_output;
   std::vector<int64_t> shape;
 
+  // The preset dictionary shared by all compressed frames, empty if the compressor is not trained, and its maximum
+  // size, i.e., the size of the zlib window.
+  std::vector<char> dictionary;
+  static constexpr int MAX_DICTIONARY_SIZE = 32768;
+
  public:
   /**
    * Create a zlib compressor.
-   * @param height the height of the uncompressed images
-   * @param width the width of the uncompressed images
+   * @param shape the shape of the uncompressed images
    */
-  ZCompressor(int height, int width);
+  explicit ZCompressor(const std::vector<int64_t> &shape);
 
   /**
    * Destroy the compressor.
@@ -164,6 +274,152 @@ class ZCompressor : public Compressor {
    * @param output the buffer in which to decompress the tensor
    */
   void decode(const torch::Tensor &input, float *output);
+
+  /**
+   * Retrieve the type of the compressor.
+   * @return the type of compression, i.e., ZLIB
+   */
+  CompressorType getType();
+
+  /**
+   * Train a zlib preset dictionary containing the per-pixel median of the
+   * sample frames, i.e., the static parts of the screen such as the background
+   * and the score display. Since zlib only uses the last 32 KB of a preset
+   * dictionary, only the median of the last 8192 values of the frames is kept,
+   * e.g., the dictionary covers the whole of an 84x84 frame, but only the last
+   * two thirds of a 3x64x64 frame.
+   * @param frames the uncompressed sample frames
+   */
+  void train(const std::vector<torch::Tensor> &frames);
+
+  /**
+   * Check whether the compressor has a preset dictionary.
+   * @return true if the compressor has been trained, false otherwise
+   */
+  bool isTrained();
+
+  /**
+   * Forget the preset dictionary, so that the compressor is trained again on the next frames.
+   */
+  void reset();
+
+  /**
+   * Load the preset dictionary from the checkpoint, checking that the
+   * checkpoint was saved by a compressor of the same type.
+   * @param checkpoint a stream reading from the checkpoint file
+   */
+  void load(std::istream &checkpoint);
+
+  /**
+   * Save the compressor's type and preset dictionary in the checkpoint.
+   * @param checkpoint a stream writing into the checkpoint file
+   */
+  void save(std::ostream &checkpoint);
+
+ protected:
+  /**
+   * Retrieve the compression context of the calling thread, which is shared by all the compressors used by this thread.
+   * @return the compression context
+   */
+  ZContext &getContext();
+
+  /**
+   * Compress a buffer containing an uncompressed image.
+   * @param context the compression context to use
+   * @param input the buffer to compress
+   * @param header_size the number of bytes to reserve at the beginning of the
+   * compressed tensor, must be a multiple of sizeof(float)
+   * @return the compressed tensor, whose header is left uninitialized
+   */
+  torch::Tensor deflateBuffer(ZContext &context, const void *input, int header_size = 0);
+
+  /**
+   * Decompress a buffer containing a compressed image.
+   * @param context the compression context to use
+   * @param input the buffer to decompress
+   * @param input_size the size of the buffer to decompress in bytes
+   * @param output the buffer in which to decompress the image
+   */
+  void inflateBuffer(ZContext &context, const void *input, int input_size, void *output);
+};
+
+/**
+ * @brief A class using zlib to compress the difference between consecutive
+ * frames.
+ *
+ * @details
+ * Every keyframe_interval frames, a keyframe is compressed on its own. The
+ * frames in between are XORed with the previous frame before compression,
+ * which leaves long runs of zeros for the pixels that did not change. Frames
+ * must therefore be encoded in the order they are stored, and decoding a frame
+ * requires its output buffer to contain the previous decoded frame.
+ */
+class DeltaCompressor : public ZCompressor {
+ private:
+  int keyframe_interval;
+  int n_pixels;
+
+  // The distance between the next frame to encode and its keyframe.
+  int distance;
+
+  // The last encoded frame, and the mutex ensuring frames are encoded one at a time.
+  std::vector<uint32_t> previous_frame;
+  std::mutex encode_mutex;
+
+ public:
+  /**
+   * Create a delta compressor.
+   * @param shape the shape of the uncompressed images
+   * @param keyframe_interval the number of frames between two keyframes
+   */
+  explicit DeltaCompressor(const std::vector<int64_t> &shape, int keyframe_interval = 8);
+
+  /**
+   * Destroy the compressor.
+   */
+  ~DeltaCompressor();
+
+  /**
+   * Compress the tensor passed as parameters.
+   * @param tensor the tensor to compress
+   * @return the compressed tensor
+   */
+  torch::Tensor encode(const torch::Tensor &tensor);
+
+  /**
+   * Decompress the tensor passed as parameters, the tensor must be a keyframe
+   * since the previous frame is not available, otherwise an exception is thrown.
+   * @param tensor the tensor to decompress
+   * @return the decompressed tensor
+   */
+  torch::Tensor decode(const torch::Tensor &tensor);
+
+  /**
+   * Decompress the tensor passed as parameters.
+   * @param input the tensor to decompress
+   * @param output the buffer in which to decompress the tensor, which must
+   * contain the previous frame unless the tensor is a keyframe
+   */
+  void decode(const torch::Tensor &input, float *output);
+
+  /**
+   * Retrieve the type of the compressor.
+   * @return the type of compression, i.e., DELTA
+   */
+  CompressorType getType();
+
+  /**
+   * Retrieve the number of frames separating an encoded frame from its keyframe.
+   * @param tensor the encoded frame
+   * @return the distance to the keyframe
+   */
+  int keyframeDistance(const torch::Tensor &tensor);
+
+  /**
+   * Reset the state of the compressor, so that the next encoded frame is a keyframe and the preset dictionary is
+   * trained again.
+   */
+  void reset();
 };
 }  // namespace relab::agents::memory
 
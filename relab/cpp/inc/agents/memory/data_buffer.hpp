@@ -7,17 +7,20 @@
 #ifndef RELAB_CPP_INC_AGENTS_MEMORY_DATA_BUFFER_HPP_
 #define RELAB_CPP_INC_AGENTS_MEMORY_DATA_BUFFER_HPP_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <tuple>
 
 #include "agents/memory/experience.hpp"
 #include "agents/memory/priority_tree.hpp"
-#include "helpers/deque.hpp"
+#include "helpers/ring_buffer.hpp"
+#include "helpers/serialize.hpp"
 
 namespace relab::agents::memory::impl {
 
-using relab::helpers::Deque;
+using relab::helpers::CHECKPOINT_VERSION;
+using relab::helpers::RingBuffer;
 
 /**
  * @brief A buffer allowing for storage and retrieval of experience actions,
@@ -31,9 +34,9 @@ class DataBuffer {
   float gamma;
 
   // Queues keeping track of past actions, cumulated rewards, and dones.
-  Deque<int> past_actions;
-  Deque<float> past_rewards;
-  Deque<bool> past_dones;
+  RingBuffer<int> past_actions;
+  RingBuffer<float> past_rewards;
+  RingBuffer<bool> past_dones;
 
   // Torch tensors storing all the buffer's data.
   torch::Device device;
@@ -56,8 +59,15 @@ class DataBuffer {
    * @param gamma the discount factor
    * @param initial_priority the initial priority given to first elements
    * @param n_children the number of children each node has
+   * @param sum_tree_type the type of sum-tree used by the priority tree
+   * @param prioritization the prioritization scheme used by the priority tree
+   * @param omega the prioritization exponent
    */
-  DataBuffer(int capacity, int n_steps, float gamma, float initial_priority, int n_children);
+  DataBuffer(
+      int capacity, int n_steps, float gamma, float initial_priority, int n_children,
+      SumTreeType sum_tree_type = SumTreeType::N_ARY,
+      PrioritizationType prioritization = PrioritizationType::PROPORTIONAL, float omega = 1.0
+  );
 
   /**
    * Add the datum of the next experience to the buffer.
@@ -80,11 +90,23 @@ class DataBuffer {
    */
   int size();
 
+  /**
+   * Retrieve the number of experiences removed from the buffer to make room for new ones.
+   * @return the number of removed experiences
+   */
+  int nEvicted();
+
   /**
    * Empty the data buffer.
    */
   void clear();
 
+  /**
+   * End the current episode without storing the experiences whose multistep
+   * returns are not complete yet.
+   */
+  void endEpisode();
+
   /**
    * Add a datum to the buffer.
    * @param action the action at time t
@@ -102,14 +124,24 @@ class DataBuffer {
   /**
    * Load the data buffer from the checkpoint.
    * @param checkpoint a stream reading from the checkpoint file
+   * @param compressed true if the checkpoint is compressed, false otherwise
+   * @param version the version of the checkpoint format
    */
-  void load(std::istream &checkpoint);
+  void load(std::istream &checkpoint, bool compressed = false, int version = CHECKPOINT_VERSION);
 
   /**
    * Save the data buffer in the checkpoint.
    * @param checkpoint a stream writing into the checkpoint file
+   * @param compressed true if the checkpoint must be compressed, false otherwise
+   */
+  void save(std::ostream &checkpoint, bool compressed = false);
+
+  /**
+   * Compute the number of bytes used by the data buffer.
+   * @return a map containing the bytes used by the actions, rewards and dones
+   * ("data"), as well as by the priority trees ("priority_trees")
    */
-  void save(std::ostream &checkpoint);
+  std::map<std::string, double> memoryStats();
 
   /**
    * Print the data buffer on the standard output.
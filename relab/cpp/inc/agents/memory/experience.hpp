@@ -40,7 +40,8 @@ class Experience {
   bool done;
 
   /// @var next_obs
-  /// The observation tensor at time t + 1.
+  /// The observation tensor at time t + 1, which may only contain the newest
+  /// frames of the observation, see Experience::fromNewestFrames.
   Tensor next_obs;
 
  public:
@@ -53,6 +54,20 @@ class Experience {
    * @param next_obs the observation at time t + 1
    */
   Experience(Tensor obs, int action, float reward, bool done, Tensor next_obs);
+
+  /**
+   * Create an experience keeping only the newest frames of the observation at
+   * time t + 1, which are the only ones read by the frame buffer since the
+   * older ones were added with the previous experience. No frame is copied.
+   * @param obs the observation at time t
+   * @param action the action at time t
+   * @param reward the reward at time t + 1
+   * @param done true if episode ended, false otherwise
+   * @param next_obs the observation at time t + 1
+   * @param n_frames the number of newest frames to keep, i.e., min(frame_skip, stack_size)
+   * @return the experience
+   */
+  static Experience fromNewestFrames(Tensor obs, int action, float reward, bool done, Tensor next_obs, int n_frames);
 };
 }  // namespace relab::agents::memory::impl
 
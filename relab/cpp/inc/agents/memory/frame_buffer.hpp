@@ -7,6 +7,7 @@
 #ifndef RELAB_CPP_INC_AGENTS_MEMORY_FRAME_BUFFER_HPP_
 #define RELAB_CPP_INC_AGENTS_MEMORY_FRAME_BUFFER_HPP_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -15,12 +16,14 @@
 #include "agents/memory/compressors.hpp"
 #include "agents/memory/experience.hpp"
 #include "agents/memory/frame_storage.hpp"
-#include "helpers/deque.hpp"
+#include "helpers/ring_buffer.hpp"
+#include "helpers/serialize.hpp"
 #include "helpers/thread_pool.hpp"
 
 namespace relab::agents::memory::impl {
 
-using relab::helpers::Deque;
+using relab::helpers::CHECKPOINT_VERSION;
+using relab::helpers::RingBuffer;
 using relab::helpers::ThreadPool;
 
 /**
@@ -36,7 +39,10 @@ class FrameBuffer {
   int stack_size;
   int capacity;
   int n_steps;
-  int screen_size;
+
+  // The shape of the frames, i.e., (height, width) or (channels, height, width), and their number of pixels.
+  std::vector<int64_t> frame_shape;
+  int frame_size;
 
   // A frame storage containing all the buffer's frames.
   FrameStorage frames;
@@ -47,7 +53,7 @@ class FrameBuffer {
   int current_ref;
 
   // Queue storing recent observations references (for multistep Q-learning).
-  Deque<int> past_references;
+  RingBuffer<int> past_references;
 
   // Boolean tracking whether the next experience starts a new episode.
   bool new_episode;
@@ -55,8 +61,26 @@ class FrameBuffer {
   // A compressor to encode and decode the stored frames.
   std::unique_ptr<Compressor> png;
 
-  // A thread pool to parallelize the decompression.
-  ThreadPool pool;
+  // A thread pool to parallelize the decompression, which may be shared with other buffers.
+  std::shared_ptr<ThreadPool> pool;
+
+  // The NUMA node on which the frames of the current episode are preferably allocated, when the thread pool is
+  // NUMA-aware.
+  int arena_node;
+
+  // The number of recently stored frames checked for duplicates (zero disables deduplication), as well as the
+  // content hashes, uncompressed pixels and encodings of these frames. The pixels are compared whenever the hashes
+  // match, so that a hash collision never stores the wrong frame. Deduplication is disabled for delta compression,
+  // since the encoding of a frame depends on its position in the storage.
+  int dedup_window;
+  std::vector<uint64_t> recent_hashes;
+  std::vector<torch::Tensor> recent_raw_frames;
+  std::vector<torch::Tensor> recent_frames;
+  int recent_index;
+
+  // The number of frames used to train the compressor (zero disables training), and the frames collected so far.
+  int dictionary_frames;
+  std::vector<torch::Tensor> dictionary_samples;
 
  public:
   /**
@@ -71,10 +95,52 @@ class FrameBuffer {
    * @param type the type of compression to use
    * @param n_threads the number of threads to use for speeding up the
    * decompression of tensors
+   * @param dedup_window the number of recently stored frames whose encoding is
+   * reused when an identical frame is added, zero to disable deduplication
+   * @param dictionary_frames the number of first frames used to train the
+   * compressor's dictionary, zero to disable training
+   * @param numa true to spread the frames of successive episodes over the
+   * NUMA nodes, and decode each frame with the threads of the node storing it
+   * @param cpus the CPUs to which the decompression threads are pinned, or an
+   * empty vector to let them run on any CPU
+   * @param shared_pool true to use the thread pool shared by all the buffers of
+   * the process, false to create a thread pool for this buffer
    */
   FrameBuffer(
       int capacity, int frame_skip, int n_steps, int stack_size, int screen_size = 84,
-      CompressorType type = CompressorType::ZLIB, int n_threads = 1
+      CompressorType type = CompressorType::ZLIB, int n_threads = 1, int dedup_window = 0, int dictionary_frames = 0,
+      bool numa = false, const std::vector<int> &cpus = {}, bool shared_pool = false
+  );
+
+  /**
+   * Create a frame buffer storing frames of any shape.
+   * @param capacity the number of experiences the buffer can store
+   * @param frame_skip the number of times each action is repeated in the
+   * environment
+   * @param n_steps the number of steps for which rewards are accumulated in
+   * multistep Q-learning
+   * @param stack_size the number of stacked frame in each observation
+   * @param frame_shape the shape of the frames, i.e., (height, width) for
+   * single-channel frames or (channels, height, width) for multi-channel frames,
+   * which may also be added in channel-last order, i.e., (height, width, channels)
+   * @param type the type of compression to use
+   * @param n_threads the number of threads to use for speeding up the
+   * decompression of tensors
+   * @param dedup_window the number of recently stored frames whose encoding is
+   * reused when an identical frame is added, zero to disable deduplication
+   * @param dictionary_frames the number of first frames used to train the
+   * compressor's dictionary, zero to disable training
+   * @param numa true to spread the frames of successive episodes over the
+   * NUMA nodes, and decode each frame with the threads of the node storing it
+   * @param cpus the CPUs to which the decompression threads are pinned, or an
+   * empty vector to let them run on any CPU
+   * @param shared_pool true to use the thread pool shared by all the buffers of
+   * the process, false to create a thread pool for this buffer
+   */
+  FrameBuffer(
+      int capacity, int frame_skip, int n_steps, int stack_size, const std::vector<int64_t> &frame_shape,
+      CompressorType type = CompressorType::ZLIB, int n_threads = 1, int dedup_window = 0, int dictionary_frames = 0,
+      bool numa = false, const std::vector<int> &cpus = {}, bool shared_pool = false
   );
 
   /**
@@ -92,12 +158,74 @@ class FrameBuffer {
    */
   std::tuple<torch::Tensor, torch::Tensor> operator[](const torch::Tensor &indices);
 
+  /**
+   * Retrieve the observations of the experience whose index is passed as
+   * parameters, stacking fewer frames than stored or every stride-th frame.
+   * The stacks end with the newest frame of the stored observations, and must
+   * fit within them, i.e., (n_frames - 1) * stride < stack_size.
+   * @param indices the indices of the experiences whose observations must be
+   * retrieved
+   * @param n_frames the number of stacked frames in each observation
+   * @param stride the distance between two consecutive stacked frames
+   * @return the observations at time t and t + n_steps
+   */
+  std::tuple<torch::Tensor, torch::Tensor> getObservations(const torch::Tensor &indices, int n_frames, int stride = 1);
+
+  /**
+   * Decode the frames of an observation.
+   * @param reference the unique index of the observation's first frame
+   * @param output the buffer in which the observation's frames must be decoded
+   */
+  void decodeObservation(int reference, float *output);
+
+  /**
+   * Decode some of the frames of an observation, i.e., every stride-th frame
+   * ending with the observation's newest frame.
+   * @param reference the unique index of the observation's first frame
+   * @param output the buffer in which the stacked frames must be decoded
+   * @param n_frames the number of frames to decode
+   * @param stride the distance between two consecutive decoded frames
+   */
+  void decodeObservation(int reference, float *output, int n_frames, int stride);
+
   /**
    * Retrieve the number of experiences stored in the buffer.
    * @return the number of experiences stored in the buffer
    */
   int size();
 
+  /**
+   * Retrieve an encoded frame, whose tensor is shared with the identical
+   * frames when deduplication is enabled.
+   * @param index the unique index of the frame
+   * @return the encoded frame
+   */
+  torch::Tensor getEncodedFrame(int index);
+
+  /**
+   * Retrieve the shape of the frames stored in the buffer.
+   * @return the shape of the frames, i.e., (height, width) or (channels, height, width)
+   */
+  const std::vector<int64_t> &getFrameShape();
+
+  /**
+   * Retrieve the thread pool decompressing the frames, which the owner of the buffer may use for other parallel work.
+   * @return the thread pool
+   */
+  std::shared_ptr<ThreadPool> getThreadPool();
+
+  /**
+   * Check whether the next experience added to the buffer begins a new episode.
+   * @return true if the next experience begins a new episode, false otherwise
+   */
+  bool getNewEpisode();
+
+  /**
+   * End the current episode without storing the experiences whose multistep
+   * observations are not complete yet, so that the next experience begins a new episode.
+   */
+  void endEpisode();
+
   /**
    * Empty the frame buffer.
    */
@@ -110,6 +238,30 @@ class FrameBuffer {
    */
   int addFrame(const torch::Tensor &frame);
 
+  /**
+   * Copy a frame in the layout used to store the frames, i.e., with its
+   * channels one after the other. Channel-last frames, such as (height, width,
+   * channels) RGB images, are transposed to (channels, height, width).
+   * @param frame the frame to copy
+   * @return the copy of the frame
+   */
+  torch::Tensor planarFrame(const torch::Tensor &frame);
+
+  /**
+   * Encode a frame and add it to the buffer. If the frame is identical to one
+   * of the recently stored frames, the encoding of the recent frame is shared
+   * instead of encoding the frame again. The first frames are also collected
+   * to train the compressor.
+   * @param frame the uncompressed frame
+   * @return the unique index of the frame
+   */
+  int addRawFrame(const torch::Tensor &frame);
+
+  /**
+   * Empty the window of recently stored frames used for deduplication.
+   */
+  void clearRecentFrames();
+
   /**
    * Add an observation references to the buffer.
    * @param t the index of the first reference in the queue of past references
@@ -131,7 +283,8 @@ class FrameBuffer {
   torch::Tensor encode(const torch::Tensor &frame);
 
   /**
-   * Decode a frame to decompress it.
+   * Decode a frame to decompress it. With delta compression, the frame must be
+   * a keyframe, otherwise an exception is thrown.
    * @param frame the encoded frame to decode
    * @return the decoded frame
    */
@@ -140,14 +293,30 @@ class FrameBuffer {
   /**
    * Load the frame buffer from the checkpoint.
    * @param checkpoint a stream reading from the checkpoint file
+   * @param compressed true if the checkpoint is compressed, false otherwise
+   * @param version the version of the checkpoint format
    */
-  void load(std::istream &checkpoint);
+  void load(std::istream &checkpoint, bool compressed = false, int version = CHECKPOINT_VERSION);
 
   /**
    * Save the frame buffer in the checkpoint.
    * @param checkpoint a stream writing into the checkpoint file
+   * @param compressed true if the checkpoint must be compressed, false otherwise
+   */
+  void save(std::ostream &checkpoint, bool compressed = false);
+
+  /**
+   * Compute the number of bytes used by the frame buffer. Frames shared by
+   * several storage slots, e.g., deduplicated frames, are only counted once.
+   * @return a map containing the bytes used by the compressed frames
+   * ("compressed_frames"), by the tensor and storage headers of the frames
+   * ("frame_metadata"), by the tensor handles of the storage slots, which are
+   * reserved upfront ("frame_handles"), and by the observation references
+   * ("references"), as
+   * well as the number of stored frames ("n_frames") and their size before
+   * compression in bytes ("uncompressed_frames")
    */
-  void save(std::ostream &checkpoint);
+  std::map<std::string, double> memoryStats();
 
   /**
    * Print the frame buffer on the standard output.
@@ -12,6 +12,8 @@
 #include <string>
 #include <vector>
 
+#include "helpers/serialize.hpp"
+
 namespace relab::agents::memory {
 
 /**
@@ -35,6 +37,10 @@ class FrameStorage {
   /// The vector storing all frames.
   std::vector<torch::Tensor> frames;
 
+  /// @var nodes
+  /// The NUMA node storing each frame, or -1 if it is unknown.
+  std::vector<int> nodes;
+
   /// @var first_frame_index
   /// The unique index of the first frame in storage (may exceed capacity).
   int first_frame_index;
@@ -63,9 +69,10 @@ class FrameStorage {
   /**
    * Add a frame to the storage.
    * @param frame the frame to add
+   * @param node the NUMA node storing the frame, or -1 if it is unknown
    * @return the unique index of the frame that was added to the buffer
    */
-  int append(const torch::Tensor &frame);
+  int append(const torch::Tensor &frame, int node = -1);
 
   /**
    * Resize the vector of frames, i.e., increasing its size by
@@ -103,13 +110,24 @@ class FrameStorage {
   torch::Tensor operator[](int index);
 
   /**
-   * Load the frame storage from the checkpoint.
+   * Retrieve the NUMA node storing a frame.
+   * @param index the unique index of the frame
+   * @return the node index, or -1 if it is unknown
+   */
+  int node(int index);
+
+  /**
+   * Load the frame storage from the checkpoint, the nodes storing the frames
+   * being unknown afterwards.
    * @param checkpoint a stream reading from the checkpoint file
+   * @param version the version of the checkpoint format
    */
-  void load(std::istream &checkpoint);
+  void load(std::istream &checkpoint, int version = relab::helpers::CHECKPOINT_VERSION);
 
   /**
-   * Save the frame storage in the checkpoint.
+   * Save the frame storage in the checkpoint. A frame whose encoding is shared
+   * with a previous frame, e.g., a deduplicated frame, is saved as a reference
+   * to this previous frame, so the encoding is still shared after loading.
    * @param checkpoint a stream writing into the checkpoint file
    */
   void save(std::ostream &checkpoint);
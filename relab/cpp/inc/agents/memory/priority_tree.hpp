@@ -9,47 +9,129 @@
 
 #include <torch/extension.h>
 
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "helpers/serialize.hpp"
+#include "helpers/thread_pool.hpp"
+
+namespace relab::agents::memory {
+
+/**
+ * Enumeration of all supported sum-tree types.
+ */
+enum class SumTreeType {
+  N_ARY = 0,   // A tree whose nodes have n_children children, with one array per level.
+  FENWICK = 1  // A binary indexed tree stored in a single array.
+};
+
+/**
+ * Enumeration of all supported prioritization schemes.
+ */
+enum class PrioritizationType {
+  PROPORTIONAL = 0,  // Experiences are sampled with a probability proportional to their priorities.
+  RANK = 1           // Experiences are sampled with a probability proportional to rank^-omega, where rank is the
+                     // position of their priorities in decreasing order.
+};
+}  // namespace relab::agents::memory
+
 namespace relab::agents::memory::impl {
 
+using relab::helpers::CHECKPOINT_VERSION;
+using relab::helpers::ThreadPool;
+
 // Alias for a sum-tree.
 using SumTree = std::vector<std::vector<double>>;
 
+// Alias for a Fenwick tree, i.e., a sum-tree whose i-th element stores the sum of the (i & -i) priorities ending at i.
+using FenwickTree = std::vector<double>;
+
 // Alias for a max-tree.
 using MaxTree = std::vector<torch::Tensor>;
 
+// Alias for a min-tree.
+using MinTree = std::vector<std::vector<float>>;
+
+// Alias for a rank tree, i.e., a balanced tree of (negated priority, internal index) pairs, which retrieves the
+// element of a given rank and the rank of a given element in logarithmic time.
+using RankTree = __gnu_pbds::tree<
+    std::pair<float, int>, __gnu_pbds::null_type, std::less<std::pair<float, int>>, __gnu_pbds::rb_tree_tag,
+    __gnu_pbds::tree_order_statistics_node_update>;
+
 /**
  * @brief A class storing the experience priorities.
  */
 class PriorityTree {
+ public:
+  // The number of nodes recomputed from scratch each time a priority is added or replaced.
+  static constexpr int N_REFRESHED_NODES = 1;
+
+  // The smallest priority used to compute the importance sampling weights, which prevents divisions by zero.
+  static constexpr float MIN_WEIGHTED_PRIORITY = 1e-8;
+
  private:
   // Store the priority tree parameters.
   float initial_priority;
   int capacity;
   int n_children;
+  SumTreeType sum_tree_type;
 
   // The trees' depth, and the current index.
   int depth;
   int current_id;
 
-  // Boolean keeping track of whether the sum-tree needs to be refreshed
-  bool need_refresh_all;
+  // The index of the next node of the sum-tree's bottom level (or of the Fenwick tree) recomputed from scratch.
+  int refresh_index;
 
   // Create a tensor of priorities, an empty sum-tree and an empty max-tree.
   torch::Tensor priorities;
   SumTree sum_tree;
   MaxTree max_tree;
 
+  // The min-tree, whose nodes only account for the priorities stored in the tree.
+  MinTree min_tree;
+
+  // The Fenwick tree replacing the sum-tree, and the largest power of two smaller than or equal to the capacity.
+  FenwickTree fenwick_tree;
+  int fenwick_mask;
+
+  // The prioritization scheme, the prioritization exponent used by rank-based prioritization, the rank tree, and the
+  // cumulative sums of rank^-omega for all ranks.
+  PrioritizationType prioritization;
+  float omega;
+  RankTree rank_tree;
+  std::vector<double> rank_cdf;
+
+  // The thread pool rebuilding all the trees at once, which has no threads unless the owner of the tree shares its
+  // own pool, so that the trees are then rebuilt on the calling thread.
+  std::shared_ptr<ThreadPool> pool;
+
  public:
   /**
    * Create a priority tree.
    * @param capacity the tree's capacity
    * @param initial_priority the initial priority given to first elements
    * @param n_children the number of children each node has
+   * @param sum_tree_type the type of sum-tree used to store the sums of priorities
+   * @param prioritization the prioritization scheme used to sample indices
+   * @param omega the prioritization exponent, only used by rank-based prioritization
    */
-  PriorityTree(int capacity, float initial_priority, int n_children);
+  PriorityTree(
+      int capacity, float initial_priority, int n_children, SumTreeType sum_tree_type = SumTreeType::N_ARY,
+      PrioritizationType prioritization = PrioritizationType::PROPORTIONAL, float omega = 1.0
+  );
+
+  /**
+   * Compute the mask from which the Fenwick tree is descended.
+   * @param capacity the number of elements in the tree
+   * @return the largest power of two smaller than or equal to the capacity
+   */
+  static int fenwickMask(int capacity);
 
   /**
    * Create a sum-tree.
@@ -71,6 +153,14 @@ class PriorityTree {
    */
   static MaxTree createMaxTree(int depth, int n_children);
 
+  /**
+   * Create a min-tree whose nodes are all equal to infinity.
+   * @param depth the tree's depth
+   * @param n_children the number of children each node has
+   * @return the tree
+   */
+  static MinTree createMinTree(int depth, int n_children);
+
   /**
    * Compute the sum of all priorities.
    * @return the sum of all priorities
@@ -83,6 +173,21 @@ class PriorityTree {
    */
   float max();
 
+  /**
+   * Find the smallest priority.
+   * @return the smallest priority
+   */
+  float min();
+
+  /**
+   * Compute the importance sampling weights of sampled elements, normalized by the largest weight of all the
+   * elements in the tree, i.e., the weight of the least likely element.
+   * @param indices the indices of the sampled elements
+   * @param omega_is the importance sampling exponent
+   * @return the importance sampling weights
+   */
+  torch::Tensor importanceWeights(const torch::Tensor &indices, float omega_is);
+
   /**
    * Empty the priority tree.
    */
@@ -130,6 +235,7 @@ class PriorityTree {
 
   /**
    * Sample indices of buffer elements proportionally to their priorities.
+   * @throw std::runtime_error if the tree is empty
    * @param n the number of indices to sample
    * @return the sampled indices
    */
@@ -143,6 +249,35 @@ class PriorityTree {
    */
   int towerSampling(float priority);
 
+  /**
+   * Sample indices of buffer elements with a probability proportional to rank^-omega, by splitting the ranks into
+   * 'n' segments of equal probability and sampling one rank in each segment.
+   * @param n the number of indices to sample
+   * @return the sampled indices
+   */
+  torch::Tensor sampleIndicesByRank(int n);
+
+  /**
+   * Update the rank tree to reflect an element being set to a new priority.
+   * @param index the internal index of the element
+   * @param old_priority the old priority
+   * @param stored true if the element was stored in the tree before being set, false otherwise
+   */
+  void updateRankTree(int index, float old_priority, bool stored);
+
+  /**
+   * Refresh the entire rank tree.
+   */
+  void refreshAllRankTree();
+
+  /**
+   * Compute the internal index associated to the sampled priority by
+   * descending the Fenwick tree.
+   * @param priority the sampled priority, which must not exceed the sum of priorities
+   * @return the internal index
+   */
+  int fenwickSearch(double priority);
+
   /**
    * Compute the index of the parent element.
    * @param idx the index of the element whose parent index must be computed
@@ -157,10 +292,47 @@ class PriorityTree {
    */
   void updateSumTree(int index, float old_priority);
 
+  /**
+   * Recompute the next few nodes of the sum-tree (or Fenwick tree) from scratch. Successive calls sweep over all the
+   * nodes, which bounds the rounding errors accumulated by incremental updates without ever rebuilding the entire
+   * tree at once.
+   */
+  void refreshSumTreeIncrementally();
+
+  /**
+   * Set the thread pool rebuilding all the trees at once, e.g., the pool of the replay buffer.
+   * @param pool the thread pool among which the nodes of each level are split
+   */
+  void setThreadPool(std::shared_ptr<ThreadPool> pool);
+
+  /**
+   * Replace the priorities of all the elements stored in the tree, and rebuild all the trees from them.
+   * @param priorities the new priorities, where the i-th priority is the one of the experience whose index is i
+   */
+  void assignAll(const torch::Tensor &priorities);
+
+  /**
+   * Rebuild all the trees from the priorities with the thread pool of the tree, one level at a time from the bottom up.
+   */
+  void refreshAll();
+
   /**
    * Refresh the entire sum-tree.
+   * @param pool the thread pool among which the nodes of each level are split
+   */
+  void refreshAllSumTree(ThreadPool &pool);
+
+  /**
+   * Refresh the entire Fenwick tree in linear time.
+   * @param pool the thread pool among which the nodes are split
    */
-  void refreshAllSumTree();
+  void refreshAllFenwickTree(ThreadPool &pool);
+
+  /**
+   * Refresh the entire max-tree.
+   * @param pool the thread pool among which the nodes of each level are split
+   */
+  void refreshAllMaxTree(ThreadPool &pool);
 
   /**
    * Update the max-tree to reflect an element being set to a new priority.
@@ -181,6 +353,26 @@ class PriorityTree {
    */
   float maxChildValue(int depth, int parent_index, int index, float old_priority, float new_priority);
 
+  /**
+   * Refresh the entire min-tree.
+   * @param pool the thread pool among which the nodes of each level are split
+   */
+  void refreshAllMinTree(ThreadPool &pool);
+
+  /**
+   * Update the min-tree to reflect an element being set to a new priority.
+   * @param index the internal index of the element
+   */
+  void updateMinTree(int index);
+
+  /**
+   * Compute the minimum value among the child nodes, ignoring the elements not stored in the tree.
+   * @param depth the depth of the parent node
+   * @param parent_index the internal index of the parent node
+   * @return the minimum value
+   */
+  float minChildValue(int depth, int parent_index);
+
   /**
    * Create a string representation of the max-tree.
    * @param max_n_elements the maximum number of elements to display, by default
@@ -197,6 +389,14 @@ class PriorityTree {
    */
   std::string sumTreeToStr(int max_n_elements = -1);
 
+  /**
+   * Create a string representation of the min-tree.
+   * @param max_n_elements the maximum number of elements to display, by default
+   * all elements are displayed
+   * @return a string representing the tree
+   */
+  std::string minTreeToStr(int max_n_elements = -1);
+
   /**
    * Create a string representation of a tree.
    * @param tree the tree to convert into a string
@@ -214,14 +414,24 @@ class PriorityTree {
   /**
    * Load the priority tree from the checkpoint.
    * @param checkpoint a stream reading from the checkpoint file
+   * @param compressed true if the checkpoint is compressed, false otherwise
+   * @param version the version of the checkpoint format
    */
-  void load(std::istream &checkpoint);
+  void load(std::istream &checkpoint, bool compressed = false, int version = CHECKPOINT_VERSION);
 
   /**
    * Save the priority tree in the checkpoint.
    * @param checkpoint a stream writing into the checkpoint file
+   * @param compressed true if the checkpoint must be compressed, false otherwise, compressed checkpoints do not
+   * contain the sum-tree, max-tree and min-tree, which are rebuilt from the priorities when loading
+   */
+  void save(std::ostream &checkpoint, bool compressed = false);
+
+  /**
+   * Compute the number of bytes used by the priorities and all the trees.
+   * @return the number of bytes
    */
-  void save(std::ostream &checkpoint);
+  int64_t memoryUsage();
 
   /**
    * Print the priority tree on the standard output.
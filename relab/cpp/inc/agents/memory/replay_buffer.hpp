@@ -13,11 +13,13 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "agents/memory/compressors.hpp"
 #include "agents/memory/data_buffer.hpp"
 #include "agents/memory/experience.hpp"
 #include "agents/memory/frame_buffer.hpp"
+#include "agents/memory/shared_experience_queue.hpp"
 
 namespace relab::agents::memory {
 
@@ -44,6 +46,10 @@ class ReplayBuffer {
   int n_children;
   float omega;
   float omega_is;
+  int n_threads;
+
+  // Keep in mind whether the checkpoints must be compressed.
+  bool compress_checkpoint;
 
   // The device on which computation is performed.
   torch::Device device;
@@ -58,6 +64,9 @@ class ReplayBuffer {
   // The indices of the last sampled experiences.
   torch::Tensor indices;
 
+  // The first observation of the current episode, when experiences are added one frame at a time.
+  torch::Tensor initial_stack;
+
  public:
   /**
    * Create a replay buffer.
@@ -76,10 +85,29 @@ class ReplayBuffer {
    *     - n_children: the maximum number of children each node of the priority-tree can have
    *     - n_steps: the number of steps for which rewards are accumulated in multistep Q-learning
    *     - gamma: the discount factor
+   *     - compress_checkpoint: 1 to compress the non-frame sections of the checkpoints, 0 otherwise
+   *     - dedup_window: the number of recent frames checked for duplicates before encoding a frame, 0 to disable
+   *     - dictionary_frames: the number of first frames used to train the compression dictionary, 0 to disable
+   *     - sum_tree_type: the type of sum-tree storing the sums of priorities, 0 for an n-ary tree, 1 for a Fenwick tree
+   *     - prioritization: 0 for proportional prioritization, 1 for rank-based prioritization where experiences are
+   *       sampled with a probability proportional to rank^-omega
+   *     - numa: 1 to spread the frames over the NUMA nodes and decode them with threads pinned to their node, 0
+   *       otherwise
+   *     - n_threads: the number of threads decoding the frames, 0 to use as many threads as the batch size, within
+   *       the number of allowed CPUs, or one thread per allowed CPU when the pool is shared
+   *     - shared_pool: 1 to decode the frames with the thread pool shared by all the buffers of the process, 0 to give
+   *       the buffer its own thread pool; buffers sharing the pool must request the same number of threads
+   *     - n_channels: the number of channels of the frames, e.g., 3 for RGB frames, which are then stored with shape
+   *       (channels, height, width) and may be added in channel-last order
+   *     - frame_height: the height of the frames, 0 to use the screen size
+   *     - frame_width: the width of the frames, 0 to use the screen size
+   * @param cpu_affinity the CPUs to which the threads decoding the frames are pinned, or an empty vector to let them
+   * run on any CPU
    */
   ReplayBuffer(
       int capacity = 10000, int batch_size = 32, int frame_skip = 1, int stack_size = 4, int screen_size = 84,
-      CompressorType type = CompressorType::ZLIB, std::map<std::string, float> args = {}
+      CompressorType type = CompressorType::ZLIB, std::map<std::string, float> args = {},
+      const std::vector<int> &cpu_affinity = {}
   );
 
   /**
@@ -88,6 +116,23 @@ class ReplayBuffer {
    */
   void append(const Experience &experience);
 
+  /**
+   * Begin a new episode, whose experiences are then added one frame at a time
+   * by appendStep. The previous episode must have ended.
+   * @param initial_stack the first observation of the episode, i.e., its stack_size frames
+   */
+  void beginEpisode(const torch::Tensor &initial_stack);
+
+  /**
+   * Add the next experience of the current episode to the buffer, given only
+   * the frames it adds to the observation.
+   * @param frame the newest frame of the next observation, or its min(frame_skip, stack_size) newest frames
+   * @param action the action taken
+   * @param reward the reward received
+   * @param done true if the episode ended, in which case a new episode must begin before the next step
+   */
+  void appendStep(const torch::Tensor &frame, int action, float reward, bool done);
+
   /**
    * Sample a batch from the replay buffer.
    * @return (observations, actions, rewards, done, next_observations) where:
@@ -100,6 +145,17 @@ class ReplayBuffer {
    */
   Batch sample();
 
+  /**
+   * Sample a batch from the replay buffer, whose observations stack fewer
+   * frames than stored or every stride-th frame, allowing agents with
+   * different history lengths to learn from the same buffer.
+   * @param stack_size the number of stacked frames in each observation
+   * @param stride the distance between two consecutive stacked frames, where
+   * (stack_size - 1) * stride must be smaller than the stack size of the buffer
+   * @return (observations, actions, rewards, done, next_observations), as returned by sample()
+   */
+  Batch sample(int stack_size, int stride = 1);
+
   /**
    * Report the loss associated with all the transitions of the previous batch.
    * @param loss the loss of all previous transitions
@@ -107,6 +163,32 @@ class ReplayBuffer {
    */
   torch::Tensor report(torch::Tensor &loss);
 
+  /**
+   * Report the loss associated with the transitions of a batch sampled earlier, e.g., when several batches are
+   * sampled before their losses are reported.
+   * @param loss the loss of the transitions
+   * @param indices the indices of the transitions
+   * @return the new loss
+   */
+  torch::Tensor report(torch::Tensor &loss, const torch::Tensor &indices);
+
+  /**
+   * Report the loss associated with all the transitions in the buffer, e.g., after re-scoring the whole buffer with
+   * a new network. All the priorities are replaced at once, and the priority tree is rebuilt in parallel.
+   * @param loss the loss of all transitions, where the i-th loss is the one of the transition whose index is i
+   */
+  void reportAll(torch::Tensor &loss);
+
+  /**
+   * Move the experiences pushed by an actor process into a shared experience queue to the replay buffer. The
+   * experiences must all be pushed by actor 0, since the buffer stores a single stream of episodes; use the sharded
+   * replay buffer to drain the experiences of several actors.
+   * @param queue the shared experience queue
+   * @param max_experiences the maximum number of experiences to move (-1 for all the experiences in the queue)
+   * @return the number of experiences moved
+   */
+  int drain(SharedExperienceQueue &queue, int max_experiences = -1);
+
   /**
    * Load a replay buffer from the filesystem.
    * @param checkpoint_path: the full checkpoint path from which the agent has
@@ -165,17 +247,40 @@ class ReplayBuffer {
    */
   Batch getExperiences(torch::Tensor &indices);
 
+  /**
+   * Retrieve the experiences whose indices are passed as parameters, stacking
+   * every stride-th frame of their observations.
+   * @param indices the experience indices
+   * @param stack_size the number of stacked frames in each observation
+   * @param stride the distance between two consecutive stacked frames
+   * @return the experiences
+   */
+  Batch getExperiences(torch::Tensor &indices, int stack_size, int stride = 1);
+
   /**
    * Retrieve the number of elements in the buffer.
    * @return the number of elements contained in the replay buffer
    */
   int size();
 
+  /**
+   * Retrieve the number of experiences removed from the buffer to make room for new ones. Adding this number to the
+   * index of an experience gives an index that does not change when new experiences are added.
+   * @return the number of removed experiences
+   */
+  int nEvicted();
+
   /**
    * Empty the replay buffer.
    */
   void clear();
 
+  /**
+   * End the current episode, e.g., when the actor adding it stops, so that the next experience begins a new episode.
+   * The last experiences of the episode are not stored, since their multistep returns are not complete.
+   */
+  void endEpisode();
+
   /**
    * Retrieve a boolean indicating whether the replay buffer is prioritized.
    * @return true if the replay buffer is prioritized, false otherwise
@@ -188,6 +293,12 @@ class ReplayBuffer {
    */
   torch::Tensor getLastIndices();
 
+  /**
+   * Retrieve the priority tree of the buffer.
+   * @return the priority tree
+   */
+  std::unique_ptr<PriorityTree> &getPriorities();
+
   /**
    * Retrieve the priority at the provided index.
    * @param index the index
@@ -195,6 +306,28 @@ class ReplayBuffer {
    */
   float getPriority(int index);
 
+  /**
+   * Retrieve the latency statistics of the replay buffer operations, which are
+   * only recorded when the library is compiled with RELAB_INSTRUMENTATION and
+   * are shared by all the replay buffers of the process.
+   * @return a map whose keys are operation names (i.e., append, encode, decode,
+   * sample, report, save and load) and values are maps containing the number
+   * of calls, as well as the mean, median, 90th percentile, 99th percentile
+   * and maximum latency in microseconds
+   */
+  std::map<std::string, std::map<std::string, double>> stats();
+
+  /**
+   * Compute the memory used by the replay buffer.
+   * @return a map containing the bytes used by each component (i.e.,
+   * "compressed_frames", "frame_metadata", "frame_handles", "references",
+   * "data" and "priority_trees") and in total ("total"), the number of stored frames
+   * ("n_frames") and their size before compression ("uncompressed_frames"), the
+   * average compression ratio of the frames ("compression_ratio"), and the
+   * total number of bytes projected when the buffer is full ("projected_total")
+   */
+  std::map<std::string, double> memoryStats();
+
   /**
    * Compare two replay buffers.
    * @param lhs the replay buffer on the left-hand-side of the equal sign
@@ -0,0 +1,103 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file replay_client.hpp
+ * @brief Declaration of a client accessing a replay buffer owned by a replay server.
+ */
+
+#ifndef RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_CLIENT_HPP_
+#define RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_CLIENT_HPP_
+
+#include <torch/extension.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "agents/memory/experience.hpp"
+#include "agents/memory/replay_protocol.hpp"
+
+namespace relab::agents::memory::impl {
+
+/**
+ * @brief A client accessing a replay buffer owned by a replay server running
+ * in another process.
+ *
+ * @details
+ * Requests are pipelined: appending experiences never waits for the server,
+ * and a batch can be requested before it is needed, then received later.
+ */
+class ReplayClient {
+ private:
+  // The socket connected to the server.
+  int fd;
+
+  // The types of the requests whose responses have not been received yet, and the batches received but not returned.
+  std::deque<MessageType> pending_requests;
+  std::deque<Batch> received_batches;
+
+ public:
+  /**
+   * Connect to a replay server.
+   * @param socket_path the path of the Unix domain socket on which the server listens
+   */
+  explicit ReplayClient(const std::string &socket_path);
+
+  ReplayClient(const ReplayClient &) = delete;
+  ReplayClient &operator=(const ReplayClient &) = delete;
+
+  /**
+   * Disconnect from the replay server.
+   */
+  ~ReplayClient();
+
+  /**
+   * Add experiences to the replay buffer, without waiting for the server.
+   * @param experiences the experiences to add
+   */
+  void append(const std::vector<Experience> &experiences);
+
+  /**
+   * Request a batch from the replay buffer, without waiting for the server.
+   */
+  void requestSample();
+
+  /**
+   * Receive the oldest batch requested, requesting one first if none is pending.
+   * @return the batch
+   */
+  Batch receiveSample();
+
+  /**
+   * Sample a batch from the replay buffer, i.e., request a batch and receive the oldest batch requested.
+   * @return the batch
+   */
+  Batch sample();
+
+  /**
+   * Report the loss associated with the transitions of the oldest batch whose loss has not been reported yet.
+   * @param loss the loss of the transitions
+   * @return the new loss
+   */
+  torch::Tensor report(const torch::Tensor &loss);
+
+  /**
+   * Retrieve the number of elements in the replay buffer.
+   * @return the number of elements
+   */
+  int size();
+
+ private:
+  /**
+   * Wait for the response to the oldest pending request of a given type, storing the batches received meanwhile.
+   * @param type the type of the request
+   * @return the response
+   */
+  Message waitFor(MessageType type);
+};
+}  // namespace relab::agents::memory::impl
+
+namespace relab::agents::memory {
+using impl::ReplayClient;
+}  // namespace relab::agents::memory
+
+#endif  // RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_CLIENT_HPP_
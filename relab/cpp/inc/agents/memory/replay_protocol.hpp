@@ -0,0 +1,115 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file replay_protocol.hpp
+ * @brief Declaration of the binary protocol used by the replay server and its clients.
+ */
+
+#ifndef RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_PROTOCOL_HPP_
+#define RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_PROTOCOL_HPP_
+
+#include <torch/extension.h>
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "agents/memory/experience.hpp"
+
+namespace relab::agents::memory {
+
+/**
+ * Enumeration of the types of messages exchanged by the replay server and its clients.
+ *
+ * Requests are answered in the order they are received, and the response has
+ * the type of the request, except when the request failed. Append requests are
+ * not answered, so actors can stream experiences without waiting.
+ */
+enum class MessageType : int32_t {
+  APPEND = 0,  // A batch of experiences to append.
+  SAMPLE = 1,  // A request for a batch, answered with the batch.
+  REPORT = 2,  // The loss of the oldest unreported batch, answered with the new loss.
+  SIZE = 3,    // A request for the number of experiences, answered with this number.
+  FAILURE = 4  // The response to a request that failed, containing the error message.
+};
+
+/**
+ * @brief A message exchanged by the replay server and its clients.
+ */
+class Message {
+ public:
+  MessageType type;
+  std::string payload;
+};
+
+// The size of a message header, i.e., the message type followed by the payload size.
+constexpr size_t MESSAGE_HEADER_SIZE = sizeof(int32_t) + sizeof(int64_t);
+
+// The largest payload accepted, so that a corrupted header cannot make the receiver allocate an arbitrary amount of
+// memory.
+constexpr int64_t MAX_PAYLOAD_SIZE = int64_t(1) << 30;
+
+/**
+ * Append a message to a buffer of bytes to send, i.e., a header containing the message type and payload size,
+ * followed by the payload.
+ * @param buffer the buffer of bytes to send
+ * @param type the message type
+ * @param payload the message payload
+ */
+void appendMessage(std::string &buffer, MessageType type, const std::string &payload = "");
+
+/**
+ * Remove the oldest message from a buffer of received bytes, if it was entirely received.
+ * @param buffer the buffer of received bytes
+ * @return the message, or nothing if the buffer does not contain a whole message yet
+ */
+std::optional<Message> extractMessage(std::string &buffer);
+
+/**
+ * Send a message through a blocking socket, i.e., a header containing the message type and payload size, followed by
+ * the payload.
+ * @param fd the socket
+ * @param type the message type
+ * @param payload the message payload
+ */
+void sendMessage(int fd, MessageType type, const std::string &payload = "");
+
+/**
+ * Receive a message from a blocking socket.
+ * @param fd the socket
+ * @return the message, or nothing if the socket was closed before the message started
+ */
+std::optional<Message> receiveMessage(int fd);
+
+/**
+ * Save the experiences to append into a stream.
+ * @param experiences the experiences
+ * @param stream the stream writing the message payload
+ */
+void saveExperiences(const std::vector<Experience> &experiences, std::ostream &stream);
+
+/**
+ * Load the experiences to append from a stream.
+ * @param stream the stream reading the message payload
+ * @return the experiences
+ */
+std::vector<Experience> loadExperiences(std::istream &stream);
+
+/**
+ * Save a batch into a stream.
+ * @param batch the batch
+ * @param stream the stream writing the message payload
+ */
+void saveBatch(const Batch &batch, std::ostream &stream);
+
+/**
+ * Load a batch from a stream.
+ * @param stream the stream reading the message payload
+ * @return the batch
+ */
+Batch loadBatch(std::istream &stream);
+}  // namespace relab::agents::memory
+
+#endif  // RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_PROTOCOL_HPP_
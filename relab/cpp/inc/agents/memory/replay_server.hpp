@@ -0,0 +1,154 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file replay_server.hpp
+ * @brief Declaration of a server giving other processes access to a replay buffer.
+ */
+
+#ifndef RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_SERVER_HPP_
+#define RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_SERVER_HPP_
+
+#include <torch/extension.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "agents/memory/replay_buffer.hpp"
+#include "agents/memory/replay_protocol.hpp"
+
+namespace relab::agents::memory::impl {
+
+/**
+ * @brief A class storing the state of a client connected to the replay server.
+ */
+class ReplayConnection {
+ public:
+  // The bytes received that do not form a whole request yet, and the requests received but not answered yet.
+  std::string incoming;
+  std::deque<Message> requests;
+
+  // The bytes of the queued responses, and the number of these bytes already sent.
+  std::string outgoing;
+  size_t n_sent = 0;
+
+  // Whether the client closed its side of the connection, in which case its remaining requests are still answered.
+  bool closed = false;
+
+  // The experiences appended by the client but not added to the replay buffer yet, because another client is adding
+  // an episode.
+  std::deque<Experience> pending;
+
+  // The indices of the batches sampled by the client and whose loss has not been reported yet, offset by the number
+  // of experiences evicted from the buffer when they were sampled, so that they do not change when experiences are
+  // added.
+  std::deque<torch::Tensor> sampled_indices;
+};
+
+/**
+ * @brief A server owning a replay buffer, which actors and learners running
+ * in other processes access through a Unix domain socket.
+ *
+ * @details
+ * The server handles all its clients in a single thread, so the requests are
+ * applied to the replay buffer one at a time. Frames are decoded by the
+ * server, whose replay buffer uses its own thread pool, and clients can send
+ * several requests before reading the responses, e.g., a learner can request
+ * the next batch before training on the current one. The sockets of the
+ * clients are non-blocking: the responses are queued and sent whenever the
+ * clients can receive them, so a client that does not read its responses
+ * never blocks the server or the other clients.
+ *
+ * The frames of an experience are stored as references to the frames of the
+ * previous experience, so the episodes of different clients must not be
+ * interleaved in the replay buffer. A single client adds experiences to the
+ * buffer at a time, until its episode ends, and the experiences appended by
+ * the other clients meanwhile are kept by the server until their turn comes.
+ * If a client disconnects in the middle of an episode, the episode is ended
+ * without its last experiences.
+ */
+class ReplayServer {
+ private:
+  // The path of the socket, and the socket accepting connections.
+  std::string socket_path;
+  int listen_fd;
+
+  // The pipe used to wake up the server when it must stop.
+  int stop_fds[2];
+
+  // The replay buffer.
+  std::shared_ptr<ReplayBuffer> buffer;
+
+  // The client whose episode is being added to the replay buffer, if any.
+  ReplayConnection *writer;
+
+ public:
+  /**
+   * Create a server, which accepts connections as soon as it is created but only answers them once it serves.
+   * @param socket_path the path of the Unix domain socket, any file at this path is removed
+   * @param buffer the replay buffer to serve
+   */
+  ReplayServer(const std::string &socket_path, std::shared_ptr<ReplayBuffer> buffer);
+
+  ReplayServer(const ReplayServer &) = delete;
+  ReplayServer &operator=(const ReplayServer &) = delete;
+
+  /**
+   * Close the socket and remove it from the filesystem.
+   */
+  ~ReplayServer();
+
+  /**
+   * Answer the requests of the clients until the server is stopped.
+   */
+  void serve();
+
+  /**
+   * Stop serving, this function can be called from another thread or from a signal handler.
+   */
+  void stop();
+
+ private:
+  /**
+   * Receive the bytes available on the socket of a client, without blocking, and queue the whole requests received.
+   * @param fd the socket of the client
+   * @param connection the state of the client
+   */
+  void receiveRequests(int fd, ReplayConnection &connection);
+
+  /**
+   * Send as many bytes of the queued responses as the socket of a client accepts, without blocking.
+   * @param fd the socket of the client
+   * @param connection the state of the client
+   */
+  void sendResponses(int fd, ReplayConnection &connection);
+
+  /**
+   * Add the pending experiences of a client to the replay buffer, unless
+   * another client is adding an episode, stopping at the end of an episode so
+   * that the other clients get their turn.
+   * @param connection the state of the client
+   */
+  void addPendingExperiences(ReplayConnection &connection);
+
+  /**
+   * Close the connection of a client, ending the episode it was adding to the replay buffer, if any.
+   * @param fd the socket of the client
+   * @param clients the state of each client, indexed by the socket of the client
+   */
+  void disconnect(int fd, std::map<int, ReplayConnection> &clients);
+
+  /**
+   * Answer a request, queuing the response.
+   * @param message the request
+   * @param connection the state of the client sending the request
+   */
+  void answer(Message &message, ReplayConnection &connection);
+};
+}  // namespace relab::agents::memory::impl
+
+namespace relab::agents::memory {
+using impl::ReplayServer;
+}  // namespace relab::agents::memory
+
+#endif  // RELAB_CPP_INC_AGENTS_MEMORY_REPLAY_SERVER_HPP_
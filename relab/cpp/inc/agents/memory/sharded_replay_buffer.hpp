@@ -0,0 +1,152 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file sharded_replay_buffer.hpp
+ * @brief Declaration of a replay buffer split into independent shards.
+ */
+
+#ifndef RELAB_CPP_INC_AGENTS_MEMORY_SHARDED_REPLAY_BUFFER_HPP_
+#define RELAB_CPP_INC_AGENTS_MEMORY_SHARDED_REPLAY_BUFFER_HPP_
+
+#include <torch/extension.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "agents/memory/compressors.hpp"
+#include "agents/memory/experience.hpp"
+#include "agents/memory/replay_buffer.hpp"
+#include "agents/memory/shared_experience_queue.hpp"
+#include "helpers/thread_pool.hpp"
+
+namespace relab::agents::memory::impl {
+
+using relab::helpers::ThreadPool;
+
+/**
+ * @brief A replay buffer whose capacity is split over several shards, each
+ * shard being a replay buffer with its own lock, priority tree and frame storage.
+ *
+ * @details
+ * Actors append to different shards concurrently, and experiences are sampled
+ * in two levels: the number of experiences drawn from each shard follows the
+ * shards' total priorities (or sizes, if the buffer is not prioritized), then
+ * each shard samples its share of the batch, all shards working in parallel.
+ * Since a shard is picked with a probability proportional to its total
+ * priority, experiences are sampled as in a single prioritized buffer, and the
+ * importance sampling weights are normalized by the largest weight over all
+ * shards. Only proportional prioritization is supported.
+ *
+ * Any number of actors may append experiences concurrently, but the buffer
+ * expects a single consumer: a loss is reported for the last batch sampled,
+ * whichever thread sampled it.
+ */
+class ShardedReplayBuffer {
+ private:
+  // Keep in mind whether the replay buffer is prioritized.
+  bool prioritized;
+
+  // Store the buffer parameters.
+  int batch_size;
+  float omega_is;
+
+  // The shards, and the locks protecting them.
+  std::vector<std::unique_ptr<ReplayBuffer>> shards;
+  std::deque<std::mutex> shard_mutexes;
+
+  // The thread pool processing the shards in parallel.
+  std::unique_ptr<ThreadPool> pool;
+
+  // The indices of the last sampled experiences in each shard, in the order they appear in the batch, and the lock
+  // protecting them.
+  std::mutex indices_mutex;
+  std::vector<torch::Tensor> indices;
+
+ public:
+  /**
+   * Create a sharded replay buffer.
+   * @param n_shards the number of shards
+   * @param capacity the number of experience the buffer can store, which is split evenly over the shards
+   * @param batch_size the size of the batch to sample
+   * @param frame_skip the number of times each action is repeated in the environment
+   * @param stack_size the number of stacked frame in each observation
+   * @param screen_size: the size of the images used by the agent to learn
+   * @param type the type of compression to use
+   * @param args the prioritization and multistep arguments, as in the replay buffer, except that the shards always
+   * decode their frames with the shared thread pool
+   * @param cpu_affinity the CPUs to which the threads of the shards are pinned, or an empty vector to let them run
+   * on any CPU
+   */
+  ShardedReplayBuffer(
+      int n_shards = 4, int capacity = 10000, int batch_size = 32, int frame_skip = 1, int stack_size = 4,
+      int screen_size = 84, CompressorType type = CompressorType::ZLIB, std::map<std::string, float> args = {},
+      const std::vector<int> &cpu_affinity = {}
+  );
+
+  /**
+   * Add a new experience to the shard of an actor. Each actor has its own
+   * shard, because the frames of an experience are stored as references to the
+   * frames of the previous experience of the same actor.
+   * @param experience the experience to add
+   * @param actor the index of the actor, which is also the index of its shard
+   */
+  void append(const Experience &experience, int actor = 0);
+
+  /**
+   * Move the experiences pushed by actor processes into a shared experience
+   * queue to the buffer, each experience being added to the shard of the actor
+   * that pushed it.
+   * @param queue the shared experience queue
+   * @param max_experiences the maximum number of experiences to move (-1 for all the experiences in the queue)
+   * @return the number of experiences moved
+   */
+  int drain(SharedExperienceQueue &queue, int max_experiences = -1);
+
+  /**
+   * Sample a batch from the replay buffer, the experiences of each shard being contiguous in the batch.
+   * @return (observations, actions, rewards, done, next_observations) as in the replay buffer
+   */
+  Batch sample();
+
+  /**
+   * Report the loss associated with all the transitions of the previous batch, i.e., the last batch sampled by any
+   * thread.
+   * @param loss the loss of all previous transitions
+   * @return the new loss
+   */
+  torch::Tensor report(torch::Tensor &loss);
+
+  /**
+   * Retrieve the number of elements in the buffer.
+   * @return the number of elements contained in all shards
+   */
+  int size();
+
+  /**
+   * Empty the replay buffer.
+   */
+  void clear();
+
+  /**
+   * Retrieve a shard, which must not be used while other threads use the sharded replay buffer.
+   * @param index the shard index
+   * @return the shard
+   */
+  std::unique_ptr<ReplayBuffer> &getShard(int index);
+
+  /**
+   * Retrieve the number of shards.
+   * @return the number of shards
+   */
+  int nShards();
+};
+}  // namespace relab::agents::memory::impl
+
+namespace relab::agents::memory {
+using impl::ShardedReplayBuffer;
+}  // namespace relab::agents::memory
+
+#endif  // RELAB_CPP_INC_AGENTS_MEMORY_SHARDED_REPLAY_BUFFER_HPP_
@@ -0,0 +1,161 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file shared_experience_queue.hpp
+ * @brief Declaration of a queue of experiences shared by several processes.
+ */
+
+#ifndef RELAB_CPP_INC_AGENTS_MEMORY_SHARED_EXPERIENCE_QUEUE_HPP_
+#define RELAB_CPP_INC_AGENTS_MEMORY_SHARED_EXPERIENCE_QUEUE_HPP_
+
+#include <torch/extension.h>
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "agents/memory/experience.hpp"
+
+namespace relab::agents::memory::impl {
+
+/**
+ * @brief The header at the beginning of the shared memory segment.
+ */
+class QueueHeader {
+ public:
+  // A constant identifying initialized segments, written last by the process creating the segment.
+  std::atomic<uint64_t> magic;
+
+  // The queue parameters.
+  int32_t capacity;
+  int32_t stack_size;
+  int32_t screen_size;
+  int32_t slot_size;
+
+  // The positions of the next slot to write and of the next slot to read, on separate cache lines.
+  alignas(64) std::atomic<uint64_t> enqueue_position;
+  alignas(64) std::atomic<uint64_t> dequeue_position;
+};
+
+/**
+ * @brief The header of each slot, followed by the frames of the observations at time t and t + 1. The observation at
+ * time t + 1 may only contain its newest frames, see Experience::fromNewestFrames.
+ */
+class SlotHeader {
+ public:
+  // The position for which the slot can be written (equal to the position) or read (equal to the position plus one).
+  std::atomic<uint64_t> sequence;
+
+  // The actor that pushed the experience, the action, reward and done of the experience, and the number of frames in
+  // the observation at time t + 1.
+  int32_t actor;
+  int32_t action;
+  float reward;
+  int32_t done;
+  int32_t n_next_frames;
+};
+
+/**
+ * @brief A bounded queue of experiences stored in a POSIX shared memory
+ * segment, which several actor processes can fill while a learner process
+ * drains it into its replay buffer.
+ *
+ * @details
+ * The queue is a lock-free multi-producer multi-consumer ring buffer, in
+ * which each slot holds a sequence number telling whether it is ready to be
+ * written or read. Experiences are copied into the slots without being
+ * serialized, so actors neither pickle experiences nor contend for the GIL of
+ * the learner process.
+ *
+ * The experiences of all actors are interleaved in the queue, and each
+ * experience records the actor that pushed it, so that the learner can add the
+ * experiences of each actor to its own stream of episodes. Every slot stores a
+ * full observation at time t, even though only the first experience of an
+ * episode needs it.
+ */
+class SharedExperienceQueue {
+ private:
+  // The name of the shared memory segment, and whether this process created it.
+  std::string name;
+  bool owner;
+
+  // The memory mapping of the segment.
+  size_t n_bytes;
+  QueueHeader *header;
+  char *slots;
+
+  // The number of floats in each frame and in each observation.
+  int frame_size;
+  int obs_size;
+
+ public:
+  /**
+   * Create a new shared memory segment, or open an existing one.
+   * @param name the name of the shared memory segment, which must start with a slash
+   * @param capacity the number of experiences the queue can store, ignored when opening an existing segment
+   * @param stack_size the number of stacked frames in each observation, ignored when opening an existing segment
+   * @param screen_size the size of the frames, ignored when opening an existing segment
+   * @param create true to create the segment (removing any segment with the same name), false to open it
+   */
+  SharedExperienceQueue(
+      const std::string &name, int capacity = 1024, int stack_size = 4, int screen_size = 84, bool create = true
+  );
+
+  SharedExperienceQueue(const SharedExperienceQueue &) = delete;
+  SharedExperienceQueue &operator=(const SharedExperienceQueue &) = delete;
+
+  /**
+   * Unmap the shared memory segment, and remove it if this process created it.
+   */
+  ~SharedExperienceQueue();
+
+  /**
+   * Add an experience to the queue, without blocking. The observation at time
+   * t + 1 may only contain its newest frames, which are the only ones stored.
+   * @param experience the experience to add
+   * @param actor the index of the actor pushing the experience
+   * @return true if the experience was added, false if the queue is full
+   */
+  bool push(const Experience &experience, int actor = 0);
+
+  /**
+   * Remove the oldest experience from the queue, without blocking.
+   * @return the experience, or nothing if the queue is empty
+   */
+  std::optional<Experience> pop();
+
+  /**
+   * Remove the oldest experience from the queue, without blocking.
+   * @param actor the index of the actor that pushed the experience, set only if an experience is returned
+   * @return the experience, or nothing if the queue is empty
+   */
+  std::optional<Experience> pop(int &actor);
+
+  /**
+   * Retrieve the number of experiences in the queue, which may already be
+   * outdated when other processes use the queue.
+   * @return the number of experiences
+   */
+  int size();
+
+  /**
+   * Retrieve the number of experiences the queue can store.
+   * @return the capacity
+   */
+  int capacity();
+
+ private:
+  /**
+   * Retrieve the header of a slot.
+   * @param position the position of the slot in the queue
+   * @return the header, which is followed by the observations
+   */
+  SlotHeader *slot(uint64_t position);
+};
+}  // namespace relab::agents::memory::impl
+
+namespace relab::agents::memory {
+using impl::SharedExperienceQueue;
+}  // namespace relab::agents::memory
+
+#endif  // RELAB_CPP_INC_AGENTS_MEMORY_SHARED_EXPERIENCE_QUEUE_HPP_
@@ -0,0 +1,26 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file hash.hpp
+ * @brief Helper functions to hash the content of memory buffers.
+ */
+
+#ifndef RELAB_CPP_INC_HELPERS_HASH_HPP_
+#define RELAB_CPP_INC_HELPERS_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relab::helpers {
+
+/**
+ * Compute a 64-bit non-cryptographic hash of a buffer, using the same mixing
+ * steps as xxHash64.
+ * @param data a pointer to the first byte of the buffer
+ * @param size the number of bytes in the buffer
+ * @param seed the seed of the hash function
+ * @return the hash of the buffer
+ */
+uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0);
+}  // namespace relab::helpers
+
+#endif  // RELAB_CPP_INC_HELPERS_HASH_HPP_
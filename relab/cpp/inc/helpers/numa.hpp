@@ -0,0 +1,132 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file numa.hpp
+ * @brief Declaration of a class describing the NUMA nodes of the machine.
+ */
+
+#ifndef RELAB_CPP_INC_HELPERS_NUMA_HPP_
+#define RELAB_CPP_INC_HELPERS_NUMA_HPP_
+
+#include <string>
+#include <vector>
+
+namespace relab::helpers {
+
+/**
+ * @brief A class describing the NUMA nodes of the machine, i.e., the CPUs of
+ * each node, and giving control over where threads run and where memory is
+ * allocated.
+ *
+ * @details
+ * The topology is read from sysfs, and nodes without CPUs are ignored. When
+ * sysfs is unavailable, the machine is described as a single node containing
+ * all CPUs, in which case pinning threads and placing memory do nothing. Nodes
+ * are identified by their index in the topology, which may differ from the
+ * node number used by the kernel.
+ */
+class NumaTopology {
+ private:
+  // The kernel number and the CPUs of each node.
+  std::vector<int> node_ids;
+  std::vector<std::vector<int>> node_cpus;
+
+ public:
+  /**
+   * Read the topology of the machine.
+   * @param sysfs_path the directory containing one "nodeN" directory per node
+   */
+  explicit NumaTopology(const std::string &sysfs_path = "/sys/devices/system/node");
+
+  /**
+   * Retrieve the topology of the machine, which is read once per process.
+   * @return the topology
+   */
+  static NumaTopology &global();
+
+  /**
+   * Retrieve the number of nodes.
+   * @return the number of nodes
+   */
+  int nNodes() const;
+
+  /**
+   * Retrieve the CPUs of a node.
+   * @param node the node index
+   * @return the CPUs
+   */
+  const std::vector<int> &cpus(int node) const;
+
+  /**
+   * Retrieve the node of a CPU.
+   * @param cpu the CPU
+   * @return the node index, or -1 if the CPU is unknown
+   */
+  int nodeOfCpu(int cpu) const;
+
+  /**
+   * Retrieve the node on which the memory at an address is located.
+   * @param address the address
+   * @return the node index, or -1 if the node cannot be determined
+   */
+  int nodeOfAddress(const void *address) const;
+
+  /**
+   * Restrict the thread calling this function to the CPUs of a node.
+   * @param node the node index
+   * @return true if the thread was pinned, false otherwise
+   */
+  bool pinCurrentThread(int node) const;
+
+  /**
+   * Restrict the thread calling this function to some CPUs.
+   * @param cpus the CPUs
+   * @return true if the thread was pinned, false otherwise
+   */
+  static bool pinCurrentThreadToCpus(const std::vector<int> &cpus);
+
+  /**
+   * Make the memory allocated by the thread calling this function be placed on a node, whenever possible.
+   * @param node the node index, or -1 to restore the default placement
+   * @return true if the placement policy was changed, false otherwise
+   */
+  bool preferNode(int node) const;
+
+  /**
+   * Parse a list of CPUs in the sysfs format, e.g., "0-3,8,10-11".
+   * @param list the list of CPUs
+   * @return the CPUs
+   */
+  static std::vector<int> parseCpuList(const std::string &list);
+};
+
+/**
+ * @brief A class making the memory allocated by the thread creating it be
+ * placed on a node, and restoring the previous placement policy of this
+ * thread when it is destroyed, e.g., when an exception leaves the scope.
+ */
+class NodePreference {
+ private:
+  // The placement policy of the thread before the preference was set, and whether the policy was changed.
+  int mode;
+  std::vector<unsigned long> mask;  // NOLINT
+  bool changed;
+
+ public:
+  /**
+   * Make the memory allocated by the calling thread be placed on a node, whenever possible.
+   * @param topology the topology of the machine
+   * @param node the node index
+   */
+  NodePreference(const NumaTopology &topology, int node);
+
+  NodePreference(const NodePreference &) = delete;
+  NodePreference &operator=(const NodePreference &) = delete;
+
+  /**
+   * Restore the placement policy the thread had before.
+   */
+  ~NodePreference();
+};
+}  // namespace relab::helpers
+
+#endif  // RELAB_CPP_INC_HELPERS_NUMA_HPP_
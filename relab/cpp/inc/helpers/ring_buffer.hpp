@@ -0,0 +1,167 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file ring_buffer.hpp
+ * @brief Declaration of a double-ended queue with a fixed capacity.
+ */
+
+#ifndef RELAB_CPP_INC_HELPERS_RING_BUFFER_HPP_
+#define RELAB_CPP_INC_HELPERS_RING_BUFFER_HPP_
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+
+namespace relab::helpers {
+
+/**
+ * @brief A double-ended queue with a fixed capacity, storing its elements in a
+ * circular buffer allocated once.
+ *
+ * @details
+ * When an element is added to a full queue, the element at the other end of
+ * the queue is discarded.
+ * Adding and removing elements never allocate memory.
+ */
+template <class T> class RingBuffer {
+ private:
+  // The elements, the maximum number of elements, the position of the first element, and the number of elements.
+  std::unique_ptr<T[]> elements;
+  int capacity;
+  int head;
+  int length;
+
+ public:
+  /**
+   * Create a double-ended queue with a fixed capacity.
+   * @param capacity the maximum number of elements in the queue
+   */
+  explicit RingBuffer(int capacity = 0);
+
+  /**
+   * Create a copy of a double-ended queue.
+   * @param other the queue to copy
+   */
+  RingBuffer(const RingBuffer &other);
+
+  /**
+   * Replace the content of this double-ended queue by a copy of another one.
+   * @param other the queue to copy
+   * @return this queue
+   */
+  RingBuffer &operator=(const RingBuffer &other);
+
+  /**
+   * Add an element at the end of the queue, discarding the first element if the queue is full.
+   * @param element the element to add
+   */
+  void push_back(T element);
+
+  /**
+   * Add an element at the front of the queue, discarding the last element if the queue is full.
+   * @param element the element to add
+   */
+  void push_front(T element);
+
+  /**
+   * Remove the element at the end of the queue, which must not be empty.
+   */
+  void pop_back();
+
+  /**
+   * Remove the element at the front of the queue, which must not be empty.
+   */
+  void pop_front();
+
+  /**
+   * Retrieve the element at the front of the queue, which must not be empty.
+   * @return the first element
+   */
+  T &front();
+
+  /**
+   * Retrieve the element at the end of the queue, which must not be empty.
+   * @return the last element
+   */
+  T &back();
+
+  /**
+   * Retrieve the element whose index is passed as parameters.
+   * @param index the index, where zero is the front of the queue
+   * @return the element at the given index
+   */
+  T &operator[](size_t index);
+
+  /**
+   * Retrieve the element whose index is passed as parameters.
+   * @param index the index, where zero is the front of the queue
+   * @return the element at the given index
+   */
+  const T &operator[](size_t index) const;
+
+  /**
+   * Retrieve the element whose index is passed as parameters.
+   * @param index the index
+   * @return the element at the given index
+   */
+  T get(int index);
+
+  /**
+   * Retrieve the number of elements in the queue.
+   * @return the number of elements
+   */
+  size_t size() const;
+
+  /**
+   * Remove all the elements of the queue, without releasing its memory.
+   */
+  void clear();
+
+  /**
+   * Load the double ended queue from the checkpoint.
+   * @param checkpoint a stream reading from the checkpoint file
+   */
+  void load(std::istream &checkpoint);
+
+  /**
+   * Save the double ended queue in the checkpoint, i.e., its capacity, its size and its elements from front to back.
+   * @param checkpoint a stream writing into the checkpoint file
+   */
+  void save(std::ostream &checkpoint);
+
+  /**
+   * Print the double ended queue on the standard output.
+   */
+  void print();
+
+  /**
+   * Compare two double ended queues.
+   * @param lhs the double ended queue on the left-hand-side of the equal sign
+   * @param rhs the double ended queue on the right-hand-side of the equal sign
+   * @return true if the double ended queues are identical, false otherwise
+   */
+  template <class Type> friend bool operator==(const RingBuffer<Type> &lhs, const RingBuffer<Type> &rhs);
+
+  /**
+   * Compare two double ended queues.
+   * @param lhs the double ended queue on the left-hand-side of the not equal sign
+   * @param rhs the double ended queue on the right-hand-side of the not equal sign
+   * @return true if the double ended queues are different, false otherwise
+   */
+  template <class Type> friend bool operator!=(const RingBuffer<Type> &lhs, const RingBuffer<Type> &rhs);
+
+ private:
+  /**
+   * Retrieve the position in the circular buffer of the element whose index is passed as parameters.
+   * @param index the index, where zero is the front of the queue
+   * @return the position of the element
+   */
+  int position(int index) const;
+};
+
+// Explicit instantiation of double ended queue.
+template class RingBuffer<int>;
+template class RingBuffer<float>;
+template class RingBuffer<bool>;
+}  // namespace relab::helpers
+
+#endif  // RELAB_CPP_INC_HELPERS_RING_BUFFER_HPP_
@@ -9,10 +9,39 @@
 
 #include <torch/extension.h>
 
+#include <cstdint>
 #include <vector>
 
 namespace relab::helpers {
 
+/**
+ * The number written at the beginning of the replay buffer checkpoints, i.e., the bytes "RLRB".
+ */
+constexpr int32_t CHECKPOINT_MAGIC = 0x42524C52;
+
+/**
+ * The version of the replay buffer checkpoint format, which is increased
+ * whenever a field is added to or removed from the checkpoints. The
+ * checkpoints written before the format was versioned have version zero.
+ */
+constexpr int CHECKPOINT_VERSION = 1;
+
+/**
+ * Load the header of a checkpoint, i.e., the magic number followed by the
+ * format version. If the checkpoint does not start with the magic number, it
+ * was written before the format was versioned and the stream is rewound.
+ * @param checkpoint the stream reading from the checkpoint file
+ * @return the version of the checkpoint format
+ */
+int load_checkpoint_version(std::istream &checkpoint);
+
+/**
+ * Save the header of a checkpoint, i.e., the magic number followed by the
+ * current format version.
+ * @param checkpoint the stream writing into the checkpoint file
+ */
+void save_checkpoint_version(std::ostream &checkpoint);
+
 /**
  * Load a vector of integers from a stream.
  * @param checkpoint the stream reading from the checkpoint file
@@ -69,6 +98,52 @@ template <class T> torch::Tensor load_tensor(std::istream &checkpoint);
  * @param checkpoint the stream writing into the checkpoint file
  */
 template <class T> void save_tensor(const torch::Tensor &tensor, std::ostream &checkpoint);
+
+/**
+ * Load a buffer of bytes compressed with zlib from a stream.
+ * @param checkpoint the stream reading from the checkpoint file
+ * @return the decompressed bytes
+ */
+std::vector<char> load_compressed_bytes(std::istream &checkpoint);
+
+/**
+ * Compress a buffer of bytes with zlib and save it into a stream.
+ * @param data a pointer to the bytes to save
+ * @param size the number of bytes to save
+ * @param checkpoint the stream writing into the checkpoint file
+ */
+void save_compressed_bytes(const char *data, int64_t size, std::ostream &checkpoint);
+
+/**
+ * Load a compressed vector from a stream.
+ * @param checkpoint the stream reading from the checkpoint file
+ * @param delta true if the vector was delta encoded before compression, false otherwise
+ * @return the vector
+ */
+template <class T> std::vector<T> load_compressed_vector(std::istream &checkpoint, bool delta = false);
+
+/**
+ * Compress a vector and save it into a stream.
+ * @param vector the vector to save
+ * @param checkpoint the stream writing into the checkpoint file
+ * @param delta true if the vector must be delta encoded before compression, false otherwise
+ */
+template <class T>
+void save_compressed_vector(const std::vector<T> &vector, std::ostream &checkpoint, bool delta = false);
+
+/**
+ * Load a compressed tensor from a stream.
+ * @param checkpoint the stream reading from the checkpoint file
+ * @return the tensor
+ */
+template <class T> torch::Tensor load_compressed_tensor(std::istream &checkpoint);
+
+/**
+ * Compress a tensor and save it into a stream.
+ * @param tensor the tensor to save
+ * @param checkpoint the stream writing into the checkpoint file
+ */
+template <class T> void save_compressed_tensor(const torch::Tensor &tensor, std::ostream &checkpoint);
 }  // namespace relab::helpers
 
 #endif  // RELAB_CPP_INC_HELPERS_SERIALIZE_HPP_
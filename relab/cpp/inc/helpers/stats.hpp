@@ -0,0 +1,181 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file stats.hpp
+ * @brief Declaration of the classes recording the latency of the replay buffer's hot paths.
+ */
+
+#ifndef RELAB_CPP_INC_HELPERS_STATS_HPP_
+#define RELAB_CPP_INC_HELPERS_STATS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+
+/**
+ * Record the time spent until the end of the current scope in the histogram
+ * of an operation, when the library is compiled with RELAB_INSTRUMENTATION.
+ */
+#ifdef RELAB_INSTRUMENTATION
+#define RELAB_MEASURE(operation) relab::helpers::ScopedLatency relab_scoped_latency(operation)
+#else
+#define RELAB_MEASURE(operation)
+#endif
+
+namespace relab::helpers {
+
+/**
+ * Enumeration of the operations whose latency is recorded.
+ */
+enum class Operation {
+  APPEND = 0,  // Adding an experience to the replay buffer.
+  ENCODE = 1,  // Compressing a frame.
+  DECODE = 2,  // Decompressing all the frames of an observation.
+  SAMPLE = 3,  // Sampling a batch of experiences.
+  REPORT = 4,  // Updating the priorities of the last sampled batch.
+  SAVE = 5,    // Saving the replay buffer in a checkpoint.
+  LOAD = 6     // Loading the replay buffer from a checkpoint.
+};
+
+/**
+ * @brief A histogram of latencies whose buckets have a bounded relative width.
+ *
+ * @details
+ * As in HDR histograms, each power of two is split into sixteen linear
+ * sub-buckets, so any latency is recorded with a relative error below 7%
+ * using a fixed amount of memory. Latencies can be recorded concurrently by
+ * several threads without locking.
+ */
+class Histogram {
+ public:
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr int N_SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr int N_BUCKETS = 64 * N_SUB_BUCKETS;
+
+ private:
+  std::array<std::atomic<uint64_t>, N_BUCKETS> counts;
+  std::atomic<uint64_t> n_values;
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> maximum;
+
+ public:
+  /**
+   * Create an empty histogram.
+   */
+  Histogram();
+
+  /**
+   * Record a latency.
+   * @param nanoseconds the latency in nanoseconds
+   */
+  void record(uint64_t nanoseconds);
+
+  /**
+   * Retrieve the number of recorded latencies.
+   * @return the number of latencies
+   */
+  uint64_t count() const;
+
+  /**
+   * Retrieve a percentile of the recorded latencies.
+   * @param percentage the percentage of latencies below the returned value, in [0, 100]
+   * @return the percentile in nanoseconds
+   */
+  double percentile(double percentage) const;
+
+  /**
+   * Summarize the recorded latencies.
+   * @return a map containing the number of latencies, as well as their mean,
+   * median, 90th percentile, 99th percentile and maximum in microseconds
+   */
+  std::map<std::string, double> summary() const;
+
+  /**
+   * Remove all the recorded latencies.
+   */
+  void clear();
+
+ private:
+  /**
+   * Compute the index of the bucket containing a value.
+   * @param value the value
+   * @return the bucket index
+   */
+  static int bucketIndex(uint64_t value);
+
+  /**
+   * Compute the middle of the values contained in a bucket.
+   * @param index the bucket index
+   * @return the middle of the bucket
+   */
+  static double bucketValue(int index);
+};
+
+/**
+ * @brief A class storing the latency histograms of all operations.
+ */
+class Stats {
+ public:
+  static constexpr int N_OPERATIONS = 7;
+
+ private:
+  std::array<Histogram, N_OPERATIONS> histograms;
+
+ public:
+  /**
+   * Retrieve the statistics shared by all the replay buffers of the process.
+   * @return the statistics
+   */
+  static Stats &global();
+
+  /**
+   * Retrieve the histogram of an operation.
+   * @param operation the operation
+   * @return the histogram
+   */
+  Histogram &operator[](Operation operation);
+
+  /**
+   * Retrieve the name of an operation.
+   * @param operation the operation
+   * @return the name
+   */
+  static std::string name(Operation operation);
+
+  /**
+   * Summarize the latencies of all the operations that were recorded at least once.
+   * @return a map whose keys are operation names and values are histogram summaries
+   */
+  std::map<std::string, std::map<std::string, double>> summary() const;
+
+  /**
+   * Remove all the recorded latencies.
+   */
+  void clear();
+};
+
+/**
+ * @brief A class recording the time elapsed between its creation and its
+ * destruction in the histogram of an operation.
+ */
+class ScopedLatency {
+ private:
+  Operation operation;
+  std::chrono::time_point<std::chrono::steady_clock> start_time;
+
+ public:
+  /**
+   * Start measuring the latency of an operation.
+   * @param operation the operation
+   */
+  explicit ScopedLatency(Operation operation);
+
+  /**
+   * Record the latency of the operation.
+   */
+  ~ScopedLatency();
+};
+}  // namespace relab::helpers
+
+#endif  // RELAB_CPP_INC_HELPERS_STATS_HPP_
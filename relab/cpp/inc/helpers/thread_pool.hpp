@@ -8,15 +8,48 @@
 #define RELAB_CPP_INC_HELPERS_THREAD_POOL_HPP_
 
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace relab::helpers {
 
+/**
+ * @brief Class keeping track of a batch of tasks pushed to a thread pool, so
+ * that its user only waits for its own tasks when the pool is shared.
+ */
+class TaskGroup {
+ private:
+  // Mutex and condition variable signaling the completion of the batch.
+  std::mutex group_mutex;
+  std::condition_variable finished_cv;
+
+  // The number of tasks of the batch that were pushed but not yet executed.
+  int n_pending = 0;
+
+ public:
+  /**
+   * Record that a task of the batch was pushed.
+   */
+  void add();
+
+  /**
+   * Record that a task of the batch was executed.
+   */
+  void done();
+
+  /**
+   * Wait for all the tasks of the batch to complete.
+   */
+  void wait();
+};
+
 /**
  * @brief Class implementing a thread pool.
  */
@@ -25,15 +58,18 @@ class ThreadPool {
   // Vector to store worker threads.
   std::vector<std::thread> threads;
 
-  // Queue of tasks.
-  std::queue<std::function<void()>> tasks;
+  // Queues of tasks, one per NUMA node when the pool is NUMA-aware and a single one otherwise, as well as the queue
+  // receiving the next task pushed without a node. Each task is stored with the group it belongs to, if any.
+  std::vector<std::queue<std::pair<std::function<void()>, TaskGroup *>>> tasks;
+  size_t next_queue = 0;
 
   // Mutexes to synchronize access to shared data.
   std::mutex queue_mutex;
   std::mutex counter_mutex;
 
-  // Condition variable to signal changes in the state of the tasks queue.
-  std::condition_variable cv;
+  // Condition variables to signal changes in the state of each tasks queue, and the completion of all tasks.
+  std::deque<std::condition_variable> cvs;
+  std::condition_variable finished_cv;
 
   // Flag to indicate whether the thread pool should stop or not.
   bool stop = false;
@@ -46,8 +82,27 @@ class ThreadPool {
   /**
    * Creates a thread pool.
    * @param num_threads the number of thread threads in the pool
+   * @param numa_aware true to spread the threads over the NUMA nodes, pin them
+   * to the CPUs of their node, and give each node its own queue of tasks; the
+   * pool is not NUMA-aware on single-node machines or with fewer threads than nodes
+   * @param cpus the CPUs on which the threads are allowed to run, each thread
+   * being pinned to one of them in turn, or an empty vector to let the threads
+   * run on any CPU
+   */
+  explicit ThreadPool(size_t num_threads, bool numa_aware = false, const std::vector<int> &cpus = {});
+
+  /**
+   * Retrieve the thread pool shared by all the users of this process, which is
+   * created by the first call and destroyed when its last user releases it.
+   * While the pool is alive, later calls must request the same parameters.
+   * @throw std::runtime_error if the pool is alive and was created with different parameters
+   * @param num_threads the number of thread threads in the pool
+   * @param numa_aware true to spread the threads over the NUMA nodes
+   * @param cpus the CPUs on which the threads are allowed to run, or an empty vector for any CPU
+   * @return the shared thread pool
    */
-  explicit ThreadPool(size_t num_threads);
+  static std::shared_ptr<ThreadPool>
+  shared(size_t num_threads, bool numa_aware = false, const std::vector<int> &cpus = {});
 
   /**
    * Destroy the thread pool.
@@ -57,13 +112,54 @@ class ThreadPool {
   /**
    * Push a task for execution by the thread pool.
    * @param task the task to execute
+   * @param node the NUMA node whose threads must execute the task, or -1 to let any thread execute it
    */
-  void push(const std::function<void()> &task);
+  void push(const std::function<void()> &task, int node = -1);
 
   /**
-   * Wait for all tasks to complete.
+   * Push a task belonging to a group for execution by the thread pool.
+   * @param task the task to execute
+   * @param group the group to which the task belongs, which must outlive the task
+   * @param node the NUMA node whose threads must execute the task, or -1 to let any thread execute it
+   */
+  void push(const std::function<void()> &task, TaskGroup &group, int node = -1);
+
+  /**
+   * Retrieve the number of NUMA nodes over which the threads are spread.
+   * @return the number of nodes, which is one if the pool is not NUMA-aware
+   */
+  int nNodes();
+
+  /**
+   * Retrieve the number of threads in the pool.
+   * @return the number of threads
+   */
+  int nThreads();
+
+  /**
+   * Wait for all tasks to complete, including the ones pushed by other users of a shared pool; use a task group to
+   * wait only for some of the tasks.
    */
   void synchronize();
+
+  /**
+   * Split a range of indices into one chunk per thread, process the chunks in
+   * parallel, and wait for all tasks to complete. Small ranges are processed by
+   * the calling thread.
+   * @param n the number of indices
+   * @param task the function processing the indices in [begin, end)
+   * @param min_chunk_size the smallest number of indices worth sending to a thread
+   */
+  void parallelFor(int n, const std::function<void(int, int)> &task, int min_chunk_size = 4096);
+
+ private:
+  /**
+   * Push a task for execution by the thread pool.
+   * @param task the task to execute
+   * @param group the group to which the task belongs, or nullptr if it belongs to none
+   * @param node the NUMA node whose threads must execute the task, or -1 to let any thread execute it
+   */
+  void pushTask(const std::function<void()> &task, TaskGroup *group, int node);
 };
 }  // namespace relab::helpers
 
@@ -26,6 +26,13 @@ torch::Device getDevice();
  * @return true if the tensors are equal, false otherwise
  */
 bool tensorsAreEqual(const torch::Tensor tensor_1, const torch::Tensor tensor_2);
+
+/**
+ * Compute the number of elements of the tensors having a shape.
+ * @param shape the shape of the tensors
+ * @return the number of elements
+ */
+int64_t nElements(const std::vector<int64_t> &shape);
 }  // namespace relab::helpers
 
 #endif  // RELAB_CPP_INC_HELPERS_TORCH_HPP_
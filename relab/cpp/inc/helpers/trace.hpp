@@ -0,0 +1,180 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+/**
+ * @file trace.hpp
+ * @brief Declaration of the classes recording execution spans in the Chrome trace format.
+ */
+
+#ifndef RELAB_CPP_INC_HELPERS_TRACE_HPP_
+#define RELAB_CPP_INC_HELPERS_TRACE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Record a span lasting until the end of the current scope, when tracing is enabled.
+ */
+#define RELAB_TRACE(name) relab::helpers::TraceSpan relab_trace_span(name)
+
+namespace relab::helpers {
+
+/**
+ * @brief A class storing a span, i.e., a named piece of code executed by a thread.
+ */
+class TraceEvent {
+ public:
+  // The name of the span, which must be a string literal.
+  const char *name;
+
+  // The index of the thread executing the span.
+  int thread;
+
+  // The start time and duration of the span in nanoseconds.
+  int64_t start;
+  int64_t duration;
+};
+
+/**
+ * @brief A slot of the tracer's ring buffer, storing a span and the number of
+ * spans recorded once it was written.
+ */
+class TraceSlot {
+ public:
+  TraceEvent event;
+  std::atomic<uint64_t> sequence;
+};
+
+/**
+ * @brief A class recording spans in a bounded ring buffer, and writing them in
+ * the Chrome trace format.
+ *
+ * @details
+ * The traces can be opened in chrome://tracing or in the Perfetto UI, where
+ * each thread has its own track. When the ring buffer is full, the oldest
+ * spans are overwritten, so tracing can be left enabled during long runs.
+ * When tracing is disabled, recording a span only costs an atomic load, and
+ * otherwise an atomic increment claiming a slot of the ring buffer, so that
+ * threads recording spans never wait for each other.
+ */
+class Tracer {
+ private:
+  std::atomic<bool> enabled;
+  std::chrono::time_point<std::chrono::steady_clock> start_time;
+
+  // The ring buffer storing the spans, and the total number of spans recorded. The mutex only serializes the
+  // functions (re)allocating or reading the ring buffer.
+  std::mutex events_mutex;
+  std::unique_ptr<TraceSlot[]> events;
+  uint64_t capacity;
+  std::atomic<uint64_t> n_events;
+
+  // The names of the threads, indexed by thread index. Thread indices are reused once their threads exit, so the
+  // table only grows with the number of threads alive at the same time.
+  std::map<int, std::string> thread_names;
+
+ public:
+  /**
+   * Create a disabled tracer.
+   */
+  Tracer();
+
+  /**
+   * Retrieve the tracer shared by the whole process.
+   * @return the tracer
+   */
+  static Tracer &global();
+
+  /**
+   * Start recording spans, previously recorded spans are discarded. Since the
+   * ring buffer is reallocated, tracing must be stopped while other threads may
+   * still be recording spans.
+   * @param capacity the maximum number of spans kept in memory, which must not
+   * be negative
+   */
+  void start(int capacity = 1000000);
+
+  /**
+   * Stop recording spans, the recorded spans can still be saved.
+   */
+  void stop();
+
+  /**
+   * Check whether spans are being recorded.
+   * @return true if spans are recorded, false otherwise
+   */
+  bool isEnabled() const;
+
+  /**
+   * Retrieve the number of nanoseconds elapsed since the tracer started.
+   * @return the current time
+   */
+  int64_t now() const;
+
+  /**
+   * Record a span.
+   * @param name the name of the span, which must be a string literal
+   * @param start the start time of the span in nanoseconds
+   * @param duration the duration of the span in nanoseconds
+   */
+  void record(const char *name, int64_t start, int64_t duration);
+
+  /**
+   * Name the thread calling this function in the traces.
+   * @param name the thread name
+   */
+  void setThreadName(const std::string &name);
+
+  /**
+   * Retrieve the index of the thread calling this function, which may be reused
+   * by another thread after this thread exits.
+   * @return the thread index
+   */
+  static int threadIndex();
+
+  /**
+   * Retrieve the spans kept in memory, from the oldest to the most recent.
+   * @return the spans
+   */
+  std::vector<TraceEvent> getEvents();
+
+  /**
+   * Convert the spans kept in memory to the Chrome trace format.
+   * @return a JSON string containing the trace
+   */
+  std::string toJson();
+
+  /**
+   * Save the spans kept in memory in the Chrome trace format.
+   * @param path the path of the JSON file to write
+   */
+  void save(const std::string &path);
+};
+
+/**
+ * @brief A class recording a span from its creation to its destruction.
+ */
+class TraceSpan {
+ private:
+  const char *name;
+  int64_t start_time;
+
+ public:
+  /**
+   * Start a span, if tracing is enabled.
+   * @param name the name of the span, which must be a string literal
+   */
+  explicit TraceSpan(const char *name);
+
+  /**
+   * End the span and record it, if tracing is enabled.
+   */
+  ~TraceSpan();
+};
+}  // namespace relab::helpers
+
+#endif  // RELAB_CPP_INC_HELPERS_TRACE_HPP_
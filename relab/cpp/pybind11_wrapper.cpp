@@ -4,16 +4,61 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "agents/memory/compressors.hpp"
 #include "agents/memory/experience.hpp"
 #include "agents/memory/replay_buffer.hpp"
+#include "agents/memory/replay_client.hpp"
+#include "agents/memory/shared_experience_queue.hpp"
+#include "agents/memory/sharded_replay_buffer.hpp"
+#include "helpers/trace.hpp"
 
 namespace py = pybind11;
 using namespace pybind11::literals;  // NOLINT
 using relab::agents::memory::CompressorType;
 using relab::agents::memory::Experience;
 using relab::agents::memory::ReplayBuffer;
+using relab::agents::memory::ReplayClient;
+using relab::agents::memory::SharedExperienceQueue;
+using relab::agents::memory::ShardedReplayBuffer;
+using relab::helpers::Tracer;
+
+/**
+ * Convert a tensor, a NumPy array, a DLPack capsule, or any object implementing the DLPack protocol into a float
+ * tensor. The memory of the input is shared with the tensor, unless its elements must be converted to floats.
+ * @param array the object to convert
+ * @return the tensor
+ */
+static torch::Tensor asTensor(const py::object &array) {
+  // Import the conversion functions on the first call only. They are never released, because the interpreter may be
+  // finalized before the static objects are destroyed. Since the imports may let another thread run, two threads can
+  // both import them, in which case one copy is simply leaked.
+  struct Converters {
+    py::object tensor_type;
+    py::object from_dlpack;
+    py::object from_numpy;
+    py::object as_array;
+  };
+  static const Converters *converters = nullptr;
+  if (converters == nullptr) {
+    py::module_ torch_module = py::module_::import("torch");
+    converters = new Converters{
+        torch_module.attr("Tensor"), py::module_::import("torch.utils.dlpack").attr("from_dlpack"),
+        torch_module.attr("from_numpy"), py::module_::import("numpy").attr("asarray")
+    };
+  }
+
+  torch::Tensor tensor;
+  if (py::isinstance(array, converters->tensor_type)) {
+    tensor = array.cast<torch::Tensor>();
+  } else if (PyCapsule_CheckExact(array.ptr()) || py::hasattr(array, "__dlpack__")) {
+    tensor = converters->from_dlpack(array).cast<torch::Tensor>();
+  } else {
+    tensor = converters->from_numpy(converters->as_array(array)).cast<torch::Tensor>();
+  }
+  return tensor.to(torch::kFloat32);
+}
 
 PYBIND11_MODULE(cpp, m) {
   m.doc() = "A module providing C++ acceleration for ReLab.";
@@ -25,11 +70,33 @@ PYBIND11_MODULE(cpp, m) {
       .def(
           py::init<torch::Tensor, int, float, bool, torch::Tensor>(), "obs"_a, "action"_a, "reward"_a, "done"_a,
           "next_obs"_a
+      )
+      .def_static(
+          "from_arrays",
+          [](const py::object &obs, int action, float reward, bool done, const py::object &next_obs, int n_frames) {
+            return Experience::fromNewestFrames(asTensor(obs), action, reward, done, asTensor(next_obs), n_frames);
+          },
+          "Create an experience from tensors, NumPy arrays or DLPack capsules without copying them, keeping only the "
+          "newest frames of the next observation.",
+          "obs"_a, "action"_a, "reward"_a, "done"_a, "next_obs"_a, "n_frames"_a = 1
       );
 
   py::enum_<CompressorType>(m_memory, "CompressorType")
       .value("RAW", CompressorType::RAW)
-      .value("ZLIB", CompressorType::ZLIB);
+      .value("ZLIB", CompressorType::ZLIB)
+      .value("DELTA", CompressorType::DELTA);
+
+  py::class_<SharedExperienceQueue>(m_memory, "SharedExperienceQueue")
+      .def(
+          py::init<const std::string &, int, int, int, bool>(), "name"_a, "capacity"_a = 1024, "stack_size"_a = 4,
+          "screen_size"_a = 84, "create"_a = true
+      )
+      .def(
+          "push", &SharedExperienceQueue::push, "Add an experience to the queue, return false if the queue is full.",
+          "experience"_a, "actor"_a = 0
+      )
+      .def("size", &SharedExperienceQueue::size, "Retrieve the number of experiences in the queue.")
+      .def("capacity", &SharedExperienceQueue::capacity, "Retrieve the number of experiences the queue can store.");
 
   py::class_<ReplayBuffer>(m_memory, "FastReplayBuffer")
       .def(
@@ -37,19 +104,89 @@ PYBIND11_MODULE(cpp, m) {
           "frame_skip"_a = 1, "stack_size"_a = 4, "screen_size"_a = 84, "type"_a = CompressorType::ZLIB
       )
       .def(
-          py::init<int, int, int, int, int, CompressorType, std::map<std::string, float>>(), "capacity"_a = 10000,
-          "batch_size"_a = 32, "frame_skip"_a = 1, "stack_size"_a = 4, "screen_size"_a = 84,
-          "type"_a = CompressorType::ZLIB, "args"_a
+          py::init<int, int, int, int, int, CompressorType, std::map<std::string, float>, const std::vector<int> &>(),
+          "capacity"_a = 10000, "batch_size"_a = 32, "frame_skip"_a = 1, "stack_size"_a = 4, "screen_size"_a = 84,
+          "type"_a = CompressorType::ZLIB, "args"_a, "cpu_affinity"_a = std::vector<int>()
       )
       .def("append", &ReplayBuffer::append, "Add an experience to the replay buffer.")
-      .def("sample", &ReplayBuffer::sample, "Sample a batch from the replay buffer.")
       .def(
-          "report", &ReplayBuffer::report,
+          "begin_episode",
+          [](ReplayBuffer &buffer, const py::object &initial_stack) { buffer.beginEpisode(asTensor(initial_stack)); },
+          "Begin a new episode, whose experiences are then added one frame at a time.", "initial_stack"_a
+      )
+      .def(
+          "append_step",
+          [](ReplayBuffer &buffer, const py::object &frame, int action, float reward, bool done) {
+            buffer.appendStep(asTensor(frame), action, reward, done);
+          },
+          "Add the next experience of the current episode, given only the newest frame of the next observation.",
+          "frame"_a, "action"_a, "reward"_a, "done"_a
+      )
+      .def("sample", py::overload_cast<>(&ReplayBuffer::sample), "Sample a batch from the replay buffer.")
+      .def(
+          "sample", py::overload_cast<int, int>(&ReplayBuffer::sample),
+          "Sample a batch whose observations stack every stride-th frame of the stored observations.", "stack_size"_a,
+          "stride"_a = 1
+      )
+      .def(
+          "report", py::overload_cast<torch::Tensor &>(&ReplayBuffer::report),
           "Report the loss associated with all the transitions of the "
           "previous batch."
       )
       .def("load", &ReplayBuffer::load, "Load a replay buffer from the filesystem.")
       .def("save", &ReplayBuffer::save, "Save the replay buffer on the filesystem.")
+      .def(
+          "report_all", &ReplayBuffer::reportAll,
+          "Report the loss associated with all the transitions in the buffer."
+      )
+      .def(
+          "drain", &ReplayBuffer::drain, "Move the experiences of a shared experience queue to the replay buffer.",
+          "queue"_a, "max_experiences"_a = -1
+      )
       .def("clear", &ReplayBuffer::clear, "Empty the replay buffer.")
-      .def("length", &ReplayBuffer::size, "Retrieve the number of elements in the buffer.");
+      .def("length", &ReplayBuffer::size, "Retrieve the number of elements in the buffer.")
+      .def("stats", &ReplayBuffer::stats, "Retrieve the latency statistics of the replay buffer operations.")
+      .def("memory_stats", &ReplayBuffer::memoryStats, "Retrieve the memory used by the replay buffer in bytes.");
+
+  py::class_<ShardedReplayBuffer>(m_memory, "FastShardedReplayBuffer")
+      .def(
+          py::init<
+              int, int, int, int, int, int, CompressorType, std::map<std::string, float>, const std::vector<int> &>(),
+          "n_shards"_a = 4, "capacity"_a = 10000, "batch_size"_a = 32, "frame_skip"_a = 1, "stack_size"_a = 4,
+          "screen_size"_a = 84, "type"_a = CompressorType::ZLIB, "args"_a = std::map<std::string, float>(),
+          "cpu_affinity"_a = std::vector<int>()
+      )
+      .def(
+          "append", &ShardedReplayBuffer::append, "Add an experience to the shard of an actor.", "experience"_a,
+          "actor"_a = 0
+      )
+      .def(
+          "drain", &ShardedReplayBuffer::drain,
+          "Move the experiences of a shared experience queue to the shards of their actors.", "queue"_a,
+          "max_experiences"_a = -1
+      )
+      .def("sample", &ShardedReplayBuffer::sample, "Sample a batch from the replay buffer.")
+      .def("report", &ShardedReplayBuffer::report, "Report the loss associated with the previous batch.")
+      .def("clear", &ShardedReplayBuffer::clear, "Empty the replay buffer.")
+      .def("length", &ShardedReplayBuffer::size, "Retrieve the number of elements in the buffer.");
+
+  py::class_<ReplayClient>(m_memory, "ReplayClient")
+      .def(py::init<const std::string &>(), "socket_path"_a)
+      .def("append", &ReplayClient::append, "Add experiences to the replay buffer, without waiting for the server.")
+      .def("request_sample", &ReplayClient::requestSample, "Request a batch, without waiting for the server.")
+      .def("receive_sample", &ReplayClient::receiveSample, "Receive the oldest batch requested.")
+      .def("sample", &ReplayClient::sample, "Sample a batch from the replay buffer.")
+      .def("report", &ReplayClient::report, "Report the loss associated with the oldest unreported batch.")
+      .def("length", &ReplayClient::size, "Retrieve the number of elements in the buffer.");
+
+  auto m_helpers = m.def_submodule("helpers", "A module containing C++ helper functions.");
+  m_helpers.def(
+      "start_tracing", [](int capacity) { Tracer::global().start(capacity); },
+      "Start recording spans in a ring buffer of the given capacity.", "capacity"_a = 1000000
+  );
+  m_helpers.def("stop_tracing", []() { Tracer::global().stop(); }, "Stop recording spans.");
+  m_helpers.def(
+      "save_trace", [](const std::string &path) { Tracer::global().save(path); },
+      "Save the recorded spans in the Chrome trace format.", "path"_a
+  );
 }
@@ -0,0 +1,110 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <torch/extension.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "agents/memory/compressors.hpp"
+#include "agents/memory/replay_buffer.hpp"
+#include "agents/memory/replay_server.hpp"
+#include "helpers/debug.hpp"
+
+using namespace relab::agents::memory;
+using namespace relab::helpers;
+
+// The server stopped by the signal handler.
+static ReplayServer *server = nullptr;
+
+/**
+ * Stop the server when the process is interrupted or terminated.
+ * @param signal the signal received
+ */
+static void handleSignal(int signal) {
+  if (server != nullptr) {
+    server->stop();
+  }
+}
+
+/**
+ * Display how to use the replay server.
+ */
+static void printUsage() {
+  std::cout << "Usage: relab_replay_server --socket PATH [--capacity N] [--batch_size N] [--frame_skip N] "
+            << "[--stack_size N] [--screen_size N] [--type raw|zlib|delta] [--KEY VALUE]..." << std::endl
+            << "Any other key is forwarded to the replay buffer arguments, e.g., --omega 0.7 or --n_steps 3."
+            << std::endl;
+}
+
+/**
+ * Serve a replay buffer to the actors and learners running in other processes.
+ * The options are passed as pairs of the form "--key value".
+ */
+int main(int argc, char *argv[]) {
+  // Parse the command line options.
+  std::map<std::string, std::string> options = {{"socket", ""},       {"capacity", "10000"}, {"batch_size", "32"},
+                                                {"frame_skip", "1"}, {"stack_size", "4"},   {"screen_size", "84"},
+                                                {"type", "zlib"}};
+  std::map<std::string, float> args;
+  for (int i = 1; i < argc; i += 2) {
+    std::string key = argv[i];
+    if (key.rfind("--", 0) != 0 || i + 1 >= argc) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+    key = key.substr(2);
+    if (options.find(key) != options.end()) {
+      options[key] = argv[i + 1];
+      continue;
+    }
+    try {
+      args[key] = std::stof(argv[i + 1]);
+    } catch (const std::exception &) {
+      std::cerr << "Invalid value for --" << key << ": " << argv[i + 1] << std::endl;
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+  if (options["socket"] == "") {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+  std::map<std::string, CompressorType> types = {
+      {"raw", CompressorType::RAW}, {"zlib", CompressorType::ZLIB}, {"delta", CompressorType::DELTA}
+  };
+  if (types.find(options["type"]) == types.end()) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  // Parse the integer options.
+  std::map<std::string, int> sizes;
+  for (auto key : {"capacity", "batch_size", "frame_skip", "stack_size", "screen_size"}) {
+    try {
+      sizes[key] = std::stoi(options[key]);
+    } catch (const std::exception &) {
+      std::cerr << "Invalid value for --" << key << ": " << options[key] << std::endl;
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Create the replay buffer and serve it until the process is interrupted.
+  auto buffer = std::make_shared<ReplayBuffer>(
+      sizes["capacity"], sizes["batch_size"], sizes["frame_skip"], sizes["stack_size"], sizes["screen_size"],
+      types[options["type"]], args
+  );
+  ReplayServer replay_server(options["socket"], buffer);
+  server = &replay_server;
+  std::signal(SIGINT, handleSignal);
+  std::signal(SIGTERM, handleSignal);
+  logging.info("Replay server listening on: " + options["socket"]);
+  replay_server.serve();
+  server = nullptr;
+  return EXIT_SUCCESS;
+}
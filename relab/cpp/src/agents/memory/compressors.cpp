@@ -2,9 +2,18 @@
 
 #include "agents/memory/compressors.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
 
 #include "agents/memory/replay_buffer.hpp"
+#include "helpers/serialize.hpp"
+#include "helpers/torch.hpp"
+
+using namespace relab::helpers;
 
 namespace relab::agents::memory {
 
@@ -13,15 +22,39 @@ namespace relab::agents::memory {
  */
 
 std::unique_ptr<Compressor> Compressor::create(int height, int width, CompressorType type) {
+  return Compressor::create(std::vector<int64_t>{height, width}, type);
+}
+
+std::unique_ptr<Compressor> Compressor::create(const std::vector<int64_t> &shape, CompressorType type) {
   if (type == CompressorType::RAW) {
-    return std::make_unique<NoCompression>(height, width);
+    return std::make_unique<NoCompression>(shape);
+  } else if (type == CompressorType::DELTA) {
+    return std::make_unique<DeltaCompressor>(shape);
   } else {
-    return std::make_unique<ZCompressor>(height, width);
+    return std::make_unique<ZCompressor>(shape);
   }
 }
 
 Compressor::~Compressor() {}
 
+int Compressor::keyframeDistance(const torch::Tensor &tensor) { return 0; }
+
+void Compressor::reset() {}
+
+void Compressor::train(const std::vector<torch::Tensor> &frames) {}
+
+bool Compressor::isTrained() { return false; }
+
+void Compressor::load(std::istream &checkpoint) {
+  // Check that the frames of the checkpoint were encoded by a compressor of the same type.
+  auto type = static_cast<CompressorType>(load_value<int>(checkpoint));
+  if (type != this->getType()) {
+    throw std::runtime_error("The checkpoint was saved with a different type of compression.");
+  }
+}
+
+void Compressor::save(std::ostream &checkpoint) { save_value(static_cast<int>(this->getType()), checkpoint); }
+
 int Compressor::size_of(const torch::Tensor &tensor) const {
   return tensor.numel() * torch::elementSize(torch::typeMetaToScalarType(tensor.dtype()));
 }
@@ -30,7 +63,9 @@ int Compressor::size_of(const torch::Tensor &tensor) const {
  * Implementation of the NoCompressor methods.
  */
 
-NoCompression::NoCompression(int height, int width) { this->uncompressed_size = height * width * sizeof(float); }
+NoCompression::NoCompression(const std::vector<int64_t> &shape) {
+  this->uncompressed_size = nElements(shape) * sizeof(float);
+}
 
 NoCompression::~NoCompression() {}
 
@@ -42,44 +77,63 @@ void NoCompression::decode(const torch::Tensor &input, float *output) {
   std::memcpy((void *)output, input.data_ptr(), this->uncompressed_size);
 }
 
+CompressorType NoCompression::getType() { return CompressorType::RAW; }
+
 /**
- * Implementation of the ZCompressor methods.
+ * Implementation of the ZContext methods.
  */
 
-ZCompressor::ZCompressor(int height, int width) {
+ZContext::ZContext() {
   // Initialize the zlib deflate stream.
   this->deflate_stream.zalloc = Z_NULL;
   this->deflate_stream.zfree = Z_NULL;
   this->deflate_stream.opaque = Z_NULL;
+  deflateInit(&this->deflate_stream, Z_BEST_COMPRESSION);
 
-  // Pre-compute uncompressed tensor shape, size and number of dimensions.
-  this->shape.push_back(height);
-  this->shape.push_back(width);
-  this->uncompressed_size = height * width * sizeof(float);
-  this->n_dims = 2;
+  // Initialize the zlib inflate stream.
+  this->inflate_stream.zalloc = Z_NULL;
+  this->inflate_stream.zfree = Z_NULL;
+  this->inflate_stream.opaque = Z_NULL;
+  this->inflate_stream.avail_in = 0;
+  this->inflate_stream.next_in = Z_NULL;
+  inflateInit(&this->inflate_stream);
+}
 
-  // Allocate the buffer storing the compressed tensor.
-  this->max_compressed_size = this->uncompressed_size + (this->n_dims + 1) * sizeof(int);
-  this->compressed_output.resize(this->max_compressed_size / sizeof(float));
+ZContext::~ZContext() {
+  deflateEnd(&this->deflate_stream);
+  inflateEnd(&this->inflate_stream);
 }
 
-ZCompressor::~ZCompressor() {}
+void ZContext::reserve(int uncompressed_size, int max_compressed_size) {
+  // The buffers only grow, so a thread alternating between compressors of different sizes never reallocates them.
+  size_t output_size = max_compressed_size / sizeof(float) + 1;
+  if (this->compressed_output.size() < output_size) {
+    this->compressed_output.resize(output_size);
+  }
+  size_t scratch_size = uncompressed_size / sizeof(uint32_t);
+  if (this->scratch.size() < scratch_size) {
+    this->scratch.resize(scratch_size);
+  }
+}
 
-torch::Tensor ZCompressor::encode(const torch::Tensor &input) {
-  // Setup the deflate stream.
-  this->deflate_stream.avail_in = (uInt)this->uncompressed_size;
-  this->deflate_stream.next_in = (Bytef *)input.data_ptr();
-  this->deflate_stream.avail_out = (uInt)this->max_compressed_size;
-  this->deflate_stream.next_out = (Bytef *)this->compressed_output.data();
+/**
+ * Implementation of the ZCompressor methods.
+ */
 
-  // Perform the actual compression work.
-  deflateInit(&this->deflate_stream, Z_BEST_COMPRESSION);
-  deflate(&this->deflate_stream, Z_FINISH);
-  deflateEnd(&this->deflate_stream);
+ZCompressor::ZCompressor(const std::vector<int64_t> &shape) : shape(shape) {
+  // Pre-compute uncompressed tensor size and number of dimensions. Multi-channel images are compressed channel by
+  // channel, i.e., one plane after the other, which keeps the runs of identical values of each channel contiguous.
+  this->uncompressed_size = nElements(shape) * sizeof(float);
+  this->n_dims = static_cast<int>(shape.size());
+
+  // Compute the size of the buffer storing the compressed tensor, including room for a header.
+  this->max_compressed_size = compressBound(this->uncompressed_size) + (this->n_dims + 1) * sizeof(int);
+}
+
+ZCompressor::~ZCompressor() {}
 
-  // Return the compressed tensor.
-  int compressed_size = ((char *)this->deflate_stream.next_out - (char *)this->compressed_output.data()) / sizeof(int);
-  return torch::from_blob(this->compressed_output.data(), {compressed_size}).clone();
+torch::Tensor ZCompressor::encode(const torch::Tensor &input) {
+  return this->deflateBuffer(this->getContext(), input.data_ptr());
 }
 
 torch::Tensor ZCompressor::decode(const torch::Tensor &input) {
@@ -89,21 +143,200 @@ torch::Tensor ZCompressor::decode(const torch::Tensor &input) {
 }
 
 void ZCompressor::decode(const torch::Tensor &input, float *output) {
-  // Initialize the zlib inflate stream.
-  z_stream inflate_stream;
-  inflate_stream.zalloc = Z_NULL;
-  inflate_stream.zfree = Z_NULL;
-  inflate_stream.opaque = Z_NULL;
-
-  // Setup the inflate stream used for decompression.
-  inflate_stream.avail_in = (uInt)this->size_of(input);
-  inflate_stream.next_in = (Bytef *)input.data_ptr();
-  inflate_stream.avail_out = (uInt)this->uncompressed_size;
-  inflate_stream.next_out = (Bytef *)output;
-
-  // Perform the actual decompression work.
-  inflateInit(&inflate_stream);
-  inflate(&inflate_stream, Z_NO_FLUSH);
-  inflateEnd(&inflate_stream);
+  this->inflateBuffer(this->getContext(), input.data_ptr(), this->size_of(input), output);
+}
+
+CompressorType ZCompressor::getType() { return CompressorType::ZLIB; }
+
+void ZCompressor::train(const std::vector<torch::Tensor> &frames) {
+  if (frames.size() == 0) {
+    return;
+  }
+
+  // Retrieve the pixels of all the sample frames.
+  std::vector<torch::Tensor> samples;
+  std::vector<const float *> pixels;
+  for (auto frame : frames) {
+    samples.push_back(frame.contiguous());
+    pixels.push_back(samples.back().data_ptr<float>());
+  }
+
+  // Compute the median of each pixel, which removes the moving sprites while
+  // keeping the static parts of the screen. Since zlib only uses the end of
+  // the dictionary that fits in its window, only the last pixels are kept.
+  int n_pixels = this->uncompressed_size / sizeof(float);
+  int first_pixel = std::max(n_pixels - MAX_DICTIONARY_SIZE / static_cast<int>(sizeof(float)), 0);
+  int median_index = static_cast<int>(frames.size()) / 2;
+  std::vector<float> values(frames.size());
+  std::vector<float> median(n_pixels - first_pixel);
+  for (auto i = first_pixel; i < n_pixels; i++) {
+    for (size_t j = 0; j < pixels.size(); j++) {
+      values[j] = pixels[j][i];
+    }
+    std::nth_element(values.begin(), values.begin() + median_index, values.end());
+    median[i - first_pixel] = values[median_index];
+  }
+
+  // Use the median frame as the preset dictionary.
+  char *median_ptr = (char *)median.data();
+  this->dictionary.assign(median_ptr, median_ptr + median.size() * sizeof(float));
+}
+
+bool ZCompressor::isTrained() { return this->dictionary.size() != 0; }
+
+void ZCompressor::reset() { this->dictionary.clear(); }
+
+void ZCompressor::load(std::istream &checkpoint) {
+  Compressor::load(checkpoint);
+  if (load_value<bool>(checkpoint) == true) {
+    this->dictionary = load_vector<char>(checkpoint);
+  } else {
+    this->dictionary.clear();
+  }
+}
+
+void ZCompressor::save(std::ostream &checkpoint) {
+  Compressor::save(checkpoint);
+  save_value(this->isTrained(), checkpoint);
+  if (this->isTrained() == true) {
+    save_vector(this->dictionary, checkpoint);
+  }
+}
+
+ZContext &ZCompressor::getContext() {
+  thread_local ZContext context;
+  context.reserve(this->uncompressed_size, this->max_compressed_size);
+  return context;
+}
+
+torch::Tensor ZCompressor::deflateBuffer(ZContext &context, const void *input, int header_size) {
+  // Reset the deflate stream, the preset dictionary must be provided again after each reset.
+  z_stream &stream = context.deflate_stream;
+  if (deflateReset(&stream) != Z_OK) {
+    throw std::runtime_error("Could not reset the zlib compression stream.");
+  }
+  if (this->dictionary.size() != 0 &&
+      deflateSetDictionary(&stream, (const Bytef *)this->dictionary.data(), this->dictionary.size()) != Z_OK) {
+    throw std::runtime_error("Could not set the preset dictionary of the zlib compression stream.");
+  }
+
+  // Setup the deflate stream.
+  char *output = (char *)context.compressed_output.data();
+  stream.avail_in = (uInt)this->uncompressed_size;
+  stream.next_in = (Bytef *)input;
+  stream.avail_out = (uInt)this->max_compressed_size - header_size;
+  stream.next_out = (Bytef *)(output + header_size);
+
+  // Perform the actual compression work, the output buffer being large enough to compress the whole frame at once.
+  if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+    throw std::runtime_error("Could not compress the frame with zlib.");
+  }
+
+  // Return the compressed tensor, rounding its size up to keep the end of the zlib stream.
+  int compressed_size = ((char *)stream.next_out - output + sizeof(float) - 1) / sizeof(float);
+  return torch::from_blob(context.compressed_output.data(), {compressed_size}).clone();
+}
+
+void ZCompressor::inflateBuffer(ZContext &context, const void *input, int input_size, void *output) {
+  // Reset the inflate stream used for decompression.
+  z_stream &stream = context.inflate_stream;
+  if (inflateReset(&stream) != Z_OK) {
+    throw std::runtime_error("Could not reset the zlib decompression stream.");
+  }
+  stream.avail_in = (uInt)input_size;
+  stream.next_in = (Bytef *)input;
+  stream.avail_out = (uInt)this->uncompressed_size;
+  stream.next_out = (Bytef *)output;
+
+  // Perform the actual decompression work, providing the preset dictionary if
+  // the frame was compressed with it.
+  int status = inflate(&stream, Z_NO_FLUSH);
+  if (status == Z_NEED_DICT) {
+    if (this->dictionary.size() == 0) {
+      throw std::runtime_error("The frame was compressed with a preset dictionary, but the compressor has none.");
+    }
+    if (inflateSetDictionary(&stream, (const Bytef *)this->dictionary.data(), this->dictionary.size()) != Z_OK) {
+      throw std::runtime_error("The frame was compressed with another preset dictionary than the compressor's.");
+    }
+    status = inflate(&stream, Z_NO_FLUSH);
+  }
+  if (status != Z_STREAM_END) {
+    throw std::runtime_error("Could not decompress the frame with zlib, the frame may be corrupted.");
+  }
+}
+
+/**
+ * Implementation of the DeltaCompressor methods.
+ */
+
+DeltaCompressor::DeltaCompressor(const std::vector<int64_t> &shape, int keyframe_interval) :
+    ZCompressor(shape), keyframe_interval(keyframe_interval),
+    n_pixels(static_cast<int>(nElements(shape))), distance(0),
+    previous_frame(n_pixels) {}
+
+DeltaCompressor::~DeltaCompressor() {}
+
+torch::Tensor DeltaCompressor::encode(const torch::Tensor &input) {
+  // Frames depend on the previously encoded frame, so they are encoded one at a time.
+  std::lock_guard<std::mutex> lock(this->encode_mutex);
+  ZContext &context = this->getContext();
+
+  // XOR the frame with the previous frame, unless the frame is a keyframe.
+  const uint32_t *frame = (const uint32_t *)input.data_ptr();
+  const void *payload = frame;
+  if (this->distance != 0) {
+    uint32_t *delta = context.scratch.data();
+    for (auto i = 0; i < this->n_pixels; i++) {
+      delta[i] = frame[i] ^ this->previous_frame[i];
+    }
+    payload = delta;
+  }
+  std::memcpy(this->previous_frame.data(), frame, this->n_pixels * sizeof(uint32_t));
+
+  // Compress the frame, and store the distance to its keyframe in the header.
+  torch::Tensor output = this->deflateBuffer(context, payload, sizeof(int));
+  std::memcpy(output.data_ptr(), &this->distance, sizeof(int));
+  this->distance = (this->distance + 1) % this->keyframe_interval;
+  return output;
+}
+
+torch::Tensor DeltaCompressor::decode(const torch::Tensor &input) {
+  // The other frames are the difference with the previous frame, which is not available here.
+  if (this->keyframeDistance(input) != 0) {
+    throw std::runtime_error("Only keyframes can be decoded without the previous frame.");
+  }
+  return this->ZCompressor::decode(input);
+}
+
+void DeltaCompressor::decode(const torch::Tensor &input, float *output) {
+  // Decompress the keyframes directly in the output buffer.
+  const char *payload = (const char *)input.data_ptr() + sizeof(int);
+  int payload_size = this->size_of(input) - sizeof(int);
+  ZContext &context = this->getContext();
+  if (this->keyframeDistance(input) == 0) {
+    this->inflateBuffer(context, payload, payload_size, output);
+    return;
+  }
+
+  // Otherwise, decompress the difference and apply it to the previous frame.
+  uint32_t *delta = context.scratch.data();
+  this->inflateBuffer(context, payload, payload_size, delta);
+  uint32_t *frame = (uint32_t *)output;
+  for (auto i = 0; i < this->n_pixels; i++) {
+    frame[i] ^= delta[i];
+  }
+}
+
+CompressorType DeltaCompressor::getType() { return CompressorType::DELTA; }
+
+int DeltaCompressor::keyframeDistance(const torch::Tensor &tensor) {
+  int distance;
+  std::memcpy(&distance, tensor.data_ptr(), sizeof(int));
+  return distance;
+}
+
+void DeltaCompressor::reset() {
+  this->ZCompressor::reset();
+  this->distance = 0;
 }
 }  // namespace relab::agents::memory
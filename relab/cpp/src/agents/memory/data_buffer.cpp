@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -18,8 +19,10 @@ using namespace relab::helpers;
 
 namespace relab::agents::memory::impl {
 
-DataBuffer::DataBuffer(int capacity, int n_steps, float gamma, float initial_priority, int n_children) :
-    past_actions(n_steps), past_rewards(n_steps), past_dones(n_steps), device(getDevice()) {
+DataBuffer::DataBuffer(
+    int capacity, int n_steps, float gamma, float initial_priority, int n_children, SumTreeType sum_tree_type,
+    PrioritizationType prioritization, float omega
+) : past_actions(n_steps), past_rewards(n_steps), past_dones(n_steps), device(getDevice()) {
   // Store the data buffer's parameters.
   this->capacity = capacity;
   this->n_steps = n_steps;
@@ -31,7 +34,9 @@ DataBuffer::DataBuffer(int capacity, int n_steps, float gamma, float initial_pri
   this->dones = torch::zeros({capacity}, at::kBool).to(this->device);
 
   // The priorities associated with all experiences in the replay buffer.
-  this->priorities = std::make_unique<PriorityTree>(capacity, initial_priority, n_children);
+  this->priorities = std::make_unique<PriorityTree>(
+      capacity, initial_priority, n_children, sum_tree_type, prioritization, omega
+  );
 
   // The index of the next datum to add in the buffer.
   this->current_id = 0;
@@ -70,14 +75,18 @@ void DataBuffer::append(const Experience &experience) {
 }
 
 std::tuple<torch::Tensor, torch::Tensor, torch::Tensor> DataBuffer::operator[](torch::Tensor &indices) {
+  // The indices of the caller are left unchanged, since they are also used to report the loss of the experiences.
+  torch::Tensor slots = indices;
   if (this->current_id >= this->capacity) {
-    indices = torch::remainder(indices + this->current_id, this->capacity);
+    slots = torch::remainder(indices + this->current_id, this->capacity);
   }
-  return std::make_tuple(this->actions.index({indices}), this->rewards.index({indices}), this->dones.index({indices}));
+  return std::make_tuple(this->actions.index({slots}), this->rewards.index({slots}), this->dones.index({slots}));
 }
 
 int DataBuffer::size() { return std::min(this->current_id, this->capacity); }
 
+int DataBuffer::nEvicted() { return std::max(this->current_id - this->capacity, 0); }
+
 void DataBuffer::clear() {
   this->past_actions.clear();
   this->past_rewards.clear();
@@ -89,6 +98,12 @@ void DataBuffer::clear() {
   this->current_id = 0;
 }
 
+void DataBuffer::endEpisode() {
+  this->past_actions.clear();
+  this->past_rewards.clear();
+  this->past_dones.clear();
+}
+
 void DataBuffer::addDatum(int action, float reward, bool done) {
   int index = this->current_id % this->capacity;
   this->actions.index_put_({index}, action);
@@ -100,7 +115,7 @@ void DataBuffer::addDatum(int action, float reward, bool done) {
 
 std::unique_ptr<PriorityTree> &DataBuffer::getPriorities() { return this->priorities; }
 
-void DataBuffer::load(std::istream &checkpoint) {
+void DataBuffer::load(std::istream &checkpoint, bool compressed, int version) {
   // Load the data buffer from the checkpoint.
   this->capacity = load_value<int>(checkpoint);
   this->n_steps = load_value<int>(checkpoint);
@@ -108,14 +123,20 @@ void DataBuffer::load(std::istream &checkpoint) {
   this->past_actions.load(checkpoint);
   this->past_rewards.load(checkpoint);
   this->past_dones.load(checkpoint);
-  this->actions = load_tensor<int>(checkpoint);
-  this->rewards = load_tensor<float>(checkpoint);
-  this->dones = load_tensor<bool>(checkpoint);
-  this->priorities->load(checkpoint);
+  if (compressed == true) {
+    this->actions = load_compressed_tensor<int>(checkpoint);
+    this->rewards = load_compressed_tensor<float>(checkpoint);
+    this->dones = load_compressed_tensor<bool>(checkpoint);
+  } else {
+    this->actions = load_tensor<int>(checkpoint);
+    this->rewards = load_tensor<float>(checkpoint);
+    this->dones = load_tensor<bool>(checkpoint);
+  }
+  this->priorities->load(checkpoint, compressed, version);
   this->current_id = load_value<int>(checkpoint);
 }
 
-void DataBuffer::save(std::ostream &checkpoint) {
+void DataBuffer::save(std::ostream &checkpoint, bool compressed) {
   // Save the data buffer in the checkpoint.
   save_value(this->capacity, checkpoint);
   save_value(this->n_steps, checkpoint);
@@ -123,13 +144,26 @@ void DataBuffer::save(std::ostream &checkpoint) {
   this->past_actions.save(checkpoint);
   this->past_rewards.save(checkpoint);
   this->past_dones.save(checkpoint);
-  save_tensor<int>(this->actions, checkpoint);
-  save_tensor<float>(this->rewards, checkpoint);
-  save_tensor<bool>(this->dones, checkpoint);
-  this->priorities->save(checkpoint);
+  if (compressed == true) {
+    save_compressed_tensor<int>(this->actions, checkpoint);
+    save_compressed_tensor<float>(this->rewards, checkpoint);
+    save_compressed_tensor<bool>(this->dones, checkpoint);
+  } else {
+    save_tensor<int>(this->actions, checkpoint);
+    save_tensor<float>(this->rewards, checkpoint);
+    save_tensor<bool>(this->dones, checkpoint);
+  }
+  this->priorities->save(checkpoint, compressed);
   save_value(this->current_id, checkpoint);
 }
 
+std::map<std::string, double> DataBuffer::memoryStats() {
+  return {
+      {"data", this->actions.nbytes() + this->rewards.nbytes() + this->dones.nbytes()},
+      {"priority_trees", this->priorities->memoryUsage()},
+  };
+}
+
 void DataBuffer::print(bool verbose, const std::string &prefix) {
   // Display the most important information about the data buffer.
   std::cout << "DataBuffer[capacity: " << this->capacity << ", n_steps: " << this->n_steps << ", gamma: " << this->gamma
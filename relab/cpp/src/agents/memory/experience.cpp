@@ -2,6 +2,8 @@
 
 #include "agents/memory/experience.hpp"
 
+#include <algorithm>
+
 namespace relab::agents::memory {
 
 Experience::Experience(torch::Tensor obs, int action, float reward, bool done, torch::Tensor next_obs) {
@@ -11,4 +13,11 @@ Experience::Experience(torch::Tensor obs, int action, float reward, bool done, t
   this->done = done;
   this->next_obs = next_obs;
 }
+
+Experience Experience::fromNewestFrames(
+    torch::Tensor obs, int action, float reward, bool done, torch::Tensor next_obs, int n_frames
+) {
+  int n_kept = std::min(std::max(n_frames, 1), static_cast<int>(next_obs.size(0)));
+  return Experience(obs, action, reward, done, next_obs.narrow(0, next_obs.size(0) - n_kept, n_kept));
+}
 }  // namespace relab::agents::memory
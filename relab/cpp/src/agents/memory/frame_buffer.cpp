@@ -3,17 +3,26 @@
 #include "agents/memory/frame_buffer.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <tuple>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "agents/memory/replay_buffer.hpp"
 #include "helpers/debug.hpp"
+#include "helpers/hash.hpp"
+#include "helpers/numa.hpp"
 #include "helpers/serialize.hpp"
+#include "helpers/stats.hpp"
 #include "helpers/timer.hpp"
 #include "helpers/torch.hpp"
+#include "helpers/trace.hpp"
 
 using namespace torch::indexing;
 using namespace relab::helpers;
@@ -21,10 +30,26 @@ using namespace relab::helpers;
 namespace relab::agents::memory::impl {
 
 FrameBuffer::FrameBuffer(
-    int capacity, int frame_skip, int n_steps, int stack_size, int screen_size, CompressorType type, int n_threads
+    int capacity, int frame_skip, int n_steps, int stack_size, int screen_size, CompressorType type, int n_threads,
+    int dedup_window, int dictionary_frames, bool numa, const std::vector<int> &cpus, bool shared_pool
+) :
+    FrameBuffer(
+        capacity, frame_skip, n_steps, stack_size, std::vector<int64_t>{screen_size, screen_size}, type, n_threads,
+        dedup_window, dictionary_frames, numa, cpus, shared_pool
+    ) {}
+
+FrameBuffer::FrameBuffer(
+    int capacity, int frame_skip, int n_steps, int stack_size, const std::vector<int64_t> &frame_shape,
+    CompressorType type, int n_threads, int dedup_window, int dictionary_frames, bool numa,
+    const std::vector<int> &cpus, bool shared_pool
 ) :
     device(getDevice()), frame_skip(frame_skip), stack_size(stack_size), capacity(capacity), n_steps(n_steps),
-    screen_size(screen_size), frames(FrameStorage(capacity)), past_references(n_steps + 1), pool(n_threads) {
+    frame_shape(frame_shape), frames(FrameStorage(capacity)), past_references(n_steps + 1),
+    pool(
+        (shared_pool == true) ? ThreadPool::shared(n_threads, numa, cpus)
+                              : std::make_shared<ThreadPool>(n_threads, numa, cpus)
+    ),
+    arena_node(0), dedup_window(dedup_window), dictionary_frames(dictionary_frames) {
   // A list storing the observation references of each experience.
   std::vector<int> references_t(capacity);
   this->references_t = std::move(references_t);
@@ -32,28 +57,65 @@ FrameBuffer::FrameBuffer(
   this->references_tn = std::move(references_tn);
   this->current_ref = 0;
 
+  // Check the shape of the frames, and compute their number of pixels.
+  if (frame_shape.size() != 2 && frame_shape.size() != 3) {
+    throw std::runtime_error("The frames must have a shape (height, width) or (channels, height, width).");
+  }
+  this->frame_size = static_cast<int>(nElements(frame_shape));
+
   // Create the compressor used to compress and decompress the tensors.
-  this->png = Compressor::create(screen_size, screen_size, type);
+  this->png = Compressor::create(frame_shape, type);
+  if (type == CompressorType::DELTA) {
+    this->dedup_window = 0;
+  }
+  if (type == CompressorType::RAW) {
+    this->dictionary_frames = 0;
+  }
 
   // A boolean keeping track of whether the next experience is the beginning of
   // a new episode.
   this->new_episode = true;
+
+  // The window of recently stored frames used for deduplication.
+  this->clearRecentFrames();
 }
 
 void FrameBuffer::append(const Experience &experience) {
+  // The observation at time t + 1 may only contain its newest frames, i.e., the only frames added to the buffer.
+  int n = std::min(this->frame_skip, this->stack_size);
+  if (experience.next_obs.size(0) < n) {
+    throw std::runtime_error("The next observation must contain at least min(frame_skip, stack_size) frames.");
+  }
+
   // If the buffer is full, remove the oldest observation frames from the
   // buffer.
   if (this->size() == this->capacity) {
+    // Keep the keyframe required to decode the oldest frame that remains in
+    // the buffer.
     int first_frame_index = this->references_t[this->firstReference() % this->capacity];
-    while (this->frames.top_index() <= first_frame_index) {
+    int first_kept_index = first_frame_index + 1;
+    if (first_kept_index <= this->frames.last_frame_index) {
+      first_kept_index -= this->png->keyframeDistance(this->frames[first_kept_index]);
+    }
+    while (this->frames.top_index() < first_kept_index) {
       this->frames.pop();
     }
   }
 
+  // When the thread pool is NUMA-aware, allocate the frames of each episode on the next node, so that the frames and
+  // their decoding are spread over all nodes. The caller's memory policy is restored when this function returns.
+  std::optional<NodePreference> preference;
+  if (this->pool->nNodes() != 1) {
+    if (this->new_episode == true) {
+      this->arena_node = (this->arena_node + 1) % this->pool->nNodes();
+    }
+    preference.emplace(NumaTopology::global(), this->arena_node);
+  }
+
   // Add the frames of the observation at time t, if needed.
   if (this->new_episode == true) {
     for (auto i = 0; i < this->stack_size; i++) {
-      int reference = this->addFrame(this->encode(experience.obs.index({i, Slice(), Slice()}).detach().clone()));
+      int reference = this->addRawFrame(this->planarFrame(experience.obs[i]));
       if (i == 0) {
         this->past_references.push_back(reference);
       }
@@ -61,9 +123,8 @@ void FrameBuffer::append(const Experience &experience) {
   }
 
   // Add the frames of the observation at time t + 1.
-  int n = std::min(this->frame_skip, this->stack_size);
   for (auto i = n; i >= 1; i--) {
-    int reference = this->addFrame(this->encode(experience.next_obs.index({-i, Slice(), Slice()}).detach().clone()));
+    int reference = this->addRawFrame(this->planarFrame(experience.next_obs[-i]));
     if (i == 1) {
       this->past_references.push_back(reference + 1 - this->stack_size);
     }
@@ -93,12 +154,30 @@ void FrameBuffer::append(const Experience &experience) {
 }
 
 std::tuple<torch::Tensor, torch::Tensor> FrameBuffer::operator[](const torch::Tensor &indices) {
-  int n_elements = indices.numel();
-  torch::Tensor obs_batch = torch::zeros({n_elements, this->stack_size, this->screen_size, this->screen_size});
-  torch::Tensor next_obs_batch = torch::zeros({n_elements, this->stack_size, this->screen_size, this->screen_size});
+  return this->getObservations(indices, this->stack_size);
+}
+
+std::tuple<torch::Tensor, torch::Tensor>
+FrameBuffer::getObservations(const torch::Tensor &indices, int n_frames, int stride) {
+  RELAB_TRACE("FrameBuffer::getObservations");
+
+  // Check that the stacked frames are among the frames of the stored observations.
+  if (n_frames < 1 || stride < 1 || (n_frames - 1) * stride >= this->stack_size) {
+    throw std::runtime_error(
+        "The stacked frames must be among the " + std::to_string(this->stack_size) + " frames of the observations."
+    );
+  }
 
-  // Retrieve the all the decoded observations.
-  int frame_size = this->screen_size * this->screen_size;
+  // Each observation is a stack of frames, i.e., the batches have a shape (n_elements, n_frames, *frame_shape).
+  int n_elements = indices.numel();
+  std::vector<int64_t> batch_shape = {n_elements, n_frames};
+  batch_shape.insert(batch_shape.end(), this->frame_shape.begin(), this->frame_shape.end());
+  torch::Tensor obs_batch = torch::zeros(batch_shape);
+  torch::Tensor next_obs_batch = torch::zeros(batch_shape);
+
+  // Retrieve the all the decoded observations, waiting only for the tasks of this batch when the pool is shared.
+  TaskGroup group;
+  int frame_size = this->frame_size;
   float *obs_batch_ptr = obs_batch.data_ptr<float>();
   float *next_obs_batch_ptr = next_obs_batch.data_ptr<float>();
   int64_t *indices_ptr = indices.data_ptr<int64_t>();
@@ -108,35 +187,100 @@ std::tuple<torch::Tensor, torch::Tensor> FrameBuffer::operator[](const torch::Te
     int reference_t = this->references_t[idx];
     int reference_tn = this->references_tn[idx];
 
-    // Parallelize the decompression of the observations.
-    this->pool.push([this, obs_batch_ptr, reference_t, frame_size] {
-      float *ptr = obs_batch_ptr;
-      for (auto j = 0; j < this->stack_size; j++) {
-        this->png->decode(this->frames[reference_t + j], ptr);
-        ptr += frame_size;
-      }
-    });
-    this->pool.push([this, next_obs_batch_ptr, reference_tn, frame_size] {
-      float *ptr = next_obs_batch_ptr;
-      for (auto j = 0; j < this->stack_size; j++) {
-        this->png->decode(this->frames[reference_tn + j], ptr);
-        ptr += frame_size;
-      }
-    });
-    obs_batch_ptr += frame_size * this->stack_size;
-    next_obs_batch_ptr += frame_size * this->stack_size;
+    // Parallelize the decompression of the observations, each observation being decoded on the NUMA node storing its
+    // first frame when the thread pool is NUMA-aware.
+    int node_t = this->frames.node(reference_t);
+    int node_tn = this->frames.node(reference_tn);
+    this->pool->push(
+        [this, obs_batch_ptr, reference_t, n_frames, stride] {
+          this->decodeObservation(reference_t, obs_batch_ptr, n_frames, stride);
+        },
+        group, node_t
+    );
+    this->pool->push(
+        [this, next_obs_batch_ptr, reference_tn, n_frames, stride] {
+          this->decodeObservation(reference_tn, next_obs_batch_ptr, n_frames, stride);
+        },
+        group, node_tn
+    );
+    obs_batch_ptr += frame_size * n_frames;
+    next_obs_batch_ptr += frame_size * n_frames;
 
     // Move to the next experience index in the batch.
     ++indices_ptr;
   }
-  this->pool.synchronize();
+  group.wait();
 
   // Returns the batch's observations.
   return std::make_tuple(obs_batch, next_obs_batch);
 }
 
+void FrameBuffer::decodeObservation(int reference, float *output) {
+  this->decodeObservation(reference, output, this->stack_size, 1);
+}
+
+void FrameBuffer::decodeObservation(int reference, float *output, int n_frames, int stride) {
+  RELAB_MEASURE(Operation::DECODE);
+  RELAB_TRACE("FrameBuffer::decodeObservation");
+
+  // The stack ends with the newest frame of the observation.
+  int frame_size = this->frame_size;
+  int last = reference + this->stack_size - 1;
+  int first = last - (n_frames - 1) * stride;
+
+  // Decode the frames preceding the stack, from the keyframe on which the
+  // stack's first frame depends.
+  int distance = this->png->keyframeDistance(this->frames[first]);
+  if (stride == 1) {
+    for (auto j = first - distance; j < first; j++) {
+      this->png->decode(this->frames[j], output);
+    }
+
+    // Decode the frames of the stack, delta frames being decoded on top of
+    // a copy of the previous frame.
+    for (auto j = 0; j < n_frames; j++) {
+      torch::Tensor frame = this->frames[first + j];
+      if (j != 0 && this->png->keyframeDistance(frame) != 0) {
+        std::memcpy(output, output - frame_size, frame_size * sizeof(float));
+      }
+      this->png->decode(frame, output);
+      output += frame_size;
+    }
+    return;
+  }
+
+  // With strided stacks, the frames are decoded in order into a scratch frame, skipping the frames that are neither
+  // stacked nor needed to decode the next delta frame, and the stacked frames are copied to the output.
+  thread_local std::vector<float> scratch;
+  scratch.resize(frame_size);
+  for (auto j = first - distance; j <= last; j++) {
+    bool stacked = (j >= first && (j - first) % stride == 0);
+    bool needed = (j < last && this->png->keyframeDistance(this->frames[j + 1]) != 0);
+    if (stacked == false && needed == false) {
+      continue;
+    }
+    this->png->decode(this->frames[j], scratch.data());
+    if (stacked == true) {
+      std::memcpy(output + (j - first) / stride * frame_size, scratch.data(), frame_size * sizeof(float));
+    }
+  }
+}
+
 int FrameBuffer::size() { return std::min(this->current_ref, this->capacity); }
 
+torch::Tensor FrameBuffer::getEncodedFrame(int index) { return this->frames[index]; }
+
+const std::vector<int64_t> &FrameBuffer::getFrameShape() { return this->frame_shape; }
+
+std::shared_ptr<ThreadPool> FrameBuffer::getThreadPool() { return this->pool; }
+
+bool FrameBuffer::getNewEpisode() { return this->new_episode; }
+
+void FrameBuffer::endEpisode() {
+  this->past_references.clear();
+  this->new_episode = true;
+}
+
 void FrameBuffer::clear() {
   std::vector<int> references_t(this->capacity);
   this->references_t = std::move(references_t);
@@ -146,9 +290,79 @@ void FrameBuffer::clear() {
   this->past_references.clear();
   this->new_episode = true;
   this->current_ref = 0;
+  this->clearRecentFrames();
+  this->dictionary_samples.clear();
+  this->png->reset();
+}
+
+int FrameBuffer::addFrame(const torch::Tensor &frame) {
+  // The frames are allocated on the arena node when the thread pool is NUMA-aware.
+  return this->frames.append(frame, (this->pool->nNodes() != 1) ? this->arena_node : -1);
+}
+
+torch::Tensor FrameBuffer::planarFrame(const torch::Tensor &frame) {
+  // Copy the frames that already have the expected shape.
+  if (frame.sizes() == at::IntArrayRef(this->frame_shape)) {
+    return frame.detach().clone();
+  }
+
+  // Transpose channel-last frames, so that each channel of the stored frame is contiguous.
+  if (frame.dim() == 3 && this->frame_shape.size() == 3 && frame.size(0) == this->frame_shape[1] &&
+      frame.size(1) == this->frame_shape[2] && frame.size(2) == this->frame_shape[0]) {
+    return frame.detach().permute({2, 0, 1}).contiguous();
+  }
+  throw std::runtime_error("The frames added to the buffer do not have the shape of the buffer's frames.");
+}
+
+int FrameBuffer::addRawFrame(const torch::Tensor &frame) {
+  // Collect the first frames, and train the compressor once enough frames are available.
+  if (this->dictionary_frames > 0 && this->png->isTrained() == false) {
+    this->dictionary_samples.push_back(frame);
+    if (static_cast<int>(this->dictionary_samples.size()) >= this->dictionary_frames) {
+      this->png->train(this->dictionary_samples);
+      this->dictionary_samples.clear();
+    }
+  }
+
+  // If deduplication is disabled, simply encode the frame and add it to the buffer.
+  if (this->dedup_window <= 0) {
+    return this->addFrame(this->encode(frame));
+  }
+
+  // Look for an identical frame among the recently stored frames, the frame being a copy owned by the buffer.
+  torch::Tensor raw_frame = frame.contiguous();
+  size_t n_bytes = raw_frame.numel() * raw_frame.element_size();
+  uint64_t hash = hash_bytes(raw_frame.data_ptr(), n_bytes);
+  for (size_t i = 0; i < this->recent_frames.size(); i++) {
+    if (this->recent_hashes[i] == hash &&
+        std::memcmp(this->recent_raw_frames[i].data_ptr(), raw_frame.data_ptr(), n_bytes) == 0) {
+      // The encoded tensor is shared between the storage slots, and its memory is only released when the last slot
+      // referencing it is evicted.
+      return this->addFrame(this->recent_frames[i]);
+    }
+  }
+
+  // Otherwise, encode the frame and keep track of it in the window of recent frames.
+  torch::Tensor encoded_frame = this->encode(raw_frame);
+  if (static_cast<int>(this->recent_frames.size()) < this->dedup_window) {
+    this->recent_hashes.push_back(hash);
+    this->recent_raw_frames.push_back(raw_frame);
+    this->recent_frames.push_back(encoded_frame);
+  } else {
+    this->recent_hashes[this->recent_index] = hash;
+    this->recent_raw_frames[this->recent_index] = raw_frame;
+    this->recent_frames[this->recent_index] = encoded_frame;
+    this->recent_index = (this->recent_index + 1) % this->dedup_window;
+  }
+  return this->addFrame(encoded_frame);
 }
 
-int FrameBuffer::addFrame(const torch::Tensor &frame) { return this->frames.append(frame); }
+void FrameBuffer::clearRecentFrames() {
+  this->recent_hashes.clear();
+  this->recent_raw_frames.clear();
+  this->recent_frames.clear();
+  this->recent_index = 0;
+}
 
 void FrameBuffer::addReference(int t, int tn) {
   // Handle negative indices as indices from the end of the queue.
@@ -164,45 +378,127 @@ void FrameBuffer::addReference(int t, int tn) {
 
 int FrameBuffer::firstReference() { return (this->current_ref < this->capacity) ? 0 : this->current_ref; }
 
-torch::Tensor FrameBuffer::encode(const torch::Tensor &frame) { return this->png->encode(frame); }
+torch::Tensor FrameBuffer::encode(const torch::Tensor &frame) {
+  RELAB_MEASURE(Operation::ENCODE);
+  RELAB_TRACE("FrameBuffer::encode");
+  return this->png->encode(frame);
+}
 
 torch::Tensor FrameBuffer::decode(const torch::Tensor &frame) { return this->png->decode(frame); }
 
-void FrameBuffer::load(std::istream &checkpoint) {
+void FrameBuffer::load(std::istream &checkpoint, bool compressed, int version) {
   // Load the frame buffer from the checkpoint.
   this->frame_skip = load_value<int>(checkpoint);
   this->stack_size = load_value<int>(checkpoint);
   this->capacity = load_value<int>(checkpoint);
   this->n_steps = load_value<int>(checkpoint);
-  this->screen_size = load_value<int>(checkpoint);
-  this->frames.load(checkpoint);
-  this->references_t = std::move(load_vector<int>(checkpoint));
-  this->references_tn = std::move(load_vector<int>(checkpoint));
+  // Square single-channel frames are saved by their size, and other frames by the opposite of their number of
+  // dimensions followed by their shape, which keeps the checkpoints of square frames unchanged.
+  std::vector<int64_t> previous_shape = this->frame_shape;
+  int screen_size = load_value<int>(checkpoint);
+  if (screen_size > 0) {
+    this->frame_shape = {screen_size, screen_size};
+  } else {
+    this->frame_shape.resize(-screen_size);
+    for (auto &size : this->frame_shape) {
+      size = load_value<int>(checkpoint);
+    }
+  }
+  this->frame_size = static_cast<int>(nElements(this->frame_shape));
+  this->frames.load(checkpoint, version);
+
+  // Rebuild the compressor if the frames of the checkpoint have another shape than the frames of this buffer.
+  if (this->frame_shape != previous_shape) {
+    this->png = Compressor::create(this->frame_shape, this->png->getType());
+  }
+  this->png->reset();
+  if (version >= 1) {
+    this->png->load(checkpoint);
+    this->dedup_window = load_value<int>(checkpoint);
+  }
+  if (compressed == true) {
+    this->references_t = std::move(load_compressed_vector<int>(checkpoint, true));
+    this->references_tn = std::move(load_compressed_vector<int>(checkpoint, true));
+  } else {
+    this->references_t = std::move(load_vector<int>(checkpoint));
+    this->references_tn = std::move(load_vector<int>(checkpoint));
+  }
   this->current_ref = load_value<int>(checkpoint);
   this->past_references.load(checkpoint);
   this->new_episode = load_value<bool>(checkpoint);
+  this->clearRecentFrames();
+  this->dictionary_samples.clear();
 }
 
-void FrameBuffer::save(std::ostream &checkpoint) {
+void FrameBuffer::save(std::ostream &checkpoint, bool compressed) {
   // Save the frame buffer in the checkpoint.
   save_value(this->frame_skip, checkpoint);
   save_value(this->stack_size, checkpoint);
   save_value(this->capacity, checkpoint);
   save_value(this->n_steps, checkpoint);
-  save_value(this->screen_size, checkpoint);
+  if (this->frame_shape.size() == 2 && this->frame_shape[0] == this->frame_shape[1]) {
+    save_value(static_cast<int>(this->frame_shape[0]), checkpoint);
+  } else {
+    save_value(-static_cast<int>(this->frame_shape.size()), checkpoint);
+    for (auto size : this->frame_shape) {
+      save_value(static_cast<int>(size), checkpoint);
+    }
+  }
   this->frames.save(checkpoint);
-  save_vector(this->references_t, checkpoint);
-  save_vector(this->references_tn, checkpoint);
+  this->png->save(checkpoint);
+  save_value(this->dedup_window, checkpoint);
+  if (compressed == true) {
+    // References mostly increase by one from an experience to the next, so they are delta encoded.
+    save_compressed_vector(this->references_t, checkpoint, true);
+    save_compressed_vector(this->references_tn, checkpoint, true);
+  } else {
+    save_vector(this->references_t, checkpoint);
+    save_vector(this->references_tn, checkpoint);
+  }
   save_value(this->current_ref, checkpoint);
   this->past_references.save(checkpoint);
   save_value(this->new_episode, checkpoint);
 }
 
+std::map<std::string, double> FrameBuffer::memoryStats() {
+  // Sum the size of the distinct storages referenced by the stored frames.
+  std::unordered_set<const void *> storages;
+  double compressed_size = 0;
+  int n_frames = this->frames.size();
+  for (auto i = 0; i < n_frames; i++) {
+    auto storage = this->frames[this->frames.top_index() + i].storage();
+    if (storages.insert(storage.data()).second == true) {
+      compressed_size += storage.nbytes();
+    }
+  }
+
+  // Each distinct frame has a tensor and a storage header, and each slot of the storage holds a tensor handle.
+  double metadata_size = storages.size() * (sizeof(c10::TensorImpl) + sizeof(c10::StorageImpl));
+  double handles_size = this->frames.frames.capacity() * sizeof(torch::Tensor);
+
+  // The references of the experiences and of the recent observations.
+  double references_size = (this->references_t.capacity() + this->references_tn.capacity()) * sizeof(int);
+  references_size += this->past_references.size() * sizeof(int);
+
+  return {
+      {"compressed_frames", compressed_size},
+      {"frame_metadata", metadata_size},
+      {"frame_handles", handles_size},
+      {"references", references_size},
+      {"n_frames", n_frames},
+      {"uncompressed_frames", static_cast<double>(n_frames) * this->frame_size * sizeof(float)},
+  };
+}
+
 void FrameBuffer::print(bool verbose, const std::string &prefix) {
   // Display the most important information about the frame buffer.
   std::cout << "FrameBuffer[frame_skip: " << this->frame_skip << ", stack_size: " << this->stack_size
             << ", capacity: " << this->capacity << ", n_steps: " << this->n_steps
-            << ", screen_size: " << this->screen_size << ", current_ref: " << this->current_ref << ", new_episode: ";
+            << ", frame_shape: (";
+  for (size_t i = 0; i < this->frame_shape.size(); i++) {
+    std::cout << ((i == 0) ? "" : ", ") << this->frame_shape[i];
+  }
+  std::cout << "), current_ref: " << this->current_ref << ", new_episode: ";
   print_bool(this->new_episode);
   std::cout << "]" << std::endl;
 
@@ -223,9 +519,9 @@ bool operator==(const FrameBuffer &lhs, const FrameBuffer &rhs) {
   // Check that all attributes of standard types and container sizes are
   // identical.
   if (lhs.frame_skip != rhs.frame_skip || lhs.stack_size != rhs.stack_size || lhs.capacity != rhs.capacity ||
-      lhs.n_steps != rhs.n_steps || lhs.screen_size != rhs.screen_size || lhs.current_ref != rhs.current_ref ||
-      lhs.new_episode != rhs.new_episode || lhs.references_t.size() != rhs.references_t.size() ||
-      lhs.references_tn.size() != rhs.references_tn.size()) {
+      lhs.n_steps != rhs.n_steps || lhs.frame_shape != rhs.frame_shape || lhs.current_ref != rhs.current_ref ||
+      lhs.new_episode != rhs.new_episode || lhs.dedup_window != rhs.dedup_window ||
+      lhs.references_t.size() != rhs.references_t.size() || lhs.references_tn.size() != rhs.references_tn.size()) {
     return false;
   }
 
@@ -3,7 +3,9 @@
 #include "agents/memory/frame_storage.hpp"
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "helpers/debug.hpp"
@@ -20,9 +22,10 @@ FrameStorage::FrameStorage(int capacity, int capacity_incr) :
   // Allocate enough memory to store a number of frames equal to the storage
   // capacity.
   this->frames.reserve(capacity);
+  this->nodes.reserve(capacity);
 }
 
-int FrameStorage::append(const torch::Tensor &frame) {
+int FrameStorage::append(const torch::Tensor &frame, int node) {
   // Update the last frame indices.
   this->last_frame_index += 1;
   this->last_frame += 1;
@@ -33,12 +36,14 @@ int FrameStorage::append(const torch::Tensor &frame) {
   // Add the frame to the vector of frames.
   if (static_cast<int>(this->frames.size()) != this->capacity) {
     this->frames.push_back(frame);
+    this->nodes.push_back(node);
   } else {
     // Resize the vector of frames if it is full.
     if (this->last_frame == this->first_frame) {
       this->resize_frames();
     }
     this->frames[this->last_frame] = frame;
+    this->nodes[this->last_frame] = node;
   }
   return this->last_frame_index;
 }
@@ -48,11 +53,13 @@ void FrameStorage::resize_frames() {
   int capacity = this->capacity;
   this->capacity += this->capacity_incr;
   this->frames.resize(this->capacity);
+  this->nodes.resize(this->capacity, -1);
 
   // Create space between the first and last frames.
   int n = capacity - this->first_frame;
   for (auto i = 0; i < n; i++) {
     this->frames[this->capacity - 1 - i] = this->frames[capacity - 1 - i];
+    this->nodes[this->capacity - 1 - i] = this->nodes[capacity - 1 - i];
   }
 
   // Update the first and last frame to reflect the new state of the vector of
@@ -84,6 +91,7 @@ void FrameStorage::clear() {
 
   // Clear the vector of frames.
   this->frames.clear();
+  this->nodes.clear();
 }
 
 torch::Tensor FrameStorage::operator[](int index) {
@@ -92,12 +100,36 @@ torch::Tensor FrameStorage::operator[](int index) {
   return this->frames[index];
 }
 
-void FrameStorage::load(std::istream &checkpoint) {
+int FrameStorage::node(int index) {
+  index -= this->first_frame_index;
+  index = (index + this->first_frame) % this->capacity;
+  return this->nodes[index];
+}
+
+void FrameStorage::load(std::istream &checkpoint, int version) {
   // Load the frame buffer from the checkpoint.
   this->initial_capacity = load_value<int>(checkpoint);
   this->capacity = load_value<int>(checkpoint);
   this->capacity_incr = load_value<int>(checkpoint);
-  this->frames = std::move(load_vector<torch::Tensor, float>(checkpoint));
+  if (version == 0) {
+    this->frames = std::move(load_vector<torch::Tensor, float>(checkpoint));
+  } else {
+    // Each frame is either stored in full, or is a reference to the previous frame sharing its encoding.
+    this->frames.clear();
+    this->frames.reserve(load_value<int>(checkpoint));
+    int size = load_value<int>(checkpoint);
+    for (auto i = 0; i < size; i++) {
+      int shared_index = load_value<int>(checkpoint);
+      if (shared_index < 0) {
+        this->frames.push_back(load_tensor<float>(checkpoint));
+      } else if (shared_index < i) {
+        this->frames.push_back(this->frames[shared_index]);
+      } else {
+        throw std::runtime_error("The frame storage of the checkpoint is corrupted.");
+      }
+    }
+  }
+  this->nodes.assign(this->frames.size(), -1);
   this->first_frame_index = load_value<int>(checkpoint);
   this->last_frame_index = load_value<int>(checkpoint);
   this->first_frame = load_value<int>(checkpoint);
@@ -109,7 +141,23 @@ void FrameStorage::save(std::ostream &checkpoint) {
   save_value(this->initial_capacity, checkpoint);
   save_value(this->capacity, checkpoint);
   save_value(this->capacity_incr, checkpoint);
-  save_vector<torch::Tensor, float>(this->frames, checkpoint);
+
+  // Save each frame, or the index of the first frame sharing its encoding.
+  std::unordered_map<const void *, int> first_indices;
+  save_value(static_cast<int>(this->frames.capacity()), checkpoint);
+  save_value(static_cast<int>(this->frames.size()), checkpoint);
+  for (size_t i = 0; i < this->frames.size(); i++) {
+    const torch::Tensor &frame = this->frames[i];
+    if (frame.defined() == true) {
+      auto [position, inserted] = first_indices.emplace(frame.data_ptr(), static_cast<int>(i));
+      if (inserted == false) {
+        save_value(position->second, checkpoint);
+        continue;
+      }
+    }
+    save_value(-1, checkpoint);
+    save_tensor<float>(frame, checkpoint);
+  }
   save_value(this->first_frame_index, checkpoint);
   save_value(this->last_frame_index, checkpoint);
   save_value(this->first_frame, checkpoint);
@@ -5,24 +5,36 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "helpers/debug.hpp"
 #include "helpers/serialize.hpp"
+#include "helpers/thread_pool.hpp"
 #include "helpers/torch.hpp"
+#include "helpers/trace.hpp"
 
 using namespace torch::indexing;
 using namespace relab::helpers;
 
 namespace relab::agents::memory::impl {
 
-PriorityTree::PriorityTree(int capacity, float initial_priority, int n_children) {
+PriorityTree::PriorityTree(
+    int capacity, float initial_priority, int n_children, SumTreeType sum_tree_type, PrioritizationType prioritization,
+    float omega
+) {
   // Store the priority tree parameters.
   this->initial_priority = initial_priority;
   this->capacity = capacity;
   this->n_children = n_children;
+  this->sum_tree_type = sum_tree_type;
+  this->prioritization = prioritization;
+  this->omega = omega;
+  this->pool = std::make_shared<ThreadPool>(0);
 
   // Robust computation of the trees' depth.
   this->depth = std::floor(std::log(this->capacity) / std::log(n_children));
@@ -30,12 +42,20 @@ PriorityTree::PriorityTree(int capacity, float initial_priority, int n_children)
     this->depth += 1;
   }
 
+  // The largest power of two smaller than or equal to the capacity, from which the Fenwick tree is descended.
+  this->fenwick_mask = PriorityTree::fenwickMask(this->capacity);
+
   // Create a tensor of priorities, an empty sum-tree and an empty max-tree.
-  this->priorities = torch::zeros({this->capacity});
-  this->sum_tree = this->createSumTree(this->depth, n_children);
-  this->max_tree = this->createMaxTree(this->depth, n_children);
-  this->current_id = 0;
-  this->need_refresh_all = true;
+  this->clear();
+  this->refreshAllRankTree();
+}
+
+int PriorityTree::fenwickMask(int capacity) {
+  int mask = 1;
+  while (mask * 2 <= capacity) {
+    mask *= 2;
+  }
+  return mask;
 }
 
 SumTree PriorityTree::createSumTree(int depth, int n_children) {
@@ -58,10 +78,27 @@ MaxTree PriorityTree::createMaxTree(int depth, int n_children) {
   return tree;
 }
 
+MinTree PriorityTree::createMinTree(int depth, int n_children) {
+  MinTree tree;
+
+  for (auto i = depth - 1; i >= 0; i--) {
+    int n = std::pow(n_children, i);
+    tree.push_back(std::vector<float>(n, std::numeric_limits<float>::infinity()));
+  }
+  return tree;
+}
+
 double PriorityTree::sum() {
   if (this->current_id == 0) {
     return 0;
   }
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    double total = 0;
+    for (int i = this->capacity; i > 0; i -= i & -i) {
+      total += this->fenwick_tree[i];
+    }
+    return total;
+  }
   return this->sum_tree[this->sum_tree.size() - 1][0];
 }
 
@@ -72,12 +109,66 @@ float PriorityTree::max() {
   return this->max_tree[this->max_tree.size() - 1][0].item<float>();
 }
 
+float PriorityTree::min() {
+  if (this->current_id == 0) {
+    return this->initial_priority;
+  }
+  return this->min_tree[this->min_tree.size() - 1][0];
+}
+
+torch::Tensor PriorityTree::importanceWeights(const torch::Tensor &indices, float omega_is) {
+  torch::Tensor input = indices.to(torch::kInt64).contiguous();
+  int n = static_cast<int>(input.numel());
+  torch::Tensor weights = torch::zeros({n});
+  const int64_t *indices_ptr = input.data_ptr<int64_t>();
+  const float *priorities = this->priorities.data_ptr<float>();
+  float *weights_ptr = weights.data_ptr<float>();
+
+  // With rank-based prioritization, the weights are (N * P(i))^-omega_is / (N * P(N))^-omega_is where P(i) is
+  // proportional to rank(i)^-omega, i.e., the weights are (rank(i) / N)^(omega * omega_is).
+  if (this->prioritization == PrioritizationType::RANK) {
+    for (auto i = 0; i < n; i++) {
+      int idx = this->internalIndex(indices_ptr[i]);
+      int rank = this->rank_tree.order_of_key({-priorities[idx], idx}) + 1;
+      weights_ptr[i] = std::pow(static_cast<float>(rank) / this->size(), this->omega * omega_is);
+    }
+    return weights;
+  }
+
+  // The largest weight is the one of the smallest priority, fall back to the smallest priority in the batch if it is
+  // not positive, and clamp it so that zero priorities in the batch never cause a division by zero.
+  float min_priority = this->min();
+  if (min_priority <= 0) {
+    min_priority = std::numeric_limits<float>::infinity();
+    for (auto i = 0; i < n; i++) {
+      min_priority = std::min(min_priority, priorities[this->internalIndex(indices_ptr[i])]);
+    }
+  }
+  min_priority = std::max(min_priority, MIN_WEIGHTED_PRIORITY);
+
+  // The weights are (N * P(i))^-omega_is / (N * P(min))^-omega_is, where the number of elements and the sum of
+  // priorities cancel out, and the priorities are clamped like the smallest one so that the weights never exceed one.
+  for (auto i = 0; i < n; i++) {
+    float priority = std::max(priorities[this->internalIndex(indices_ptr[i])], MIN_WEIGHTED_PRIORITY);
+    weights_ptr[i] = std::pow(priority / min_priority, -omega_is);
+  }
+  return weights;
+}
+
 void PriorityTree::clear() {
   this->current_id = 0;
-  this->need_refresh_all = true;
+  this->refresh_index = 0;
   this->priorities = torch::zeros({this->capacity});
-  this->sum_tree = this->createSumTree(this->depth, this->n_children);
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    this->sum_tree.clear();
+    this->fenwick_tree.assign(this->capacity + 1, 0);
+  } else {
+    this->sum_tree = this->createSumTree(this->depth, this->n_children);
+    this->fenwick_tree.clear();
+  }
   this->max_tree = this->createMaxTree(this->depth, this->n_children);
+  this->min_tree = this->createMinTree(this->depth, this->n_children);
+  this->rank_tree.clear();
 }
 
 int PriorityTree::size() { return std::min(this->current_id, this->capacity); }
@@ -85,36 +176,37 @@ int PriorityTree::size() { return std::min(this->current_id, this->capacity); }
 void PriorityTree::append(float priority) {
   int idx = this->current_id % this->capacity;
   float old_priority = this->priorities[idx].item<float>();
+  bool stored = (this->current_id >= this->capacity);
 
   // Add a new priority to the list of priorities.
   this->priorities[idx] = priority;
   this->current_id += 1;
   this->updateMaxTree(idx, old_priority);
+  this->updateMinTree(idx);
   this->updateSumTree(idx, old_priority);
+  this->updateRankTree(idx, old_priority, stored);
 
-  // Check if the full sum tree must be refreshed.
-  if (this->max() != this->initial_priority && this->need_refresh_all == true) {
-    this->refreshAllSumTree();
-    this->need_refresh_all = false;
-  }
+  // Recompute a few nodes of the sum-tree to bound the rounding errors of incremental updates.
+  this->refreshSumTreeIncrementally();
 }
 
 float PriorityTree::get(int index) { return this->priorities[this->internalIndex(index)].item<float>(); }
 
 void PriorityTree::set(int index, float priority) {
+  RELAB_TRACE("PriorityTree::set");
+
   int idx = this->internalIndex(index);
   float old_priority = this->priorities[idx].item<float>();
 
   // Replace the old priority with the new priority.
   this->priorities[idx] = priority;
   this->updateMaxTree(idx, old_priority);
+  this->updateMinTree(idx);
   this->updateSumTree(idx, old_priority);
+  this->updateRankTree(idx, old_priority, true);
 
-  // Check if the full sum tree must be refreshed.
-  if (this->max() != this->initial_priority && this->need_refresh_all == true) {
-    this->refreshAllSumTree();
-    this->need_refresh_all = false;
-  }
+  // Recompute a few nodes of the sum-tree to bound the rounding errors of incremental updates.
+  this->refreshSumTreeIncrementally();
 }
 
 int PriorityTree::internalIndex(int index) {
@@ -134,14 +226,25 @@ int PriorityTree::externalIndex(int index) {
 }
 
 torch::Tensor PriorityTree::sampleIndices(int n) {
+  RELAB_TRACE("PriorityTree::sampleIndices");
+
+  // Neither the sum-tree nor the rank tree has an element to return when the tree is empty.
+  if (this->size() == 0) {
+    throw std::runtime_error("Cannot sample from an empty priority tree.");
+  }
+  if (this->prioritization == PrioritizationType::RANK) {
+    return this->sampleIndicesByRank(n);
+  }
+
   // Sample priorities between zero and the sum of priorities.
   torch::Tensor sampled_priorities = torch::rand({n}) * static_cast<float>(this->sum());
 
   // Sample 'n' indices with a probability proportional to their priorities.
   torch::Tensor indices = torch::zeros({n}, torch::kInt64);
+  float *priorities = sampled_priorities.data_ptr<float>();
+  int64_t *indices_ptr = indices.data_ptr<int64_t>();
   for (auto i = 0; i < n; i++) {
-    float priority = sampled_priorities.index({i}).item<float>();
-    indices.index_put_({i}, static_cast<int64_t>(this->towerSampling(priority)));
+    indices_ptr[i] = this->towerSampling(priorities[i]);
   }
   return indices;
 }
@@ -151,6 +254,9 @@ int PriorityTree::towerSampling(float priority) {
   if (priority > this->sum()) {
     return this->externalIndex(this->size() - 1);
   }
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    return this->externalIndex(this->fenwickSearch(priority));
+  }
 
   // Go down the sum-tree until the leaf node is reached.
   float new_priority = 0;
@@ -183,18 +289,93 @@ int PriorityTree::towerSampling(float priority) {
   return this->externalIndex(index);
 }
 
+torch::Tensor PriorityTree::sampleIndicesByRank(int n) {
+  // Sample one value in each of the 'n' segments of equal probability mass.
+  double total = this->rank_cdf[this->size()];
+  torch::Tensor offsets = torch::rand({n});
+  float *offsets_ptr = offsets.data_ptr<float>();
+
+  // Find the rank whose cumulative probability reaches each value, and the element with this rank.
+  torch::Tensor indices = torch::zeros({n}, torch::kInt64);
+  int64_t *indices_ptr = indices.data_ptr<int64_t>();
+  auto first = this->rank_cdf.begin() + 1;
+  for (auto i = 0; i < n; i++) {
+    double value = (i + offsets_ptr[i]) / n * total;
+    int rank = static_cast<int>(std::lower_bound(first, first + this->size(), value) - first);
+    rank = std::min(rank, this->size() - 1);
+    indices_ptr[i] = this->externalIndex(this->rank_tree.find_by_order(rank)->second);
+  }
+  return indices;
+}
+
+void PriorityTree::updateRankTree(int index, float old_priority, bool stored) {
+  if (this->prioritization != PrioritizationType::RANK) {
+    return;
+  }
+  if (stored == true) {
+    this->rank_tree.erase({-old_priority, index});
+  }
+  this->rank_tree.insert({-this->priorities[index].item<float>(), index});
+}
+
+void PriorityTree::refreshAllRankTree() {
+  this->rank_tree.clear();
+  this->rank_cdf.clear();
+  if (this->prioritization != PrioritizationType::RANK) {
+    return;
+  }
+
+  // Compute the cumulative sums of rank^-omega, whose first element corresponds to an empty tree.
+  this->rank_cdf.resize(this->capacity + 1);
+  this->rank_cdf[0] = 0;
+  for (auto rank = 1; rank <= this->capacity; rank++) {
+    this->rank_cdf[rank] = this->rank_cdf[rank - 1] + std::pow(rank, -this->omega);
+  }
+
+  // Insert all the elements stored in the tree.
+  float *priorities = this->priorities.data_ptr<float>();
+  for (auto index = 0; index < this->size(); index++) {
+    this->rank_tree.insert({-priorities[index], index});
+  }
+}
+
+int PriorityTree::fenwickSearch(double priority) {
+  // Find the largest position whose prefix sum is strictly smaller than the priority, halving the step at each level.
+  int position = 0;
+  for (int step = this->fenwick_mask; step > 0; step /= 2) {
+    int next = position + step;
+    if (next <= this->capacity && this->fenwick_tree[next] < priority) {
+      position = next;
+      priority -= this->fenwick_tree[next];
+    }
+  }
+
+  // The number of elements before the one whose prefix sum reaches the priority is the internal index of this element.
+  return std::min(position, this->size() - 1);
+}
+
 int PriorityTree::parentIndex(int idx) { return (idx < 0) ? idx : idx / this->n_children; }
 
 void PriorityTree::updateSumTree(int index, float old_priority) {
+  // Update the Fenwick tree nodes covering the element, if the Fenwick tree is used.
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    double delta = static_cast<double>(this->priorities[index].item<float>()) - old_priority;
+    for (int i = index + 1; i <= this->capacity; i += i & -i) {
+      this->fenwick_tree[i] += delta;
+    }
+    return;
+  }
+
   // Compute the parent index.
   int parent_index = this->parentIndex(index);
 
-  // Go up the tree until the root node is reached.
+  // Go up the tree until the root node is reached, the difference is computed in double precision to keep the small
+  // priorities replacing large ones.
   int depth = 0;
-  float new_priority = this->priorities[index].item<float>();
+  double delta = static_cast<double>(this->priorities[index].item<float>()) - old_priority;
   while (depth < this->depth) {
     // Update the sums in the sum-tree.
-    this->sum_tree[depth][parent_index] += new_priority - old_priority;
+    this->sum_tree[depth][parent_index] += delta;
 
     // Update parent indices and tree depth.
     depth += 1;
@@ -202,26 +383,167 @@ void PriorityTree::updateSumTree(int index, float old_priority) {
   }
 }
 
-void PriorityTree::refreshAllSumTree() {
-  // Fill the sum-tree with zeros.
-  this->sum_tree = this->createSumTree(this->depth, this->n_children);
+void PriorityTree::refreshSumTreeIncrementally() {
+  float *priorities = this->priorities.data_ptr<float>();
+
+  // Recompute the next nodes of the Fenwick tree from the priority and the nodes they cover, if the Fenwick tree is
+  // used. The nodes covered by a node have smaller indices, so they are recomputed first.
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    for (auto k = 0; k < N_REFRESHED_NODES; k++) {
+      int i = this->refresh_index + 1;
+      double total = priorities[i - 1];
+      for (int j = i - 1; j > i - (i & -i); j -= j & -j) {
+        total += this->fenwick_tree[j];
+      }
+      this->fenwick_tree[i] = total;
+      this->refresh_index = i % this->capacity;
+    }
+    return;
+  }
+  if (this->depth == 0) {
+    return;
+  }
 
-  // Iterate over all the priorities.
-  for (auto index = 0; index < this->size(); index++) {
-    // Compute the parent index and current priority.
-    int parent_index = this->parentIndex(index);
-    float priority = this->priorities[index].item<float>();
-
-    // Go up the tree until the root node is reached.
-    int depth = 0;
-    while (depth < this->depth) {
-      // Update the sums in the sum-tree.
-      this->sum_tree[depth][parent_index] += priority;
-
-      // Update parent indices and tree depth.
-      depth += 1;
+  // Recompute the next nodes of the sum-tree's bottom level from the priorities, and their ancestors from their
+  // children.
+  for (auto k = 0; k < N_REFRESHED_NODES; k++) {
+    int parent_index = this->refresh_index;
+    for (auto depth = 0; depth < this->depth; depth++) {
+      int first_child = this->n_children * parent_index;
+      double total = 0;
+      if (depth == 0) {
+        int last_child = std::min(first_child + this->n_children, this->capacity);
+        for (auto index = first_child; index < last_child; index++) {
+          total += priorities[index];
+        }
+      } else {
+        const std::vector<double> &children = this->sum_tree[depth - 1];
+        int last_child = std::min(first_child + this->n_children, static_cast<int>(children.size()));
+        for (auto index = first_child; index < last_child; index++) {
+          total += children[index];
+        }
+      }
+      this->sum_tree[depth][parent_index] = total;
       parent_index = this->parentIndex(parent_index);
     }
+    this->refresh_index = (this->refresh_index + 1) % static_cast<int>(this->sum_tree[0].size());
+  }
+}
+
+void PriorityTree::setThreadPool(std::shared_ptr<ThreadPool> pool) { this->pool = std::move(pool); }
+
+void PriorityTree::assignAll(const torch::Tensor &priorities) {
+  RELAB_TRACE("PriorityTree::assignAll");
+
+  // Check that there is exactly one priority per element stored in the tree.
+  int size = this->size();
+  if (priorities.numel() != size) {
+    throw std::runtime_error("The number of priorities must be equal to the number of elements in the priority tree.");
+  }
+
+  // Copy the priorities, whose internal indices are shifted when the tree is full.
+  torch::Tensor input = priorities.to(torch::kFloat32).contiguous();
+  const float *input_ptr = input.data_ptr<float>();
+  float *priorities_ptr = this->priorities.data_ptr<float>();
+  int shift = (this->current_id >= this->capacity) ? this->current_id % this->capacity : 0;
+  for (auto index = 0; index < size; index++) {
+    priorities_ptr[(index + shift) % this->capacity] = input_ptr[index];
+  }
+
+  // Rebuild all the trees from the new priorities.
+  this->refreshAll();
+}
+
+void PriorityTree::refreshAll() {
+  ThreadPool &pool = *this->pool;
+  this->refreshAllSumTree(pool);
+  this->refreshAllMaxTree(pool);
+  this->refreshAllMinTree(pool);
+  this->refreshAllRankTree();
+}
+
+void PriorityTree::refreshAllSumTree(ThreadPool &pool) {
+  RELAB_TRACE("PriorityTree::refreshAllSumTree");
+
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    this->refreshAllFenwickTree(pool);
+    return;
+  }
+
+  // Fill the sum-tree with zeros.
+  this->sum_tree = this->createSumTree(this->depth, this->n_children);
+
+  // Compute each level of the sum-tree from the level below it, the nodes of a level being split among the threads.
+  const float *priorities = this->priorities.data_ptr<float>();
+  int size = this->size();
+  for (auto depth = 0; depth < this->depth; depth++) {
+    std::vector<double> &parents = this->sum_tree[depth];
+    pool.parallelFor(static_cast<int>(parents.size()), [this, &parents, priorities, size, depth](int begin, int end) {
+      for (auto parent_index = begin; parent_index < end; parent_index++) {
+        int first_child = this->n_children * parent_index;
+        double total = 0;
+        if (depth == 0) {
+          int last_child = std::min(first_child + this->n_children, size);
+          for (auto index = first_child; index < last_child; index++) {
+            total += priorities[index];
+          }
+        } else {
+          const std::vector<double> &children = this->sum_tree[depth - 1];
+          int last_child = std::min(first_child + this->n_children, static_cast<int>(children.size()));
+          for (auto index = first_child; index < last_child; index++) {
+            total += children[index];
+          }
+        }
+        parents[parent_index] = total;
+      }
+    });
+  }
+}
+
+void PriorityTree::refreshAllFenwickTree(ThreadPool &pool) {
+  // Fill the Fenwick tree with zeros.
+  this->fenwick_tree.assign(this->capacity + 1, 0);
+
+  // The nodes whose lowest set bit is 'step' only cover nodes whose lowest set bit is smaller, so the nodes are
+  // computed one bit at a time, the nodes sharing the same lowest set bit being split among the threads.
+  const float *priorities = this->priorities.data_ptr<float>();
+  int size = this->size();
+  for (int step = 1; step <= this->capacity; step *= 2) {
+    int n_nodes = (this->capacity / step + 1) / 2;
+    pool.parallelFor(n_nodes, [this, priorities, size, step](int begin, int end) {
+      for (auto k = begin; k < end; k++) {
+        int i = step * (2 * k + 1);
+        double total = (i - 1 < size) ? priorities[i - 1] : 0;
+        for (int child = step / 2; child > 0; child /= 2) {
+          total += this->fenwick_tree[i - child];
+        }
+        this->fenwick_tree[i] = total;
+      }
+    });
+  }
+}
+
+void PriorityTree::refreshAllMaxTree(ThreadPool &pool) {
+  // Fill the max-tree with zeros.
+  this->max_tree = this->createMaxTree(this->depth, this->n_children);
+
+  // Compute each level of the max-tree from the level below it, the nodes of a level being split among the threads.
+  const float *priorities = this->priorities.data_ptr<float>();
+  int size = this->size();
+  for (auto depth = 0; depth < this->depth; depth++) {
+    float *parents = this->max_tree[depth].data_ptr<float>();
+    const float *children = (depth == 0) ? priorities : this->max_tree[depth - 1].data_ptr<float>();
+    int n_nodes_below = (depth == 0) ? size : static_cast<int>(this->max_tree[depth - 1].numel());
+    int n_parents = static_cast<int>(this->max_tree[depth].numel());
+    pool.parallelFor(n_parents, [this, parents, children, n_nodes_below](int begin, int end) {
+      for (auto parent_index = begin; parent_index < end; parent_index++) {
+        int first_child = this->n_children * parent_index;
+        int last_child = std::min(first_child + this->n_children, n_nodes_below);
+        for (auto index = first_child; index < last_child; index++) {
+          parents[parent_index] = std::max(parents[parent_index], children[index]);
+        }
+      }
+    });
   }
 }
 
@@ -263,16 +585,79 @@ float PriorityTree::maxChildValue(int depth, int parent_index, int index, float
   return max_value;
 }
 
+void PriorityTree::refreshAllMinTree(ThreadPool &pool) {
+  // Fill the min-tree with infinity, and compute each level of the min-tree from the level below it.
+  this->min_tree = this->createMinTree(this->depth, this->n_children);
+  for (auto depth = 0; depth < this->depth; depth++) {
+    pool.parallelFor(static_cast<int>(this->min_tree[depth].size()), [this, depth](int begin, int end) {
+      for (auto index = begin; index < end; index++) {
+        this->min_tree[depth][index] = this->minChildValue(depth, index);
+      }
+    });
+  }
+}
+
+void PriorityTree::updateMinTree(int index) {
+  // Go up the tree until the root node is reached, or until a node is left unchanged.
+  int parent_index = this->parentIndex(index);
+  for (auto depth = 0; depth < this->depth; depth++) {
+    float min_value = this->minChildValue(depth, parent_index);
+    if (this->min_tree[depth][parent_index] == min_value) {
+      break;
+    }
+    this->min_tree[depth][parent_index] = min_value;
+    parent_index = this->parentIndex(parent_index);
+  }
+}
+
+float PriorityTree::minChildValue(int depth, int parent_index) {
+  int first_child = this->n_children * parent_index;
+  float min_value = std::numeric_limits<float>::infinity();
+
+  if (depth == 0) {
+    // Only the elements stored in the tree are taken into account.
+    int last_child = std::min(first_child + this->n_children, this->size());
+    float *priorities = this->priorities.data_ptr<float>();
+    for (auto index = first_child; index < last_child; index++) {
+      min_value = std::min(min_value, priorities[index]);
+    }
+  } else {
+    const std::vector<float> &children = this->min_tree[depth - 1];
+    int last_child = std::min(first_child + this->n_children, static_cast<int>(children.size()));
+    for (auto index = first_child; index < last_child; index++) {
+      min_value = std::min(min_value, children[index]);
+    }
+  }
+  return min_value;
+}
+
 std::string PriorityTree::maxTreeToStr(int max_n_elements) {
   float (*get)(MaxTree, int, int) = [](MaxTree tree, int i, int j) { return tree[i].index({j}).item<float>(); };
   return this->treeToStr(this->max_tree, get, max_n_elements);
 }
 
 std::string PriorityTree::sumTreeToStr(int max_n_elements) {
+  // The Fenwick tree is stored in a single array, whose first element is unused.
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    int max_i = (max_n_elements == -1) ? this->capacity : std::min(this->capacity, max_n_elements);
+    std::ostringstream out;
+    out.precision(1);
+    out << std::fixed << "[";
+    for (auto i = 1; i <= max_i; i++) {
+      out << ((i != 1) ? ", " : "") << this->fenwick_tree[i];
+    }
+    out << ((max_i != this->capacity) ? ((max_n_elements != 0) ? " ..." : "...") : "") << "]";
+    return out.str();
+  }
   double (*get)(SumTree, int, int) = [](SumTree tree, int i, int j) { return tree[i][j]; };
   return this->treeToStr(this->sum_tree, get, max_n_elements);
 }
 
+std::string PriorityTree::minTreeToStr(int max_n_elements) {
+  float (*get)(MinTree, int, int) = [](MinTree tree, int i, int j) { return tree[i][j]; };
+  return this->treeToStr(this->min_tree, get, max_n_elements);
+}
+
 template <class Tree, class T>
 std::string PriorityTree::treeToStr(Tree tree, T (*get)(Tree, int, int), int max_n_elements, int precision) {
   int n = static_cast<int>(tree.size());
@@ -309,45 +694,122 @@ std::string PriorityTree::treeToStr(Tree tree, T (*get)(Tree, int, int), int max
   return out.str();
 }
 
-void PriorityTree::load(std::istream &checkpoint) {
+void PriorityTree::load(std::istream &checkpoint, bool compressed, int version) {
   // Load the priority tree from the checkpoint.
   this->initial_priority = load_value<float>(checkpoint);
   this->capacity = load_value<int>(checkpoint);
   this->n_children = load_value<int>(checkpoint);
   this->depth = load_value<int>(checkpoint);
   this->current_id = load_value<int>(checkpoint);
-  this->need_refresh_all = load_value<bool>(checkpoint);
-  this->priorities = load_tensor<float>(checkpoint);
   this->sum_tree.clear();
-  this->sum_tree.reserve(this->depth);
-  for (auto i = 0; i < this->depth; i++) {
-    this->sum_tree.push_back(load_vector<double>(checkpoint));
+  this->fenwick_tree.clear();
+
+  // Checkpoints written before the format was versioned store a flag instead of the refresh index, followed by the
+  // priorities, the n-ary sum-tree and the max-tree. The trees are rebuilt from the priorities, keeping the sum-tree
+  // type and prioritization of the constructor.
+  if (version == 0) {
+    load_value<bool>(checkpoint);
+    this->priorities = load_tensor<float>(checkpoint);
+    for (auto i = 0; i < this->depth; i++) {
+      load_vector<double>(checkpoint);
+    }
+    load_vector<torch::Tensor, float>(checkpoint);
+    this->refresh_index = 0;
+    this->fenwick_mask = PriorityTree::fenwickMask(this->capacity);
+    this->refreshAll();
+    return;
+  }
+  this->refresh_index = load_value<int>(checkpoint);
+  this->sum_tree_type = static_cast<SumTreeType>(load_value<int>(checkpoint));
+  this->fenwick_mask = load_value<int>(checkpoint);
+  this->prioritization = static_cast<PrioritizationType>(load_value<int>(checkpoint));
+  this->omega = load_value<float>(checkpoint);
+
+  // Compressed checkpoints only store the priorities, so rebuild the sum-tree and max-tree from them.
+  if (compressed == true) {
+    this->priorities = load_compressed_tensor<float>(checkpoint);
+    this->refreshAll();
+    return;
+  }
+  this->priorities = load_tensor<float>(checkpoint);
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    this->fenwick_tree = load_vector<double>(checkpoint);
+  } else {
+    this->sum_tree.reserve(this->depth);
+    for (auto i = 0; i < this->depth; i++) {
+      this->sum_tree.push_back(load_vector<double>(checkpoint));
+    }
   }
   this->max_tree = load_vector<torch::Tensor, float>(checkpoint);
+  this->min_tree.clear();
+  this->min_tree.reserve(this->depth);
+  for (auto i = 0; i < this->depth; i++) {
+    this->min_tree.push_back(load_vector<float>(checkpoint));
+  }
+
+  // The rank tree is never stored in the checkpoint, since it is cheap to rebuild from the priorities.
+  this->refreshAllRankTree();
 }
 
-void PriorityTree::save(std::ostream &checkpoint) {
+void PriorityTree::save(std::ostream &checkpoint, bool compressed) {
   // Save the priority tree in the checkpoint.
   save_value(this->initial_priority, checkpoint);
   save_value(this->capacity, checkpoint);
   save_value(this->n_children, checkpoint);
   save_value(this->depth, checkpoint);
   save_value(this->current_id, checkpoint);
-  save_value(this->need_refresh_all, checkpoint);
+  save_value(this->refresh_index, checkpoint);
+  save_value(static_cast<int>(this->sum_tree_type), checkpoint);
+  save_value(this->fenwick_mask, checkpoint);
+  save_value(static_cast<int>(this->prioritization), checkpoint);
+  save_value(this->omega, checkpoint);
+
+  // The sum-tree and max-tree are derived from the priorities, so compressed checkpoints do not store them.
+  if (compressed == true) {
+    save_compressed_tensor<float>(this->priorities, checkpoint);
+    return;
+  }
   save_tensor<float>(this->priorities, checkpoint);
-  for (auto i = 0; i < this->depth; i++) {
-    save_vector(this->sum_tree[i], checkpoint);
+  if (this->sum_tree_type == SumTreeType::FENWICK) {
+    save_vector(this->fenwick_tree, checkpoint);
+  } else {
+    for (auto i = 0; i < this->depth; i++) {
+      save_vector(this->sum_tree[i], checkpoint);
+    }
   }
   save_vector<torch::Tensor, float>(this->max_tree, checkpoint);
+  for (auto i = 0; i < this->depth; i++) {
+    save_vector(this->min_tree[i], checkpoint);
+  }
+}
+
+int64_t PriorityTree::memoryUsage() {
+  int64_t n_bytes = this->priorities.nbytes();
+  for (auto &level : this->sum_tree) {
+    n_bytes += level.capacity() * sizeof(double);
+  }
+  n_bytes += this->fenwick_tree.capacity() * sizeof(double);
+  for (auto &level : this->max_tree) {
+    n_bytes += level.nbytes();
+  }
+  for (auto &level : this->min_tree) {
+    n_bytes += level.capacity() * sizeof(float);
+  }
+
+  // The nodes of the rank tree store an element, three pointers, a color and the size of their subtree.
+  n_bytes += this->rank_cdf.capacity() * sizeof(double);
+  n_bytes += this->rank_tree.size() * (sizeof(std::pair<float, int>) + 5 * sizeof(void *));
+  return n_bytes;
 }
 
 void PriorityTree::print(bool verbose, const std::string &prefix) {
   // Display the most important information about the data buffer.
   std::cout << "PriorityTree[initial_priority: " << this->initial_priority << ", capacity: " << this->capacity
-            << ", n_children: " << this->n_children << ", depth: " << this->depth
-            << ", current_id: " << this->current_id << ", need_refresh_all: ";
-  print_bool(this->need_refresh_all);
-  std::cout << "]" << std::endl;
+            << ", n_children: " << this->n_children
+            << ", sum_tree_type: " << static_cast<int>(this->sum_tree_type)
+            << ", prioritization: " << static_cast<int>(this->prioritization) << ", omega: " << this->omega
+            << ", depth: " << this->depth
+            << ", current_id: " << this->current_id << ", refresh_index: " << this->refresh_index << "]" << std::endl;
 
   // Display optional information about the data buffer.
   if (verbose == true) {
@@ -355,6 +817,7 @@ void PriorityTree::print(bool verbose, const std::string &prefix) {
     print_tensor<float>(this->priorities, 10);
     std::cout << prefix << " #-> sum_tree = " << this->sumTreeToStr(3) << std::endl;
     std::cout << prefix << " #-> max_tree = " << this->maxTreeToStr(3) << std::endl;
+    std::cout << prefix << " #-> min_tree = " << this->minTreeToStr(3) << std::endl;
   }
 }
 
@@ -363,9 +826,12 @@ bool operator==(const PriorityTree &lhs, const PriorityTree &rhs) {
   if (lhs.initial_priority != rhs.initial_priority ||  //
       lhs.capacity != rhs.capacity ||                  //
       lhs.n_children != rhs.n_children ||              //
+      lhs.sum_tree_type != rhs.sum_tree_type ||        //
+      lhs.prioritization != rhs.prioritization ||      //
+      lhs.omega != rhs.omega ||                        //
       lhs.depth != rhs.depth ||                        //
       lhs.current_id != rhs.current_id ||              //
-      lhs.need_refresh_all != rhs.need_refresh_all     //
+      lhs.refresh_index != rhs.refresh_index           //
   ) {
     return false;
   }
@@ -386,6 +852,10 @@ bool operator==(const PriorityTree &lhs, const PriorityTree &rhs) {
     }
   }
 
+  // Compare the Fenwick trees.
+  if (lhs.fenwick_tree != rhs.fenwick_tree)
+    return false;
+
   // Compare the max-trees.
   if (lhs.max_tree.size() != rhs.max_tree.size())
     return false;
@@ -393,6 +863,10 @@ bool operator==(const PriorityTree &lhs, const PriorityTree &rhs) {
     if (!tensorsAreEqual(lhs.max_tree[i], rhs.max_tree[i]))
       return false;
   }
+
+  // Compare the min-trees.
+  if (lhs.min_tree != rhs.min_tree)
+    return false;
   return true;
 }
 }  // namespace relab::agents::memory::impl
@@ -9,11 +9,14 @@
 #include <map>
 #include <memory>
 #include <random>
+#include <stdexcept>
 #include <string>
 
 #include "helpers/debug.hpp"
 #include "helpers/serialize.hpp"
+#include "helpers/stats.hpp"
 #include "helpers/torch.hpp"
+#include "helpers/trace.hpp"
 
 using namespace relab::helpers;
 using namespace std::experimental::filesystem;
@@ -22,11 +25,11 @@ namespace relab::agents::memory {
 
 ReplayBuffer::ReplayBuffer(
     int capacity, int batch_size, int frame_skip, int stack_size, int screen_size, CompressorType type,
-    std::map<std::string, float> args
+    std::map<std::string, float> args, const std::vector<int> &cpu_affinity
 ) : device(getDevice()) {
   // Keep in mind whether the replay buffer is prioritized.
   this->prioritized = false;
-  for (auto key : {"initial_priority", "omega", "omega_is", "n_children"}) {
+  for (auto key : {"initial_priority", "omega", "omega_is", "n_children", "prioritization"}) {
     if (args.find(key) != args.end()) {
       this->prioritized = true;
       break;
@@ -35,7 +38,13 @@ ReplayBuffer::ReplayBuffer(
 
   // Default values of the prioritization and multistep arguments.
   std::map<std::string, float> default_args = {{"initial_priority", 1.0}, {"omega", 1.0},   {"omega_is", 1.0},
-                                               {"n_children", 10},        {"n_steps", 1.0}, {"gamma", 0.99}};
+                                               {"n_children", 10},        {"n_steps", 1.0}, {"gamma", 0.99},
+                                               {"compress_checkpoint", 0}, {"dedup_window", 0},
+                                               {"dictionary_frames", 0},  {"sum_tree_type", 0},
+                                               {"prioritization", 0},     {"numa", 0},
+                                               {"n_threads", 0},          {"shared_pool", 0},
+                                               {"n_channels", 1},         {"frame_height", 0},
+                                               {"frame_width", 0}};
 
   // Complete arguments with default values.
   args.insert(default_args.begin(), default_args.end());
@@ -51,26 +60,85 @@ ReplayBuffer::ReplayBuffer(
   this->n_children = static_cast<int>(args["n_children"]);
   this->omega = args["omega"];
   this->omega_is = args["omega_is"];
+  this->compress_checkpoint = (args["compress_checkpoint"] != 0);
+
+  // By default, use one thread per experience in a batch, but no more threads than allowed CPUs. The shared pool
+  // serves buffers of any batch size, so it uses one thread per allowed CPU.
+  int n_cpus = (cpu_affinity.empty() == true) ? static_cast<int>(std::thread::hardware_concurrency())
+                                              : static_cast<int>(cpu_affinity.size());
+  this->n_threads = static_cast<int>(args["n_threads"]);
+  if (this->n_threads <= 0) {
+    this->n_threads = std::max((args["shared_pool"] != 0) ? n_cpus : std::min(n_cpus, batch_size), 1);
+  }
+
+  // The shape of the frames, whose height and width default to the screen size, and whose channel dimension is
+  // omitted for single-channel frames.
+  int n_channels = static_cast<int>(args["n_channels"]);
+  int frame_height = (args["frame_height"] > 0) ? static_cast<int>(args["frame_height"]) : screen_size;
+  int frame_width = (args["frame_width"] > 0) ? static_cast<int>(args["frame_width"]) : screen_size;
+  std::vector<int64_t> frame_shape = {frame_height, frame_width};
+  if (n_channels > 1) {
+    frame_shape.insert(frame_shape.begin(), n_channels);
+  }
 
   // The buffer storing the frames of all experiences.
-  int n_threads = std::min(static_cast<int>(std::thread::hardware_concurrency()), batch_size);
+  int dedup_window = static_cast<int>(args["dedup_window"]);
+  int dictionary_frames = static_cast<int>(args["dictionary_frames"]);
   this->observations = std::make_unique<FrameBuffer>(
-      this->capacity, this->frame_skip, this->n_steps, this->stack_size, screen_size, type, n_threads
+      this->capacity, this->frame_skip, this->n_steps, this->stack_size, frame_shape, type, this->n_threads,
+      dedup_window, dictionary_frames, args["numa"] != 0, cpu_affinity, args["shared_pool"] != 0
   );
 
   // The buffer storing the data (i.e., actions, rewards, dones and priorities)
   // of all experiences.
+  auto sum_tree_type = static_cast<SumTreeType>(static_cast<int>(args["sum_tree_type"]));
+  auto prioritization = static_cast<PrioritizationType>(static_cast<int>(args["prioritization"]));
   this->data = std::make_unique<DataBuffer>(
-      this->capacity, this->n_steps, this->gamma, this->initial_priority, this->n_children
+      this->capacity, this->n_steps, this->gamma, this->initial_priority, this->n_children, sum_tree_type,
+      prioritization, this->omega
   );
+
+  // Rebuild all the priority trees at once with the thread pool of the buffer, so that its size, pinning and NUMA
+  // placement are respected.
+  this->data->getPriorities()->setThreadPool(this->observations->getThreadPool());
 }
 
 void ReplayBuffer::append(const Experience &experience) {
+  RELAB_MEASURE(Operation::APPEND);
+  RELAB_TRACE("ReplayBuffer::append");
   this->observations->append(experience);
   this->data->append(experience);
 }
 
-Batch ReplayBuffer::sample() {
+void ReplayBuffer::beginEpisode(const torch::Tensor &initial_stack) {
+  if (this->observations->getNewEpisode() == false) {
+    throw std::runtime_error("A new episode can only begin once the previous episode has ended.");
+  }
+  this->initial_stack = initial_stack;
+}
+
+void ReplayBuffer::appendStep(const torch::Tensor &frame, int action, float reward, bool done) {
+  // The frame buffer only reads the observation at time t at the beginning of an episode, so the first observation
+  // of the episode is passed with every step, and is only required by the first one.
+  if (this->observations->getNewEpisode() == true && this->initial_stack.defined() == false) {
+    throw std::runtime_error("An episode must begin before its steps are added to the replay buffer.");
+  }
+  int frame_dims = static_cast<int>(this->observations->getFrameShape().size());
+  torch::Tensor next_frames = (frame.dim() == frame_dims) ? frame.unsqueeze(0) : frame;
+  this->append(Experience(this->initial_stack, action, reward, done, next_frames));
+
+  // Forget the first observation of the episode, once it has ended.
+  if (done == true) {
+    this->initial_stack = torch::Tensor();
+  }
+}
+
+Batch ReplayBuffer::sample() { return this->sample(this->stack_size); }
+
+Batch ReplayBuffer::sample(int stack_size, int stride) {
+  RELAB_MEASURE(Operation::SAMPLE);
+  RELAB_TRACE("ReplayBuffer::sample");
+
   // Sample a batch from the replay buffer.
   if (this->prioritized == true) {
     this->indices = this->data->getPriorities()->sampleIndices(this->batch_size);
@@ -79,10 +147,15 @@ Batch ReplayBuffer::sample() {
   }
 
   // Retrieve the batch corresponding to the sampled indices.
-  return this->getExperiences(this->indices);
+  return this->getExperiences(this->indices, stack_size, stride);
 }
 
-torch::Tensor ReplayBuffer::report(torch::Tensor &loss) {
+torch::Tensor ReplayBuffer::report(torch::Tensor &loss) { return this->report(loss, this->indices); }
+
+torch::Tensor ReplayBuffer::report(torch::Tensor &loss, const torch::Tensor &indices) {
+  RELAB_MEASURE(Operation::REPORT);
+  RELAB_TRACE("ReplayBuffer::report");
+
   // If the buffer is not prioritized, don't update the priorities.
   if (this->prioritized == false) {
     return loss;
@@ -96,17 +169,12 @@ torch::Tensor ReplayBuffer::report(torch::Tensor &loss) {
     loss = loss.pow(this->omega);
   }
 
-  // Collect the old priorities.
-  torch::Tensor priorities = torch::zeros({this->batch_size}, at::kFloat);
-  for (int i = 0; i < this->batch_size; i++) {
-    int idx = this->indices[i].item<int>();
-    priorities[i] = this->data->getPriorities()->get(idx);
-  }
+  // Compute the importance sampling weights from the old priorities, normalized by the largest weight in the buffer.
+  torch::Tensor weights = this->data->getPriorities()->importanceWeights(indices, this->omega_is);
 
   // Update the priorities.
-  float sum_priorities = this->data->getPriorities()->sum();
-  for (int i = 0; i < this->batch_size; i++) {
-    int idx = this->indices[i].item<int>();
+  for (int i = 0; i < indices.size(0); i++) {
+    int idx = indices[i].item<int>();
     float priority = loss[i].item<float>();
     if (std::isfinite(priority) == false) {
       priority = this->data->getPriorities()->max();
@@ -114,10 +182,47 @@ torch::Tensor ReplayBuffer::report(torch::Tensor &loss) {
     this->data->getPriorities()->set(idx, priority);
   }
 
-  // Update the priorities and compute the importance sampling weights.
-  torch::Tensor weights = this->size() * priorities.to(this->device) / sum_priorities;
-  weights = torch::pow(weights, -this->omega_is);
-  return loss * weights / weights.max();
+  // Weight the loss using the importance sampling weights.
+  return loss * weights.to(this->device);
+}
+
+void ReplayBuffer::reportAll(torch::Tensor &loss) {
+  RELAB_TRACE("ReplayBuffer::reportAll");
+
+  // If the buffer is not prioritized, don't update the priorities.
+  if (this->prioritized == false) {
+    return;
+  }
+
+  // Compute the priorities as in the report function, replacing non-finite priorities by the largest priority.
+  torch::Tensor priorities = (loss.detach().to(torch::kCPU, torch::kFloat32) + 1e-5).pow(this->omega);
+  float max_priority = this->data->getPriorities()->max();
+  priorities = torch::where(torch::isfinite(priorities), priorities, torch::full_like(priorities, max_priority));
+
+  // Replace all the priorities, and rebuild the priority tree with the thread pool of the buffer.
+  this->data->getPriorities()->assignAll(priorities);
+}
+
+int ReplayBuffer::drain(SharedExperienceQueue &queue, int max_experiences) {
+  RELAB_TRACE("ReplayBuffer::drain");
+
+  // Append the experiences in the order they were pushed, until the queue is empty or enough experiences were moved.
+  // The frames of an experience are stored as references to the frames of the previous one, so the experiences of
+  // another actor would corrupt the stored episodes.
+  int n_experiences = 0;
+  int actor = 0;
+  while (max_experiences < 0 || n_experiences < max_experiences) {
+    auto experience = queue.pop(actor);
+    if (experience.has_value() == false) {
+      break;
+    }
+    if (actor != 0) {
+      throw std::runtime_error("A replay buffer can only drain the experiences of actor 0, use a sharded buffer.");
+    }
+    this->append(experience.value());
+    n_experiences += 1;
+  }
+  return n_experiences;
 }
 
 void ReplayBuffer::load(std::string checkpoint_path, std::string checkpoint_name, bool save_all) {
@@ -135,7 +240,10 @@ void ReplayBuffer::load(std::string checkpoint_path, std::string checkpoint_name
 }
 
 void ReplayBuffer::loadFromFile(std::istream &checkpoint) {
-  // Read the replay buffer from the checkpoint file.
+  RELAB_MEASURE(Operation::LOAD);
+
+  // Read the replay buffer from the checkpoint file, whose format depends on its version.
+  int version = load_checkpoint_version(checkpoint);
   this->prioritized = load_value<bool>(checkpoint);
   this->capacity = load_value<int>(checkpoint);
   this->batch_size = load_value<int>(checkpoint);
@@ -147,8 +255,13 @@ void ReplayBuffer::loadFromFile(std::istream &checkpoint) {
   this->n_children = load_value<int>(checkpoint);
   this->omega = load_value<float>(checkpoint);
   this->omega_is = load_value<float>(checkpoint);
-  this->observations->load(checkpoint);
-  this->data->load(checkpoint);
+  bool compressed = false;
+  if (version >= 1) {
+    this->compress_checkpoint = load_value<bool>(checkpoint);
+    compressed = this->compress_checkpoint;
+  }
+  this->observations->load(checkpoint, compressed, version);
+  this->data->load(checkpoint, compressed, version);
   this->indices = load_tensor<int64_t>(checkpoint);
 }
 
@@ -169,7 +282,10 @@ void ReplayBuffer::save(std::string checkpoint_path, std::string checkpoint_name
 }
 
 void ReplayBuffer::saveToFile(std::ostream &checkpoint) {
-  // Write the replay buffer in the checkpoint file.
+  RELAB_MEASURE(Operation::SAVE);
+
+  // Write the replay buffer in the checkpoint file, starting with the version of its format.
+  save_checkpoint_version(checkpoint);
   save_value(this->prioritized, checkpoint);
   save_value(this->capacity, checkpoint);
   save_value(this->batch_size, checkpoint);
@@ -181,8 +297,9 @@ void ReplayBuffer::saveToFile(std::ostream &checkpoint) {
   save_value(this->n_children, checkpoint);
   save_value(this->omega, checkpoint);
   save_value(this->omega_is, checkpoint);
-  this->observations->save(checkpoint);
-  this->data->save(checkpoint);
+  save_value(this->compress_checkpoint, checkpoint);
+  this->observations->save(checkpoint, this->compress_checkpoint);
+  this->data->save(checkpoint, this->compress_checkpoint);
   save_tensor<int64_t>(this->indices, checkpoint);
 }
 
@@ -209,7 +326,9 @@ void ReplayBuffer::print(bool verbose) {
             << ", stack_size: " << this->stack_size << ", frame_skip: " << this->frame_skip
             << ", gamma: " << this->gamma << ", n_steps: " << this->n_steps
             << ", initial_priority: " << this->initial_priority << ", n_children: " << this->n_children
-            << ", omega: " << this->omega << ", omega_is: " << this->omega_is << "]" << std::endl;
+            << ", omega: " << this->omega << ", omega_is: " << this->omega_is << ", compress_checkpoint: ";
+  print_bool(this->compress_checkpoint);
+  std::cout << "]" << std::endl;
 
   // Display optional information about the replay buffer.
   if (verbose == true) {
@@ -222,9 +341,14 @@ void ReplayBuffer::print(bool verbose) {
   }
 }
 
-Batch ReplayBuffer::getExperiences(torch::Tensor &indices) {
-  auto observations = (*this->observations)[indices];
+Batch ReplayBuffer::getExperiences(torch::Tensor &indices) { return this->getExperiences(indices, this->stack_size); }
+
+Batch ReplayBuffer::getExperiences(torch::Tensor &indices, int stack_size, int stride) {
+  auto observations = this->observations->getObservations(indices, stack_size, stride);
   auto data = (*this->data)[indices];
+
+  // Move the observations to the device.
+  RELAB_TRACE("ReplayBuffer::toDevice");
   return std::make_tuple(
       std::get<0>(observations).to(this->device), std::get<0>(data), std::get<1>(data), std::get<2>(data),
       std::get<1>(observations).to(this->device)
@@ -233,16 +357,53 @@ Batch ReplayBuffer::getExperiences(torch::Tensor &indices) {
 
 int ReplayBuffer::size() { return this->observations->size(); }
 
+int ReplayBuffer::nEvicted() { return this->data->nEvicted(); }
+
 void ReplayBuffer::clear() {
   this->observations->clear();
   this->data->clear();
   this->indices = torch::Tensor();
+  this->initial_stack = torch::Tensor();
+}
+
+void ReplayBuffer::endEpisode() {
+  this->observations->endEpisode();
+  this->data->endEpisode();
+  this->initial_stack = torch::Tensor();
 }
 
 bool ReplayBuffer::getPrioritized() { return this->prioritized; }
 
 torch::Tensor ReplayBuffer::getLastIndices() { return this->indices; }
 
+std::map<std::string, std::map<std::string, double>> ReplayBuffer::stats() { return Stats::global().summary(); }
+
+std::map<std::string, double> ReplayBuffer::memoryStats() {
+  // Collect the memory used by each component.
+  auto stats = this->observations->memoryStats();
+  auto data_stats = this->data->memoryStats();
+  stats.insert(data_stats.begin(), data_stats.end());
+  double total = 0;
+  for (auto key : {"compressed_frames", "frame_metadata", "frame_handles", "references", "data", "priority_trees"}) {
+    total += stats[key];
+  }
+  stats["total"] = total;
+
+  // Compute the compression ratio of the stored frames.
+  double compressed_size = stats["compressed_frames"];
+  stats["compression_ratio"] = (compressed_size == 0) ? 0 : stats["uncompressed_frames"] / compressed_size;
+
+  // Project the memory used when the buffer is full, only the frames and their headers grow with the number of
+  // experiences since the other components, including the frame handles, are allocated upfront.
+  int size = this->size();
+  double frames_size = compressed_size + stats["frame_metadata"];
+  double growth = (size == 0) ? 0 : static_cast<double>(this->capacity) / size - 1;
+  stats["projected_total"] = total + growth * frames_size;
+  return stats;
+}
+
+std::unique_ptr<PriorityTree> &ReplayBuffer::getPriorities() { return this->data->getPriorities(); }
+
 float ReplayBuffer::getPriority(int index) { return this->data->getPriorities()->get(index); }
 
 bool operator==(const ReplayBuffer &lhs, const ReplayBuffer &rhs) {
@@ -250,7 +411,7 @@ bool operator==(const ReplayBuffer &lhs, const ReplayBuffer &rhs) {
   if (lhs.prioritized != rhs.prioritized || lhs.capacity != rhs.capacity || lhs.batch_size != rhs.batch_size ||
       lhs.stack_size != rhs.stack_size || lhs.frame_skip != rhs.frame_skip || lhs.gamma != rhs.gamma ||
       lhs.n_steps != rhs.n_steps || lhs.initial_priority != rhs.initial_priority || lhs.n_children != rhs.n_children ||
-      lhs.omega != rhs.omega || lhs.omega_is != rhs.omega_is) {
+      lhs.omega != rhs.omega || lhs.omega_is != rhs.omega_is || lhs.compress_checkpoint != rhs.compress_checkpoint) {
     return false;
   }
 
@@ -0,0 +1,122 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "agents/memory/replay_client.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "helpers/serialize.hpp"
+#include "helpers/trace.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::agents::memory::impl {
+
+/**
+ * Implementation of the ReplayClient methods.
+ */
+
+ReplayClient::ReplayClient(const std::string &socket_path) {
+  // Check that the path fits in a socket address.
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("The replay server socket path is too long: " + socket_path + ".");
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  // Connect to the server.
+  this->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (this->fd == -1 || connect(this->fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+    if (this->fd != -1) {
+      close(this->fd);
+    }
+    throw std::runtime_error("Could not connect to the replay server: " + socket_path + ".");
+  }
+}
+
+ReplayClient::~ReplayClient() { close(this->fd); }
+
+void ReplayClient::append(const std::vector<Experience> &experiences) {
+  RELAB_TRACE("ReplayClient::append");
+  std::ostringstream request;
+  saveExperiences(experiences, request);
+  sendMessage(this->fd, MessageType::APPEND, request.str());
+}
+
+void ReplayClient::requestSample() {
+  sendMessage(this->fd, MessageType::SAMPLE);
+  this->pending_requests.push_back(MessageType::SAMPLE);
+}
+
+Batch ReplayClient::receiveSample() {
+  RELAB_TRACE("ReplayClient::receiveSample");
+
+  // Return the oldest batch, requesting and receiving it if needed.
+  if (this->received_batches.empty()) {
+    if (std::find(this->pending_requests.begin(), this->pending_requests.end(), MessageType::SAMPLE) ==
+        this->pending_requests.end()) {
+      this->requestSample();
+    }
+    this->waitFor(MessageType::SAMPLE);
+  }
+  Batch batch = this->received_batches.front();
+  this->received_batches.pop_front();
+  return batch;
+}
+
+Batch ReplayClient::sample() {
+  this->requestSample();
+  return this->receiveSample();
+}
+
+torch::Tensor ReplayClient::report(const torch::Tensor &loss) {
+  RELAB_TRACE("ReplayClient::report");
+  std::ostringstream request;
+  save_tensor<float>(loss.detach().to(torch::kCPU, torch::kFloat32).contiguous(), request);
+  sendMessage(this->fd, MessageType::REPORT, request.str());
+  this->pending_requests.push_back(MessageType::REPORT);
+  std::istringstream response(this->waitFor(MessageType::REPORT).payload);
+  return load_tensor<float>(response).to(loss.device());
+}
+
+int ReplayClient::size() {
+  sendMessage(this->fd, MessageType::SIZE);
+  this->pending_requests.push_back(MessageType::SIZE);
+  std::istringstream response(this->waitFor(MessageType::SIZE).payload);
+  return load_value<int>(response);
+}
+
+Message ReplayClient::waitFor(MessageType type) {
+  while (true) {
+    // Receive the response to the oldest pending request.
+    auto message = receiveMessage(this->fd);
+    if (message.has_value() == false || this->pending_requests.empty()) {
+      throw std::runtime_error("The replay server closed the connection or sent an unexpected response.");
+    }
+    MessageType request_type = this->pending_requests.front();
+    this->pending_requests.pop_front();
+    if (message->type == MessageType::FAILURE) {
+      throw std::runtime_error("The replay server could not answer a request: " + message->payload);
+    }
+
+    // Store the batches, and stop when the response to a request of the given type is received.
+    if (request_type == MessageType::SAMPLE) {
+      std::istringstream response(message->payload);
+      this->received_batches.push_back(loadBatch(response));
+    }
+    if (request_type == type) {
+      return message.value();
+    }
+  }
+}
+}  // namespace relab::agents::memory::impl
@@ -0,0 +1,182 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "agents/memory/replay_protocol.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "helpers/serialize.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::agents::memory {
+
+/**
+ * Write all the bytes of a buffer into a socket.
+ * @param fd the socket
+ * @param data the bytes to write
+ * @param size the number of bytes to write
+ */
+static void writeAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n_bytes = send(fd, data, size, MSG_NOSIGNAL);
+    if (n_bytes == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n_bytes <= 0) {
+      throw std::runtime_error("Could not write into the replay server socket.");
+    }
+    data += n_bytes;
+    size -= n_bytes;
+  }
+}
+
+/**
+ * Read a given number of bytes from a socket.
+ * @param fd the socket
+ * @param data the buffer in which the bytes must be written
+ * @param size the number of bytes to read
+ * @return false if the socket was closed before any byte was read, true otherwise
+ */
+static bool readAll(int fd, char *data, size_t size) {
+  size_t n_read = 0;
+  while (n_read < size) {
+    ssize_t n_bytes = recv(fd, data + n_read, size - n_read, 0);
+    if (n_bytes == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n_bytes == 0 && n_read == 0) {
+      return false;
+    }
+    if (n_bytes <= 0) {
+      throw std::runtime_error("Could not read from the replay server socket.");
+    }
+    n_read += n_bytes;
+  }
+  return true;
+}
+
+/**
+ * Check that the payload size read from a message header is valid.
+ * @param size the payload size
+ */
+static void checkPayloadSize(int64_t size) {
+  if (size < 0 || size > MAX_PAYLOAD_SIZE) {
+    throw std::runtime_error("The replay server socket received a message with an invalid size.");
+  }
+}
+
+/**
+ * Append the header of a message to a buffer of bytes to send.
+ * @param buffer the buffer of bytes to send
+ * @param type the message type
+ * @param size the payload size
+ */
+static void appendHeader(std::string &buffer, MessageType type, int64_t size) {
+  int32_t type_value = static_cast<int32_t>(type);
+  buffer.append(reinterpret_cast<const char *>(&type_value), sizeof(type_value));
+  buffer.append(reinterpret_cast<const char *>(&size), sizeof(size));
+}
+
+void appendMessage(std::string &buffer, MessageType type, const std::string &payload) {
+  appendHeader(buffer, type, static_cast<int64_t>(payload.size()));
+  buffer.append(payload);
+}
+
+std::optional<Message> extractMessage(std::string &buffer) {
+  // Read the header, if it was received.
+  if (buffer.size() < MESSAGE_HEADER_SIZE) {
+    return std::nullopt;
+  }
+  int32_t type_value = 0;
+  int64_t size = 0;
+  std::memcpy(&type_value, buffer.data(), sizeof(type_value));
+  std::memcpy(&size, buffer.data() + sizeof(type_value), sizeof(size));
+  checkPayloadSize(size);
+
+  // Read the payload, if it was received.
+  if (buffer.size() < MESSAGE_HEADER_SIZE + size) {
+    return std::nullopt;
+  }
+  Message message{static_cast<MessageType>(type_value), buffer.substr(MESSAGE_HEADER_SIZE, size)};
+  buffer.erase(0, MESSAGE_HEADER_SIZE + size);
+  return message;
+}
+
+void sendMessage(int fd, MessageType type, const std::string &payload) {
+  std::string header;
+  appendHeader(header, type, static_cast<int64_t>(payload.size()));
+  writeAll(fd, header.data(), header.size());
+  writeAll(fd, payload.data(), payload.size());
+}
+
+std::optional<Message> receiveMessage(int fd) {
+  // Read the header.
+  int32_t type_value = 0;
+  int64_t size = 0;
+  if (readAll(fd, reinterpret_cast<char *>(&type_value), sizeof(type_value)) == false) {
+    return std::nullopt;
+  }
+  if (readAll(fd, reinterpret_cast<char *>(&size), sizeof(size)) == false) {
+    throw std::runtime_error("The replay server socket was closed in the middle of a message.");
+  }
+  checkPayloadSize(size);
+
+  // Read the payload.
+  Message message{static_cast<MessageType>(type_value), std::string(size, '\0')};
+  if (size > 0 && readAll(fd, message.payload.data(), size) == false) {
+    throw std::runtime_error("The replay server socket was closed in the middle of a message.");
+  }
+  return message;
+}
+
+void saveExperiences(const std::vector<Experience> &experiences, std::ostream &stream) {
+  save_value<int>(static_cast<int>(experiences.size()), stream);
+  for (auto &experience : experiences) {
+    save_tensor<float>(experience.obs.to(torch::kCPU, torch::kFloat32).contiguous(), stream);
+    save_value(experience.action, stream);
+    save_value(experience.reward, stream);
+    save_value(experience.done, stream);
+    save_tensor<float>(experience.next_obs.to(torch::kCPU, torch::kFloat32).contiguous(), stream);
+  }
+}
+
+std::vector<Experience> loadExperiences(std::istream &stream) {
+  int n_experiences = load_value<int>(stream);
+  std::vector<Experience> experiences;
+  experiences.reserve(n_experiences);
+  for (int i = 0; i < n_experiences; i++) {
+    auto obs = load_tensor<float>(stream);
+    auto action = load_value<int>(stream);
+    auto reward = load_value<float>(stream);
+    auto done = load_value<bool>(stream);
+    auto next_obs = load_tensor<float>(stream);
+    experiences.emplace_back(obs, action, reward, done, next_obs);
+  }
+  return experiences;
+}
+
+void saveBatch(const Batch &batch, std::ostream &stream) {
+  auto [obs, actions, rewards, dones, next_obs] = batch;
+  save_tensor<float>(obs.to(torch::kCPU, torch::kFloat32).contiguous(), stream);
+  save_tensor<int>(actions.to(torch::kCPU, torch::kInt32).contiguous(), stream);
+  save_tensor<float>(rewards.to(torch::kCPU, torch::kFloat32).contiguous(), stream);
+  save_tensor<bool>(dones.to(torch::kCPU, torch::kBool).contiguous(), stream);
+  save_tensor<float>(next_obs.to(torch::kCPU, torch::kFloat32).contiguous(), stream);
+}
+
+Batch loadBatch(std::istream &stream) {
+  auto obs = load_tensor<float>(stream);
+  auto actions = load_tensor<int>(stream);
+  auto rewards = load_tensor<float>(stream);
+  auto dones = load_tensor<bool>(stream);
+  auto next_obs = load_tensor<float>(stream);
+  return std::make_tuple(obs, actions, rewards, dones, next_obs);
+}
+}  // namespace relab::agents::memory
@@ -0,0 +1,319 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "agents/memory/replay_server.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "helpers/debug.hpp"
+#include "helpers/serialize.hpp"
+#include "helpers/torch.hpp"
+#include "helpers/trace.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::agents::memory::impl {
+
+/**
+ * Implementation of the ReplayServer methods.
+ */
+
+ReplayServer::ReplayServer(const std::string &socket_path, std::shared_ptr<ReplayBuffer> buffer) :
+    socket_path(socket_path), buffer(buffer), writer(nullptr) {
+  // Check that the path fits in a socket address.
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("The replay server socket path is too long: " + socket_path + ".");
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  // Create the socket accepting connections.
+  unlink(socket_path.c_str());
+  this->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (this->listen_fd == -1 || bind(this->listen_fd, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+      listen(this->listen_fd, SOMAXCONN) == -1) {
+    if (this->listen_fd != -1) {
+      close(this->listen_fd);
+    }
+    throw std::runtime_error("Could not listen on the replay server socket: " + socket_path + ".");
+  }
+
+  // Create the pipe used to stop the server.
+  if (pipe(this->stop_fds) == -1) {
+    close(this->listen_fd);
+    throw std::runtime_error("Could not create the pipe stopping the replay server.");
+  }
+}
+
+ReplayServer::~ReplayServer() {
+  close(this->listen_fd);
+  close(this->stop_fds[0]);
+  close(this->stop_fds[1]);
+  unlink(this->socket_path.c_str());
+}
+
+void ReplayServer::serve() {
+  // The state of each client, indexed by the socket of the client.
+  std::map<int, ReplayConnection> clients;
+
+  // Wait for events only when no client has a request left to answer.
+  int timeout = -1;
+  while (true) {
+    // Wait for a new connection, a request, a client ready to receive its responses, or the stop signal.
+    std::vector<struct pollfd> fds = {{this->stop_fds[0], POLLIN, 0}, {this->listen_fd, POLLIN, 0}};
+    for (auto &[fd, connection] : clients) {
+      short events = (connection.closed == true) ? 0 : POLLIN;
+      if (connection.n_sent < connection.outgoing.size()) {
+        events |= POLLOUT;
+      }
+      fds.push_back({fd, events, 0});
+    }
+    if (poll(fds.data(), fds.size(), timeout) == -1) {
+      continue;
+    }
+
+    // Stop serving, if requested.
+    if (fds[0].revents != 0) {
+      break;
+    }
+
+    // Accept the new connection, whose socket never blocks the server.
+    if ((fds[1].revents & POLLIN) != 0) {
+      int fd = accept(this->listen_fd, nullptr, nullptr);
+      if (fd != -1 && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1) {
+        close(fd);
+      } else if (fd != -1) {
+        clients[fd] = ReplayConnection();
+      }
+    }
+
+    // Receive the requests of the clients and send them their responses, as far as their sockets allow, and forget
+    // about the clients whose connection failed.
+    for (size_t i = 2; i < fds.size(); i++) {
+      int fd = fds[i].fd;
+      auto &connection = clients[fd];
+      try {
+        if ((fds[i].revents & (POLLIN | POLLHUP)) != 0 && connection.closed == false) {
+          this->receiveRequests(fd, connection);
+        }
+        if ((fds[i].revents & POLLOUT) != 0) {
+          this->sendResponses(fd, connection);
+        }
+        if ((fds[i].revents & POLLERR) != 0) {
+          throw std::runtime_error("The replay server socket failed.");
+        }
+      } catch (const std::exception &error) {
+        logging.warning("Replay server client disconnected: " + std::string(error.what()));
+        this->disconnect(fd, clients);
+      }
+    }
+
+    // Answer one request of each client, so that a client sending many requests does not delay the others.
+    std::vector<int> disconnected;
+    timeout = -1;
+    for (auto &[fd, connection] : clients) {
+      if (connection.requests.empty() == true) {
+        continue;
+      }
+      this->answer(connection.requests.front(), connection);
+      connection.requests.pop_front();
+      if (connection.requests.empty() == false) {
+        timeout = 0;
+      }
+      try {
+        this->sendResponses(fd, connection);
+      } catch (const std::exception &error) {
+        logging.warning("Replay server client disconnected: " + std::string(error.what()));
+        disconnected.push_back(fd);
+      }
+    }
+
+    // Add the experiences of the clients that waited for another client's episode to end, and keep serving without
+    // waiting for events while a client can add its experiences.
+    for (auto &[fd, connection] : clients) {
+      this->addPendingExperiences(connection);
+    }
+    for (auto &[fd, connection] : clients) {
+      if (connection.pending.empty() == false && (this->writer == nullptr || this->writer == &connection)) {
+        timeout = 0;
+      }
+    }
+
+    // Forget about the clients that disconnected, and the ones that closed the connection once they are answered and
+    // their experiences are added to the buffer.
+    for (auto &[fd, connection] : clients) {
+      if (connection.closed == true && connection.requests.empty() == true && connection.outgoing.empty() == true &&
+          connection.pending.empty() == true) {
+        disconnected.push_back(fd);
+      }
+    }
+    for (int fd : disconnected) {
+      this->disconnect(fd, clients);
+    }
+  }
+
+  // Disconnect all clients.
+  while (clients.empty() == false) {
+    this->disconnect(clients.begin()->first, clients);
+  }
+}
+
+void ReplayServer::addPendingExperiences(ReplayConnection &connection) {
+  if (this->writer != nullptr && this->writer != &connection) {
+    return;
+  }
+  while (connection.pending.empty() == false) {
+    Experience experience = std::move(connection.pending.front());
+    connection.pending.pop_front();
+    try {
+      this->buffer->append(experience);
+    } catch (const std::exception &error) {
+      logging.warning("Replay server could not append an experience: " + std::string(error.what()));
+    }
+    this->writer = (experience.done == true) ? nullptr : &connection;
+    if (this->writer == nullptr) {
+      break;
+    }
+  }
+}
+
+void ReplayServer::disconnect(int fd, std::map<int, ReplayConnection> &clients) {
+  auto connection = clients.find(fd);
+  if (connection == clients.end()) {
+    return;
+  }
+  if (this->writer == &connection->second) {
+    this->buffer->endEpisode();
+    this->writer = nullptr;
+  }
+  close(fd);
+  clients.erase(connection);
+}
+
+void ReplayServer::receiveRequests(int fd, ReplayConnection &connection) {
+  // Read the bytes available, up to a limit so that a client streaming experiences does not delay the others.
+  char data[65536];
+  for (size_t n_read = 0; n_read < 16 * sizeof(data);) {
+    ssize_t n_bytes = recv(fd, data, sizeof(data), 0);
+    if (n_bytes == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n_bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n_bytes == -1) {
+      throw std::runtime_error("Could not read from the replay server socket.");
+    }
+    if (n_bytes == 0) {
+      connection.closed = true;
+      break;
+    }
+    connection.incoming.append(data, n_bytes);
+    n_read += n_bytes;
+  }
+
+  // Queue the requests entirely received.
+  while (auto message = extractMessage(connection.incoming)) {
+    connection.requests.push_back(std::move(message.value()));
+  }
+  if (connection.closed == true && connection.incoming.empty() == false) {
+    logging.warning("Replay server client closed the connection in the middle of a request.");
+  }
+}
+
+void ReplayServer::sendResponses(int fd, ReplayConnection &connection) {
+  while (connection.n_sent < connection.outgoing.size()) {
+    const char *data = connection.outgoing.data() + connection.n_sent;
+    ssize_t n_bytes = send(fd, data, connection.outgoing.size() - connection.n_sent, MSG_NOSIGNAL);
+    if (n_bytes == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n_bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    }
+    if (n_bytes <= 0) {
+      throw std::runtime_error("Could not write into the replay server socket.");
+    }
+    connection.n_sent += n_bytes;
+  }
+  connection.outgoing.clear();
+  connection.n_sent = 0;
+}
+
+void ReplayServer::stop() {
+  char signal = 0;
+  ssize_t n_bytes = write(this->stop_fds[1], &signal, 1);
+  (void)n_bytes;
+}
+
+void ReplayServer::answer(Message &message, ReplayConnection &connection) {
+  RELAB_TRACE("ReplayServer::answer");
+  std::istringstream request(message.payload);
+  std::ostringstream response;
+  try {
+    switch (message.type) {
+    case MessageType::APPEND:
+      for (auto &experience : loadExperiences(request)) {
+        connection.pending.push_back(std::move(experience));
+      }
+      this->addPendingExperiences(connection);
+      return;
+    case MessageType::SAMPLE:
+      saveBatch(this->buffer->sample(), response);
+      connection.sampled_indices.push_back(this->buffer->getLastIndices() + this->buffer->nEvicted());
+      break;
+    case MessageType::REPORT: {
+      if (connection.sampled_indices.empty()) {
+        throw std::runtime_error("A loss was reported although no batch was sampled.");
+      }
+      torch::Tensor loss = load_tensor<float>(request);
+      torch::Tensor indices = connection.sampled_indices.front() - this->buffer->nEvicted();
+      connection.sampled_indices.pop_front();
+      if (loss.numel() != indices.numel()) {
+        throw std::runtime_error("The reported loss does not match the size of the sampled batch.");
+      }
+
+      // Only report the loss of the experiences that are still in the buffer, the loss of the experiences evicted
+      // since the batch was sampled being returned unchanged.
+      torch::Tensor kept = (indices >= 0);
+      if (kept.any().item<bool>() == true) {
+        torch::Tensor kept_loss = loss.index({kept}).to(getDevice());
+        loss.index_put_({kept}, this->buffer->report(kept_loss, indices.index({kept})).to(torch::kCPU));
+      }
+      save_tensor<float>(loss.contiguous(), response);
+      break;
+    }
+    case MessageType::SIZE:
+      save_value<int>(this->buffer->size(), response);
+      break;
+    default:
+      throw std::runtime_error("Unknown replay server request.");
+    }
+  } catch (const std::exception &error) {
+    // Append requests are not answered, so their errors are only logged.
+    if (message.type == MessageType::APPEND) {
+      logging.warning("Replay server could not append experiences: " + std::string(error.what()));
+      return;
+    }
+    appendMessage(connection.outgoing, MessageType::FAILURE, error.what());
+    return;
+  }
+  appendMessage(connection.outgoing, message.type, response.str());
+}
+}  // namespace relab::agents::memory::impl
@@ -0,0 +1,232 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "agents/memory/sharded_replay_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "helpers/trace.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::agents::memory::impl {
+
+/**
+ * Implementation of the ShardedReplayBuffer methods.
+ */
+
+ShardedReplayBuffer::ShardedReplayBuffer(
+    int n_shards, int capacity, int batch_size, int frame_skip, int stack_size, int screen_size, CompressorType type,
+    std::map<std::string, float> args, const std::vector<int> &cpu_affinity
+) : batch_size(batch_size), indices(n_shards) {
+  // Check the number of shards and the type of prioritization.
+  if (n_shards <= 0) {
+    throw std::runtime_error("A sharded replay buffer must have at least one shard.");
+  }
+  if (args.find("prioritization") != args.end() && args["prioritization"] != 0) {
+    throw std::runtime_error("A sharded replay buffer only supports proportional prioritization.");
+  }
+
+  // Keep in mind whether the replay buffer is prioritized.
+  this->prioritized = false;
+  for (auto key : {"initial_priority", "omega", "omega_is", "n_children", "prioritization"}) {
+    if (args.find(key) != args.end()) {
+      this->prioritized = true;
+      break;
+    }
+  }
+  this->omega_is = (args.find("omega_is") != args.end()) ? args["omega_is"] : 1.0;
+
+  // Create the shards, each storing an even part of the capacity, and decoding its frames with the thread pool shared
+  // by all the shards rather than a pool of its own.
+  args["shared_pool"] = 1;
+  int shard_capacity = (capacity + n_shards - 1) / n_shards;
+  int shard_batch_size = std::max(batch_size / n_shards, 1);
+  for (int i = 0; i < n_shards; i++) {
+    this->shards.push_back(std::make_unique<ReplayBuffer>(
+        shard_capacity, shard_batch_size, frame_skip, stack_size, screen_size, type, args, cpu_affinity
+    ));
+    this->shard_mutexes.emplace_back();
+  }
+  this->pool = std::make_unique<ThreadPool>(n_shards, false, cpu_affinity);
+}
+
+void ShardedReplayBuffer::append(const Experience &experience, int actor) {
+  // Interleaving the experiences of two actors in a shard would corrupt the stored episodes.
+  if (actor < 0 || actor >= this->nShards()) {
+    throw std::runtime_error(
+        "The actor " + std::to_string(actor) + " has no shard among the " + std::to_string(this->nShards()) + "."
+    );
+  }
+  std::lock_guard<std::mutex> lock(this->shard_mutexes[actor]);
+  this->shards[actor]->append(experience);
+}
+
+int ShardedReplayBuffer::drain(SharedExperienceQueue &queue, int max_experiences) {
+  RELAB_TRACE("ShardedReplayBuffer::drain");
+
+  // Append the experiences in the order they were pushed, each to the shard of its actor.
+  int n_experiences = 0;
+  int actor = 0;
+  while (max_experiences < 0 || n_experiences < max_experiences) {
+    auto experience = queue.pop(actor);
+    if (experience.has_value() == false) {
+      break;
+    }
+    this->append(experience.value(), actor);
+    n_experiences += 1;
+  }
+  return n_experiences;
+}
+
+Batch ShardedReplayBuffer::sample() {
+  RELAB_TRACE("ShardedReplayBuffer::sample");
+
+  // Pick the shard of each experience with a probability proportional to the shard's total priority (or size).
+  int n_shards = this->nShards();
+  torch::Tensor masses = torch::zeros({n_shards}, torch::kFloat64);
+  for (int i = 0; i < n_shards; i++) {
+    std::lock_guard<std::mutex> lock(this->shard_mutexes[i]);
+    auto &shard = this->shards[i];
+    masses[i] = (this->prioritized == true) ? shard->getPriorities()->sum() : static_cast<double>(shard->size());
+  }
+  if (masses.sum().item<double>() <= 0) {
+    throw std::runtime_error("Cannot sample from an empty sharded replay buffer.");
+  }
+  torch::Tensor counts = torch::bincount(torch::multinomial(masses, this->batch_size, true), {}, n_shards);
+
+  // Sample the experiences of each shard, all shards working in parallel.
+  std::vector<Batch> batches(n_shards);
+  std::vector<torch::Tensor> indices(n_shards);
+  this->pool->parallelFor(
+      n_shards,
+      [this, &counts, &batches, &indices](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+          int n = counts[i].item<int>();
+          if (n == 0) {
+            continue;
+          }
+          std::lock_guard<std::mutex> lock(this->shard_mutexes[i]);
+          auto &shard = this->shards[i];
+          if (this->prioritized == true) {
+            indices[i] = shard->getPriorities()->sampleIndices(n);
+          } else {
+            indices[i] = torch::randint(0, shard->size(), {n});
+          }
+          batches[i] = shard->getExperiences(indices[i]);
+        }
+      },
+      1
+  );
+
+  // Keep track of the indices of the batch, whose loss is reported next.
+  {
+    std::lock_guard<std::mutex> lock(this->indices_mutex);
+    this->indices = indices;
+  }
+
+  // Concatenate the experiences of all shards.
+  std::vector<torch::Tensor> obs, actions, rewards, dones, next_obs;
+  for (int i = 0; i < n_shards; i++) {
+    if (indices[i].defined() == false) {
+      continue;
+    }
+    obs.push_back(std::get<0>(batches[i]));
+    actions.push_back(std::get<1>(batches[i]));
+    rewards.push_back(std::get<2>(batches[i]));
+    dones.push_back(std::get<3>(batches[i]));
+    next_obs.push_back(std::get<4>(batches[i]));
+  }
+  return std::make_tuple(
+      torch::cat(obs), torch::cat(actions), torch::cat(rewards), torch::cat(dones), torch::cat(next_obs)
+  );
+}
+
+torch::Tensor ShardedReplayBuffer::report(torch::Tensor &loss) {
+  RELAB_TRACE("ShardedReplayBuffer::report");
+
+  // If the buffer is not prioritized, don't update the priorities.
+  if (this->prioritized == false) {
+    return loss;
+  }
+
+  // Retrieve the indices of the last batch, which a concurrent call to sample may replace.
+  std::vector<torch::Tensor> indices;
+  {
+    std::lock_guard<std::mutex> lock(this->indices_mutex);
+    indices = this->indices;
+  }
+
+  // Find the smallest priority of each shard and of the whole buffer, as well as the position of each shard's
+  // experiences in the batch.
+  int n_shards = this->nShards();
+  std::vector<float> min_priorities(n_shards);
+  std::vector<int> offsets(n_shards, 0);
+  float min_priority = std::numeric_limits<float>::infinity();
+  int offset = 0;
+  for (int i = 0; i < n_shards; i++) {
+    std::lock_guard<std::mutex> lock(this->shard_mutexes[i]);
+    min_priorities[i] = this->shards[i]->getPriorities()->min();
+    min_priority = std::min(min_priority, min_priorities[i]);
+    offsets[i] = offset;
+    offset += (indices[i].defined() == true) ? indices[i].numel() : 0;
+  }
+
+  // Each shard normalizes the weights by its own largest weight (the one of its smallest priority), so the weights
+  // are rescaled by (min_priorities[i] / min_priority)^-omega_is to be normalized by the largest weight of all shards.
+  std::vector<torch::Tensor> new_losses(n_shards);
+  this->pool->parallelFor(
+      n_shards,
+      [this, &loss, &indices, &min_priorities, min_priority, &offsets, &new_losses](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+          if (indices[i].defined() == false) {
+            continue;
+          }
+          torch::Tensor shard_loss = loss.narrow(0, offsets[i], indices[i].numel()).clone();
+          bool rescale = (min_priorities[i] > 0 && min_priority > 0);
+          float scale = (rescale == true) ? std::pow(min_priorities[i] / min_priority, -this->omega_is) : 1;
+          std::lock_guard<std::mutex> lock(this->shard_mutexes[i]);
+          new_losses[i] = this->shards[i]->report(shard_loss, indices[i]) * scale;
+        }
+      },
+      1
+  );
+
+  // Concatenate the new losses of all shards.
+  std::vector<torch::Tensor> results;
+  for (auto &new_loss : new_losses) {
+    if (new_loss.defined() == true) {
+      results.push_back(new_loss);
+    }
+  }
+  return torch::cat(results);
+}
+
+int ShardedReplayBuffer::size() {
+  int size = 0;
+  for (int i = 0; i < this->nShards(); i++) {
+    std::lock_guard<std::mutex> lock(this->shard_mutexes[i]);
+    size += this->shards[i]->size();
+  }
+  return size;
+}
+
+void ShardedReplayBuffer::clear() {
+  for (int i = 0; i < this->nShards(); i++) {
+    std::lock_guard<std::mutex> lock(this->shard_mutexes[i]);
+    this->shards[i]->clear();
+  }
+  std::lock_guard<std::mutex> lock(this->indices_mutex);
+  this->indices.assign(this->nShards(), torch::Tensor());
+}
+
+std::unique_ptr<ReplayBuffer> &ShardedReplayBuffer::getShard(int index) { return this->shards[index]; }
+
+int ShardedReplayBuffer::nShards() { return static_cast<int>(this->shards.size()); }
+}  // namespace relab::agents::memory::impl
@@ -0,0 +1,198 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "agents/memory/shared_experience_queue.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace relab::agents::memory::impl {
+
+/**
+ * Implementation of the SharedExperienceQueue methods.
+ */
+
+// The constant identifying initialized segments.
+constexpr uint64_t QUEUE_MAGIC = 0x52454c4142515545;
+
+// The atomics are shared by several processes, so they must not rely on process-local locks.
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory queues require lock-free 64-bit atomics.");
+
+SharedExperienceQueue::SharedExperienceQueue(
+    const std::string &name, int capacity, int stack_size, int screen_size, bool create
+) : name(name), owner(create) {
+  // Create or open the shared memory segment.
+  if (create == true) {
+    shm_unlink(name.c_str());
+  }
+  int fd = shm_open(name.c_str(), (create == true) ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+  if (fd == -1) {
+    throw std::runtime_error("Could not open the shared memory segment: " + name + ".");
+  }
+
+  // Compute the size of the segment when creating it, or read it otherwise.
+  int slot_size = (sizeof(SlotHeader) + 2 * stack_size * screen_size * screen_size * sizeof(float) + 63) / 64 * 64;
+  if (create == true) {
+    this->n_bytes = sizeof(QueueHeader) + static_cast<size_t>(capacity) * slot_size;
+    if (ftruncate(fd, this->n_bytes) == -1) {
+      close(fd);
+      throw std::runtime_error("Could not resize the shared memory segment: " + name + ".");
+    }
+  } else {
+    struct stat status;
+    if (fstat(fd, &status) == -1) {
+      close(fd);
+      throw std::runtime_error("Could not read the size of the shared memory segment: " + name + ".");
+    }
+    this->n_bytes = status.st_size;
+    if (this->n_bytes < sizeof(QueueHeader)) {
+      close(fd);
+      throw std::runtime_error("The shared memory segment is not an initialized experience queue: " + name + ".");
+    }
+  }
+
+  // Map the segment in the address space of the process.
+  void *memory = mmap(nullptr, this->n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("Could not map the shared memory segment: " + name + ".");
+  }
+  this->header = static_cast<QueueHeader *>(memory);
+  this->slots = static_cast<char *>(memory) + sizeof(QueueHeader);
+
+  // Initialize the header and the slot sequences when creating the segment, publishing them with the magic constant.
+  if (create == true) {
+    this->header->capacity = capacity;
+    this->header->stack_size = stack_size;
+    this->header->screen_size = screen_size;
+    this->header->slot_size = slot_size;
+    this->header->enqueue_position.store(0, std::memory_order_relaxed);
+    this->header->dequeue_position.store(0, std::memory_order_relaxed);
+    for (auto i = 0; i < capacity; i++) {
+      this->slot(i)->sequence.store(i, std::memory_order_relaxed);
+    }
+    this->header->magic.store(QUEUE_MAGIC, std::memory_order_release);
+  } else if (this->header->magic.load(std::memory_order_acquire) != QUEUE_MAGIC) {
+    munmap(memory, this->n_bytes);
+    throw std::runtime_error("The shared memory segment is not an initialized experience queue: " + name + ".");
+  }
+  this->frame_size = this->header->screen_size * this->header->screen_size;
+  this->obs_size = this->header->stack_size * this->frame_size;
+
+  // Check that the slots described by the header fit in the segment, which may have been truncated by another process.
+  size_t min_slot_size = sizeof(SlotHeader) + 2 * static_cast<size_t>(this->obs_size) * sizeof(float);
+  size_t slots_size = static_cast<size_t>(this->header->capacity) * this->header->slot_size;
+  if (this->header->capacity <= 0 || this->header->slot_size < 0 ||
+      static_cast<size_t>(this->header->slot_size) < min_slot_size ||
+      this->n_bytes < sizeof(QueueHeader) + slots_size) {
+    munmap(memory, this->n_bytes);
+    throw std::runtime_error("The shared memory segment is too small for its experience queue: " + name + ".");
+  }
+}
+
+SharedExperienceQueue::~SharedExperienceQueue() {
+  munmap(this->header, this->n_bytes);
+  if (this->owner == true) {
+    shm_unlink(this->name.c_str());
+  }
+}
+
+bool SharedExperienceQueue::push(const Experience &experience, int actor) {
+  // Check that the observations fit in a slot, the observation at time t + 1 containing between one frame and a full
+  // stack of frames.
+  torch::Tensor obs = experience.obs.to(torch::kCPU, torch::kFloat32).contiguous();
+  torch::Tensor next_obs = experience.next_obs.to(torch::kCPU, torch::kFloat32).contiguous();
+  int n_next_frames = static_cast<int>(next_obs.numel() / this->frame_size);
+  if (obs.numel() != this->obs_size || next_obs.numel() % this->frame_size != 0 || n_next_frames < 1 ||
+      n_next_frames > this->header->stack_size) {
+    throw std::runtime_error("The observations do not match the frame shape of the shared experience queue.");
+  }
+
+  // Claim the slot at the enqueue position, unless the queue is full.
+  uint64_t position = this->header->enqueue_position.load(std::memory_order_relaxed);
+  SlotHeader *slot = nullptr;
+  while (true) {
+    slot = this->slot(position);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+    if (difference == 0) {
+      if (this->header->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      return false;
+    } else {
+      position = this->header->enqueue_position.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Write the experience, and make the slot readable.
+  slot->actor = actor;
+  slot->action = experience.action;
+  slot->reward = experience.reward;
+  slot->done = experience.done;
+  slot->n_next_frames = n_next_frames;
+  float *frames = reinterpret_cast<float *>(slot + 1);
+  std::memcpy(frames, obs.data_ptr<float>(), this->obs_size * sizeof(float));
+  std::memcpy(frames + this->obs_size, next_obs.data_ptr<float>(), n_next_frames * this->frame_size * sizeof(float));
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+std::optional<Experience> SharedExperienceQueue::pop() {
+  int actor = 0;
+  return this->pop(actor);
+}
+
+std::optional<Experience> SharedExperienceQueue::pop(int &actor) {
+  // Claim the slot at the dequeue position, unless the queue is empty.
+  uint64_t position = this->header->dequeue_position.load(std::memory_order_relaxed);
+  SlotHeader *slot = nullptr;
+  while (true) {
+    slot = this->slot(position);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position + 1);
+    if (difference == 0) {
+      if (this->header->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      return std::nullopt;
+    } else {
+      position = this->header->dequeue_position.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Read the experience, and make the slot writable for the next round.
+  int stack_size = this->header->stack_size;
+  int screen_size = this->header->screen_size;
+  int n_next_frames = slot->n_next_frames;
+  torch::Tensor obs = torch::empty({stack_size, screen_size, screen_size});
+  torch::Tensor next_obs = torch::empty({n_next_frames, screen_size, screen_size});
+  const float *frames = reinterpret_cast<const float *>(slot + 1);
+  std::memcpy(obs.data_ptr<float>(), frames, this->obs_size * sizeof(float));
+  std::memcpy(next_obs.data_ptr<float>(), frames + this->obs_size, n_next_frames * this->frame_size * sizeof(float));
+  Experience experience(obs, slot->action, slot->reward, slot->done != 0, next_obs);
+  actor = slot->actor;
+  slot->sequence.store(position + this->header->capacity, std::memory_order_release);
+  return experience;
+}
+
+int SharedExperienceQueue::size() {
+  uint64_t enqueue_position = this->header->enqueue_position.load(std::memory_order_relaxed);
+  uint64_t dequeue_position = this->header->dequeue_position.load(std::memory_order_relaxed);
+  return (enqueue_position > dequeue_position) ? static_cast<int>(enqueue_position - dequeue_position) : 0;
+}
+
+int SharedExperienceQueue::capacity() { return this->header->capacity; }
+
+SlotHeader *SharedExperienceQueue::slot(uint64_t position) {
+  uint64_t index = position % static_cast<uint64_t>(this->header->capacity);
+  return reinterpret_cast<SlotHeader *>(this->slots + index * this->header->slot_size);
+}
+}  // namespace relab::agents::memory::impl
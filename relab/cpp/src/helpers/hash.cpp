@@ -0,0 +1,86 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "helpers/hash.hpp"
+
+#include <cstring>
+
+namespace relab::helpers {
+
+// The prime numbers used by xxHash64.
+static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotate_left(uint64_t value, int n) { return (value << n) | (value >> (64 - n)); }
+
+static inline uint64_t read_word(const unsigned char *ptr) {
+  uint64_t word;
+  std::memcpy(&word, ptr, sizeof(word));
+  return word;
+}
+
+static inline uint64_t accumulate(uint64_t accumulator, uint64_t word) {
+  accumulator += word * PRIME_2;
+  return rotate_left(accumulator, 31) * PRIME_1;
+}
+
+static inline uint64_t merge_round(uint64_t accumulator, uint64_t value) {
+  accumulator ^= accumulate(0, value);
+  return accumulator * PRIME_1 + PRIME_4;
+}
+
+uint64_t hash_bytes(const void *data, size_t size, uint64_t seed) {
+  const unsigned char *ptr = static_cast<const unsigned char *>(data);
+  const unsigned char *end = ptr + size;
+  uint64_t hash = 0;
+
+  // Process the buffer by blocks of 32 bytes, using four independent accumulators.
+  if (size >= 32) {
+    uint64_t v1 = seed + PRIME_1 + PRIME_2;
+    uint64_t v2 = seed + PRIME_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME_1;
+    for (; ptr + 32 <= end; ptr += 32) {
+      v1 = accumulate(v1, read_word(ptr));
+      v2 = accumulate(v2, read_word(ptr + 8));
+      v3 = accumulate(v3, read_word(ptr + 16));
+      v4 = accumulate(v4, read_word(ptr + 24));
+    }
+    hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+    hash = merge_round(hash, v1);
+    hash = merge_round(hash, v2);
+    hash = merge_round(hash, v3);
+    hash = merge_round(hash, v4);
+  } else {
+    hash = seed + PRIME_5;
+  }
+  hash += static_cast<uint64_t>(size);
+
+  // Process the remaining bytes.
+  for (; ptr + 8 <= end; ptr += 8) {
+    hash ^= accumulate(0, read_word(ptr));
+    hash = rotate_left(hash, 27) * PRIME_1 + PRIME_4;
+  }
+  if (ptr + 4 <= end) {
+    uint32_t word;
+    std::memcpy(&word, ptr, sizeof(word));
+    hash ^= static_cast<uint64_t>(word) * PRIME_1;
+    hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+    ptr += 4;
+  }
+  for (; ptr < end; ++ptr) {
+    hash ^= (*ptr) * PRIME_5;
+    hash = rotate_left(hash, 11) * PRIME_1;
+  }
+
+  // Mix the bits of the hash.
+  hash ^= hash >> 33;
+  hash *= PRIME_2;
+  hash ^= hash >> 29;
+  hash *= PRIME_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+}  // namespace relab::helpers
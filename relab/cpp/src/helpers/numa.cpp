@@ -0,0 +1,187 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "helpers/numa.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <experimental/filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::experimental::filesystem;
+
+namespace relab::helpers {
+
+// The flags and modes of the kernel memory policy system calls, see <linux/mempolicy.h>.
+constexpr int MPOL_DEFAULT_MODE = 0;
+constexpr int MPOL_PREFERRED_MODE = 1;
+constexpr unsigned long MPOL_FLAG_NODE = 1;  // NOLINT
+constexpr unsigned long MPOL_FLAG_ADDR = 2;  // NOLINT
+
+// The largest number of nodes whose placement policy can be saved, i.e., the default maximum of the kernel.
+constexpr int MAX_NODES = 1024;
+
+NumaTopology::NumaTopology(const std::string &sysfs_path) {
+  // Read the CPUs of each node, sorted by node number.
+  std::map<int, std::vector<int>> nodes;
+  std::error_code error;
+  if (is_directory(sysfs_path, error)) {
+    for (auto &entry : directory_iterator(sysfs_path)) {
+      std::string name = entry.path().filename().string();
+      if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        continue;
+      }
+      std::ifstream file(entry.path() / "cpulist");
+      std::string list;
+      std::getline(file, list);
+      auto cpus = parseCpuList(list);
+      if (cpus.empty() == false) {
+        nodes[std::stoi(name.substr(4))] = cpus;
+      }
+    }
+  }
+  for (auto &[id, cpus] : nodes) {
+    this->node_ids.push_back(id);
+    this->node_cpus.push_back(cpus);
+  }
+
+  // Fall back to a single node containing all CPUs.
+  if (this->node_ids.empty()) {
+    int n_cpus = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    std::vector<int> cpus(n_cpus);
+    for (int i = 0; i < n_cpus; i++) {
+      cpus[i] = i;
+    }
+    this->node_ids.push_back(0);
+    this->node_cpus.push_back(cpus);
+  }
+}
+
+NumaTopology &NumaTopology::global() {
+  static NumaTopology topology;
+  return topology;
+}
+
+int NumaTopology::nNodes() const { return static_cast<int>(this->node_ids.size()); }
+
+const std::vector<int> &NumaTopology::cpus(int node) const { return this->node_cpus[node]; }
+
+int NumaTopology::nodeOfCpu(int cpu) const {
+  for (int node = 0; node < this->nNodes(); node++) {
+    auto &cpus = this->node_cpus[node];
+    if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+      return node;
+    }
+  }
+  return -1;
+}
+
+int NumaTopology::nodeOfAddress(const void *address) const {
+  // On a single node, all the memory is on this node.
+  if (this->nNodes() == 1) {
+    return 0;
+  }
+
+  // Ask the kernel for the node of the page containing the address.
+  int node_id = -1;
+  if (syscall(SYS_get_mempolicy, &node_id, nullptr, 0, address, MPOL_FLAG_NODE | MPOL_FLAG_ADDR) != 0) {
+    return -1;
+  }
+  auto it = std::find(this->node_ids.begin(), this->node_ids.end(), node_id);
+  return (it == this->node_ids.end()) ? -1 : static_cast<int>(it - this->node_ids.begin());
+}
+
+bool NumaTopology::pinCurrentThread(int node) const {
+  if (this->nNodes() == 1 || node < 0 || node >= this->nNodes()) {
+    return false;
+  }
+  return pinCurrentThreadToCpus(this->node_cpus[node]);
+}
+
+bool NumaTopology::pinCurrentThreadToCpus(const std::vector<int> &cpus) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  if (CPU_COUNT(&cpu_set) == 0) {
+    return false;
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+bool NumaTopology::preferNode(int node) const {
+  if (this->nNodes() == 1 || node >= this->nNodes()) {
+    return false;
+  }
+  if (node < 0) {
+    return syscall(SYS_set_mempolicy, MPOL_DEFAULT_MODE, nullptr, 0) == 0;
+  }
+
+  // The kernel reads one bit less than the number of bits passed, hence the additional bit.
+  int node_id = this->node_ids[node];
+  int bits_per_word = 8 * sizeof(unsigned long);                   // NOLINT
+  std::vector<unsigned long> mask(node_id / bits_per_word + 1, 0);  // NOLINT
+  mask[node_id / bits_per_word] |= 1UL << (node_id % bits_per_word);
+  return syscall(SYS_set_mempolicy, MPOL_PREFERRED_MODE, mask.data(), mask.size() * bits_per_word + 1) == 0;
+}
+
+std::vector<int> NumaTopology::parseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.find_first_of("0123456789") == std::string::npos) {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+/**
+ * Implementation of the NodePreference methods.
+ */
+
+NodePreference::NodePreference(const NumaTopology &topology, int node) :
+    mode(MPOL_DEFAULT_MODE), mask(MAX_NODES / (8 * sizeof(unsigned long)), 0), changed(false) {  // NOLINT
+  // On a single node, the placement policy is never changed.
+  if (topology.nNodes() == 1) {
+    return;
+  }
+
+  // Save the placement policy of the thread, falling back to the default policy if it cannot be read.
+  if (syscall(SYS_get_mempolicy, &this->mode, this->mask.data(), MAX_NODES, nullptr, 0) != 0) {
+    this->mode = MPOL_DEFAULT_MODE;
+  }
+  this->changed = topology.preferNode(node);
+}
+
+NodePreference::~NodePreference() {
+  if (this->changed == false) {
+    return;
+  }
+  if (this->mode == MPOL_DEFAULT_MODE) {
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT_MODE, nullptr, 0);
+    return;
+  }
+
+  // The kernel reads one bit less than the number of bits passed, hence the additional bit.
+  syscall(SYS_set_mempolicy, this->mode, this->mask.data(), MAX_NODES + 1);
+}
+}  // namespace relab::helpers
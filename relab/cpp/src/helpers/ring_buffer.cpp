@@ -0,0 +1,162 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "helpers/ring_buffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "helpers/debug.hpp"
+#include "helpers/serialize.hpp"
+
+namespace relab::helpers {
+
+template <class T>
+RingBuffer<T>::RingBuffer(int capacity) :
+    elements(new T[std::max(capacity, 1)]()), capacity(std::max(capacity, 0)), head(0), length(0) {}
+
+template <class T>
+RingBuffer<T>::RingBuffer(const RingBuffer &other) :
+    elements(new T[std::max(other.capacity, 1)]()), capacity(other.capacity), head(other.head), length(other.length) {
+  std::copy(other.elements.get(), other.elements.get() + other.capacity, this->elements.get());
+}
+
+template <class T> RingBuffer<T> &RingBuffer<T>::operator=(const RingBuffer &other) {
+  if (this != &other) {
+    if (this->capacity != other.capacity) {
+      this->elements.reset(new T[std::max(other.capacity, 1)]());
+      this->capacity = other.capacity;
+    }
+    std::copy(other.elements.get(), other.elements.get() + other.capacity, this->elements.get());
+    this->head = other.head;
+    this->length = other.length;
+  }
+  return *this;
+}
+
+template <class T> void RingBuffer<T>::push_back(T element) {
+  if (this->capacity == 0) {
+    return;
+  }
+  if (this->length == this->capacity) {
+    this->pop_front();
+  }
+  this->elements[this->position(this->length)] = std::move(element);
+  ++this->length;
+}
+
+template <class T> void RingBuffer<T>::push_front(T element) {
+  if (this->capacity == 0) {
+    return;
+  }
+  if (this->length == this->capacity) {
+    this->pop_back();
+  }
+  this->head = (this->head == 0) ? this->capacity - 1 : this->head - 1;
+  this->elements[this->head] = std::move(element);
+  ++this->length;
+}
+
+template <class T> void RingBuffer<T>::pop_back() { --this->length; }
+
+template <class T> void RingBuffer<T>::pop_front() {
+  this->head = (this->head + 1 == this->capacity) ? 0 : this->head + 1;
+  --this->length;
+}
+
+template <class T> T &RingBuffer<T>::front() { return this->elements[this->head]; }
+
+template <class T> T &RingBuffer<T>::back() { return this->elements[this->position(this->length - 1)]; }
+
+template <class T> T &RingBuffer<T>::operator[](size_t index) {
+  return this->elements[this->position(static_cast<int>(index))];
+}
+
+template <class T> const T &RingBuffer<T>::operator[](size_t index) const {
+  return this->elements[this->position(static_cast<int>(index))];
+}
+
+template <class T> T RingBuffer<T>::get(int index) { return (*this)[index]; }
+
+template <class T> size_t RingBuffer<T>::size() const { return static_cast<size_t>(this->length); }
+
+template <class T> void RingBuffer<T>::clear() {
+  this->head = 0;
+  this->length = 0;
+}
+
+template <class T> int RingBuffer<T>::position(int index) const {
+  int position = this->head + index;
+  return (position >= this->capacity) ? position - this->capacity : position;
+}
+
+template <class T> void RingBuffer<T>::load(std::istream &checkpoint) {
+  // Load the queue from the checkpoint, which only allocates memory if the capacity changed.
+  int capacity = load_value<int>(checkpoint);
+  if (capacity != this->capacity) {
+    *this = RingBuffer<T>(capacity);
+  }
+  this->clear();
+  int size = load_value<int>(checkpoint);
+  for (auto i = 0; i < size; i++) {
+    this->push_back(load_value<T>(checkpoint));
+  }
+}
+
+template <class T> void RingBuffer<T>::save(std::ostream &checkpoint) {
+  // Save the queue in the checkpoint.
+  save_value(this->capacity, checkpoint);
+  save_value(this->length, checkpoint);
+  for (int i = 0; i < this->length; i++) {
+    save_value((*this)[i], checkpoint);
+  }
+}
+
+template <class T> void RingBuffer<T>::print() {
+  std::cout << "RingBuffer(capacity: " << this->capacity << ", values: [";
+  for (int i = 0; i < this->length; i++) {
+    if (i != 0) {
+      std::cout << " ";
+    }
+    std::cout << (*this)[i];
+  }
+  std::cout << "])" << std::endl;
+}
+
+// @cond IGNORED_BY_DOXYGEN
+template <> void RingBuffer<bool>::print() {
+  std::cout << "RingBuffer(capacity: " << this->capacity << ", values: [";
+  for (int i = 0; i < this->length; i++) {
+    if (i != 0) {
+      std::cout << " ";
+    }
+    print_bool((*this)[i]);
+  }
+  std::cout << "])" << std::endl;
+}
+// @endcond
+
+template <class Type> bool operator==(const RingBuffer<Type> &lhs, const RingBuffer<Type> &rhs) {
+  if (lhs.capacity != rhs.capacity || lhs.length != rhs.length) {
+    return false;
+  }
+  for (int i = 0; i < lhs.length; i++) {
+    if (lhs[i] != rhs[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Type> bool operator!=(const RingBuffer<Type> &lhs, const RingBuffer<Type> &rhs) {
+  return !(lhs == rhs);
+}
+
+// Explicit instantiation of double ended queue.
+template bool operator==(const RingBuffer<int> &lhs, const RingBuffer<int> &rhs);
+template bool operator==(const RingBuffer<float> &lhs, const RingBuffer<float> &rhs);
+template bool operator==(const RingBuffer<bool> &lhs, const RingBuffer<bool> &rhs);
+template bool operator!=(const RingBuffer<int> &lhs, const RingBuffer<int> &rhs);
+template bool operator!=(const RingBuffer<float> &lhs, const RingBuffer<float> &rhs);
+template bool operator!=(const RingBuffer<bool> &lhs, const RingBuffer<bool> &rhs);
+}  // namespace relab::helpers
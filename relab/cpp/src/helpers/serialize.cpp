@@ -2,10 +2,39 @@
 
 #include "helpers/serialize.hpp"
 
+#include <zlib.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 namespace relab::helpers {
 
+int load_checkpoint_version(std::istream &checkpoint) {
+  // Checkpoints written before the format was versioned start with a boolean, which never matches the magic number.
+  auto position = checkpoint.tellg();
+  int32_t magic = load_value<int32_t>(checkpoint);
+  if (!checkpoint || magic != CHECKPOINT_MAGIC) {
+    checkpoint.clear();
+    checkpoint.seekg(position);
+    return 0;
+  }
+
+  // Check that the format version is supported.
+  int version = load_value<int>(checkpoint);
+  if (version < 1 || version > CHECKPOINT_VERSION) {
+    throw std::runtime_error("The checkpoint format version " + std::to_string(version) + " is not supported.");
+  }
+  return version;
+}
+
+void save_checkpoint_version(std::ostream &checkpoint) {
+  save_value(CHECKPOINT_MAGIC, checkpoint);
+  save_value(CHECKPOINT_VERSION, checkpoint);
+}
+
 template <class T> std::vector<T> load_vector(std::istream &checkpoint) {
   // Create the variables required for loading the vector.
   int capacity = load_value<int>(checkpoint);
@@ -114,20 +143,154 @@ template <class T> void save_tensor(const torch::Tensor &tensor, std::ostream &c
   checkpoint.write((char *)tensor_cpu.data_ptr(), sizeof(T) * tensor.numel());
 }
 
+std::vector<char> load_compressed_bytes(std::istream &checkpoint) {
+  // Load the sizes of the uncompressed and compressed buffers.
+  int64_t size = load_value<int64_t>(checkpoint);
+  int64_t compressed_size = load_value<int64_t>(checkpoint);
+
+  // Load the compressed bytes.
+  std::vector<char> compressed(compressed_size);
+  checkpoint.read(compressed.data(), compressed_size);
+
+  // Decompress the bytes.
+  std::vector<char> data(size);
+  uLongf data_size = static_cast<uLongf>(size);
+  int status = uncompress((Bytef *)data.data(), &data_size, (const Bytef *)compressed.data(), compressed_size);
+  if (status != Z_OK || static_cast<int64_t>(data_size) != size) {
+    throw std::runtime_error("The compressed section of the checkpoint is corrupted.");
+  }
+  return data;
+}
+
+void save_compressed_bytes(const char *data, int64_t size, std::ostream &checkpoint) {
+  // Compress the bytes.
+  uLongf compressed_size = compressBound(static_cast<uLong>(size));
+  std::vector<char> compressed(compressed_size);
+  int status =
+      compress2((Bytef *)compressed.data(), &compressed_size, (const Bytef *)data, size, Z_DEFAULT_COMPRESSION);
+  if (status != Z_OK) {
+    throw std::runtime_error("A section of the checkpoint could not be compressed.");
+  }
+
+  // Save the sizes of the uncompressed and compressed buffers, followed by the compressed bytes.
+  save_value<int64_t>(size, checkpoint);
+  save_value<int64_t>(static_cast<int64_t>(compressed_size), checkpoint);
+  checkpoint.write(compressed.data(), compressed_size);
+}
+
+template <class T> std::vector<T> load_compressed_vector(std::istream &checkpoint, bool delta) {
+  // Create the variables required for loading the vector.
+  int capacity = load_value<int>(checkpoint);
+  std::vector<T> vector;
+  vector.reserve(capacity);
+
+  // Load and decompress the vector.
+  std::vector<char> data = load_compressed_bytes(checkpoint);
+  T *ptr = reinterpret_cast<T *>(data.data());
+  vector.assign(ptr, ptr + data.size() / sizeof(T));
+
+  // Undo the delta encoding, if needed.
+  if constexpr (std::is_integral_v<T>) {
+    if (delta == true) {
+      for (size_t i = 1; i < vector.size(); i++) {
+        vector[i] += vector[i - 1];
+      }
+    }
+  }
+  return vector;
+}
+
+template <class T> void save_compressed_vector(const std::vector<T> &vector, std::ostream &checkpoint, bool delta) {
+  // Save the vector's capacity.
+  int capacity = static_cast<int>(vector.capacity());
+  save_value(capacity, checkpoint);
+
+  // Delta encode the vector, if needed, so that slowly increasing sequences
+  // become runs of small values that compress well.
+  if constexpr (std::is_integral_v<T>) {
+    if (delta == true && vector.size() != 0) {
+      std::vector<T> deltas(vector.size());
+      deltas[0] = vector[0];
+      for (size_t i = 1; i < vector.size(); i++) {
+        deltas[i] = vector[i] - vector[i - 1];
+      }
+      save_compressed_bytes((const char *)deltas.data(), sizeof(T) * deltas.size(), checkpoint);
+      return;
+    }
+  }
+
+  // Compress and save the vector.
+  save_compressed_bytes((const char *)vector.data(), sizeof(T) * vector.size(), checkpoint);
+}
+
+template <class T> torch::Tensor load_compressed_tensor(std::istream &checkpoint) {
+  // Load a header describing the tensor's shape.
+  int n_dim = load_value<int>(checkpoint);
+  int64_t n_elements = 1;
+  std::vector<int64_t> shape;
+  for (auto i = 0; i < n_dim; i++) {
+    int64_t size = load_value<int64_t>(checkpoint);
+    n_elements *= size;
+    shape.push_back(size);
+  }
+
+  // Check if the tensor is empty.
+  if (n_elements == 0) {
+    return torch::Tensor();
+  }
+
+  // Load and decompress the tensor.
+  bool is_cuda = load_value<bool>(checkpoint);
+  std::vector<char> data = load_compressed_bytes(checkpoint);
+  auto options = torch::TensorOptions().dtype(torch::CppTypeToScalarType<T>());
+  torch::Tensor tensor = torch::zeros(at::IntArrayRef(shape), options);
+  std::memcpy(tensor.data_ptr(), data.data(), sizeof(T) * n_elements);
+  if (is_cuda == true) {
+    tensor = tensor.to(torch::Device(torch::kCUDA));
+  }
+  return tensor;
+}
+
+template <class T> void save_compressed_tensor(const torch::Tensor &tensor, std::ostream &checkpoint) {
+  // Save a header describing the tensor's shape.
+  int n_dim = tensor.dim();
+  save_value(n_dim, checkpoint);
+  for (auto i = 0; i < n_dim; i++) {
+    save_value<int64_t>(tensor.size(i), checkpoint);
+  }
+
+  // Check if the tensor is empty.
+  if (tensor.numel() == 0) {
+    return;
+  }
+
+  // Compress and save the tensor.
+  bool is_cuda = tensor.is_cuda();
+  save_value(is_cuda, checkpoint);
+  torch::Tensor tensor_cpu = (is_cuda) ? tensor.clone().cpu() : tensor.contiguous();
+  save_compressed_bytes((const char *)tensor_cpu.data_ptr(), sizeof(T) * tensor.numel(), checkpoint);
+}
+
 // Explicit instantiations.
+template std::vector<char> load_vector<char>(std::istream &checkpoint);
 template std::vector<int> load_vector<int>(std::istream &checkpoint);
 template std::vector<double> load_vector<double>(std::istream &checkpoint);
+template std::vector<float> load_vector<float>(std::istream &checkpoint);
+template void save_vector<char>(const std::vector<char> &vector, std::ostream &checkpoint);
 template void save_vector<int>(const std::vector<int> &vector, std::ostream &checkpoint);
 template void save_vector<double>(const std::vector<double> &vector, std::ostream &checkpoint);
+template void save_vector<float>(const std::vector<float> &vector, std::ostream &checkpoint);
 
 template std::vector<torch::Tensor> load_vector<torch::Tensor, float>(std::istream &checkpoint);
 template void save_vector<torch::Tensor, float>(const std::vector<torch::Tensor> &vector, std::ostream &checkpoint);
 
+template char load_value<char>(std::istream &checkpoint);
 template int load_value<int>(std::istream &checkpoint);
 template bool load_value<bool>(std::istream &checkpoint);
 template int64_t load_value<int64_t>(std::istream &checkpoint);
 template float load_value<float>(std::istream &checkpoint);
 template double load_value<double>(std::istream &checkpoint);
+template void save_value<char>(const char &value, std::ostream &checkpoint);
 template void save_value<int>(const int &value, std::ostream &checkpoint);
 template void save_value<bool>(const bool &value, std::ostream &checkpoint);
 template void save_value<int64_t>(const int64_t &value, std::ostream &checkpoint);
@@ -142,4 +305,14 @@ template void save_tensor<int>(const torch::Tensor &tensor, std::ostream &checkp
 template void save_tensor<int64_t>(const torch::Tensor &tensor, std::ostream &checkpoint);
 template void save_tensor<bool>(const torch::Tensor &tensor, std::ostream &checkpoint);
 template void save_tensor<float>(const torch::Tensor &tensor, std::ostream &checkpoint);
+
+template std::vector<int> load_compressed_vector<int>(std::istream &checkpoint, bool delta);
+template void save_compressed_vector<int>(const std::vector<int> &vector, std::ostream &checkpoint, bool delta);
+
+template torch::Tensor load_compressed_tensor<int>(std::istream &checkpoint);
+template torch::Tensor load_compressed_tensor<bool>(std::istream &checkpoint);
+template torch::Tensor load_compressed_tensor<float>(std::istream &checkpoint);
+template void save_compressed_tensor<int>(const torch::Tensor &tensor, std::ostream &checkpoint);
+template void save_compressed_tensor<bool>(const torch::Tensor &tensor, std::ostream &checkpoint);
+template void save_compressed_tensor<float>(const torch::Tensor &tensor, std::ostream &checkpoint);
 }  // namespace relab::helpers
@@ -0,0 +1,129 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "helpers/stats.hpp"
+
+#include <map>
+#include <string>
+
+using namespace std::chrono;
+
+namespace relab::helpers {
+
+/**
+ * Implementation of the Histogram methods.
+ */
+
+Histogram::Histogram() { this->clear(); }
+
+void Histogram::record(uint64_t nanoseconds) {
+  this->counts[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  this->n_values.fetch_add(1, std::memory_order_relaxed);
+  this->total.fetch_add(nanoseconds, std::memory_order_relaxed);
+  uint64_t maximum = this->maximum.load(std::memory_order_relaxed);
+  while (nanoseconds > maximum && !this->maximum.compare_exchange_weak(maximum, nanoseconds)) {
+  }
+}
+
+uint64_t Histogram::count() const { return this->n_values.load(std::memory_order_relaxed); }
+
+double Histogram::percentile(double percentage) const {
+  // Find the first bucket such that the requested percentage of values is in this bucket or the previous ones.
+  uint64_t n_values = this->count();
+  uint64_t rank = static_cast<uint64_t>(percentage / 100.0 * n_values);
+  uint64_t n_seen = 0;
+  for (int i = 0; i < N_BUCKETS; i++) {
+    n_seen += this->counts[i].load(std::memory_order_relaxed);
+    if (n_seen > rank || (n_seen == n_values && n_seen != 0)) {
+      return bucketValue(i);
+    }
+  }
+  return 0;
+}
+
+std::map<std::string, double> Histogram::summary() const {
+  uint64_t n_values = this->count();
+  double mean = (n_values == 0) ? 0 : static_cast<double>(this->total.load(std::memory_order_relaxed)) / n_values;
+  return {
+      {"count", static_cast<double>(n_values)},
+      {"mean_us", mean / 1000},
+      {"p50_us", this->percentile(50) / 1000},
+      {"p90_us", this->percentile(90) / 1000},
+      {"p99_us", this->percentile(99) / 1000},
+      {"max_us", this->maximum.load(std::memory_order_relaxed) / 1000.0},
+  };
+}
+
+void Histogram::clear() {
+  for (auto &count : this->counts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  this->n_values.store(0, std::memory_order_relaxed);
+  this->total.store(0, std::memory_order_relaxed);
+  this->maximum.store(0, std::memory_order_relaxed);
+}
+
+int Histogram::bucketIndex(uint64_t value) {
+  // Small values have a bucket of their own.
+  if (value < N_SUB_BUCKETS) {
+    return static_cast<int>(value);
+  }
+
+  // Otherwise, the exponent selects the power of two and the next bits select the sub-bucket.
+  int exponent = 63 - __builtin_clzll(value);
+  int sub_bucket = static_cast<int>(value >> (exponent - SUB_BUCKET_BITS)) & (N_SUB_BUCKETS - 1);
+  return (exponent - SUB_BUCKET_BITS + 1) * N_SUB_BUCKETS + sub_bucket;
+}
+
+double Histogram::bucketValue(int index) {
+  if (index < N_SUB_BUCKETS) {
+    return index;
+  }
+  int exponent = index / N_SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+  int sub_bucket = index % N_SUB_BUCKETS;
+  double width = static_cast<double>(uint64_t(1) << (exponent - SUB_BUCKET_BITS));
+  return (N_SUB_BUCKETS + sub_bucket) * width + width / 2;
+}
+
+/**
+ * Implementation of the Stats methods.
+ */
+
+Stats &Stats::global() {
+  static Stats stats;
+  return stats;
+}
+
+Histogram &Stats::operator[](Operation operation) { return this->histograms[static_cast<int>(operation)]; }
+
+std::string Stats::name(Operation operation) {
+  static const char *names[N_OPERATIONS] = {"append", "encode", "decode", "sample", "report", "save", "load"};
+  return names[static_cast<int>(operation)];
+}
+
+std::map<std::string, std::map<std::string, double>> Stats::summary() const {
+  std::map<std::string, std::map<std::string, double>> summaries;
+  for (int i = 0; i < N_OPERATIONS; i++) {
+    if (this->histograms[i].count() != 0) {
+      summaries[name(static_cast<Operation>(i))] = this->histograms[i].summary();
+    }
+  }
+  return summaries;
+}
+
+void Stats::clear() {
+  for (auto &histogram : this->histograms) {
+    histogram.clear();
+  }
+}
+
+/**
+ * Implementation of the ScopedLatency methods.
+ */
+
+ScopedLatency::ScopedLatency(Operation operation) : operation(operation), start_time(steady_clock::now()) {}
+
+ScopedLatency::~ScopedLatency() {
+  auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - this->start_time).count();
+  Stats::global()[this->operation].record(static_cast<uint64_t>(elapsed));
+}
+}  // namespace relab::helpers
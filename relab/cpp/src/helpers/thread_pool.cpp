@@ -2,48 +2,147 @@
 
 #include "helpers/thread_pool.hpp"
 
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
+
+#include "helpers/numa.hpp"
+#include "helpers/trace.hpp"
 
 using namespace std;
 
 namespace relab::helpers {
 
-ThreadPool::ThreadPool(size_t num_threads) {
+/**
+ * Implementation of the TaskGroup methods.
+ */
+
+void TaskGroup::add() {
+  lock_guard<mutex> lock(this->group_mutex);
+  ++this->n_pending;
+}
+
+void TaskGroup::done() {
+  lock_guard<mutex> lock(this->group_mutex);
+  if (--this->n_pending == 0) {
+    this->finished_cv.notify_all();
+  }
+}
+
+void TaskGroup::wait() {
+  RELAB_TRACE("TaskGroup::wait");
+
+  // Sleep until the workers report that the tasks of the group are complete.
+  unique_lock<mutex> lock(this->group_mutex);
+  this->finished_cv.wait(lock, [this] { return this->n_pending == 0; });
+}
+
+/**
+ * Implementation of the ThreadPool methods.
+ */
+
+ThreadPool::ThreadPool(size_t num_threads, bool numa_aware, const vector<int> &cpus) {
+  // Create one queue per NUMA node if the pool is NUMA-aware, and a single queue otherwise.
+  NumaTopology &topology = NumaTopology::global();
+  size_t n_nodes = static_cast<size_t>(topology.nNodes());
+  if (numa_aware == false || n_nodes == 1 || num_threads < n_nodes) {
+    n_nodes = 1;
+  }
+  this->tasks.resize(n_nodes);
+  for (size_t i = 0; i < n_nodes; ++i) {
+    this->cvs.emplace_back();
+  }
+
   // Creating worker threads.
   for (size_t i = 0; i < num_threads; ++i) {
-    this->threads.emplace_back([this] {
+    this->threads.emplace_back([this, i, n_nodes, &topology, cpus] {
+      // Give the worker its own track in the traces.
+      Tracer::global().setThreadName("ThreadPool worker " + std::to_string(i));
+
+      // Pin the worker to the CPUs of its node, and to a single allowed CPU if the CPUs were restricted. The allowed
+      // CPUs of the worker's node are preferred, and all the allowed CPUs are used if the node has none of them.
+      int node = static_cast<int>(i % n_nodes);
+      if (cpus.empty() == false) {
+        vector<int> node_cpus;
+        for (int cpu : cpus) {
+          if (n_nodes == 1 || topology.nodeOfCpu(cpu) == node) {
+            node_cpus.push_back(cpu);
+          }
+        }
+        auto &allowed = (node_cpus.empty() == true) ? cpus : node_cpus;
+        NumaTopology::pinCurrentThreadToCpus({allowed[(i / n_nodes) % allowed.size()]});
+      } else if (n_nodes != 1) {
+        topology.pinCurrentThread(node);
+      }
+      auto &queue = this->tasks[node];
+      auto &cv = this->cvs[node];
+
       function<void()> task;
+      TaskGroup *group = nullptr;
       while (true) {
         {
           // Locking the queue so that data can be shared safely.
           unique_lock<mutex> lock(this->queue_mutex);
 
           // Waiting until there is a task to execute or the pool is stopped.
-          this->cv.wait(lock, [this] { return !this->tasks.empty() || this->stop; });
+          cv.wait(lock, [this, &queue] { return !queue.empty() || this->stop; });
 
           // Exit the thread in case the pool is stopped and there are no tasks.
-          if (this->stop && this->tasks.empty()) {
+          if (this->stop && queue.empty()) {
             return;
           }
 
           // Get the next task from the queue.
-          task = move(this->tasks.front());
-          this->tasks.pop();
+          task = move(queue.front().first);
+          group = queue.front().second;
+          queue.pop();
         }
 
         // Execute the task.
-        task();
+        {
+          RELAB_TRACE("ThreadPool::task");
+          task();
+        }
 
-        // Keep track of the number of tasks executed.
+        // Keep track of the number of tasks executed, and wake up the threads waiting for their group or for all tasks
+        // to complete.
+        if (group != nullptr) {
+          group->done();
+        }
         {
           unique_lock<mutex> lock(this->counter_mutex);
-          ++this->tasks_finished;
+          if (++this->tasks_finished == this->tasks_pushed) {
+            this->finished_cv.notify_all();
+          }
         }
       }
     });
   }
 }
 
+shared_ptr<ThreadPool> ThreadPool::shared(size_t num_threads, bool numa_aware, const vector<int> &cpus) {
+  static mutex shared_mutex;
+  static weak_ptr<ThreadPool> shared_pool;
+  static tuple<size_t, bool, vector<int>> shared_parameters;
+
+  // Create the shared pool, unless one of its users is still alive.
+  lock_guard<mutex> lock(shared_mutex);
+  auto pool = shared_pool.lock();
+  auto parameters = make_tuple(num_threads, numa_aware, cpus);
+  if (!pool) {
+    pool = make_shared<ThreadPool>(num_threads, numa_aware, cpus);
+    shared_pool = pool;
+    shared_parameters = move(parameters);
+  } else if (parameters != shared_parameters) {
+    throw runtime_error("The shared thread pool is alive and was created with different parameters.");
+  }
+  return pool;
+}
+
 ThreadPool::~ThreadPool() {
   // Lock the queue to update the stop flag safely.
   {
@@ -52,7 +151,9 @@ ThreadPool::~ThreadPool() {
   }
 
   // Notify all threads.
-  this->cv.notify_all();
+  for (auto &cv : this->cvs) {
+    cv.notify_all();
+  }
 
   // Joining all worker threads to ensure they have completed their tasks.
   for (auto &thread : this->threads) {
@@ -60,23 +161,60 @@ ThreadPool::~ThreadPool() {
   }
 }
 
-void ThreadPool::push(const function<void()> &task) {
-  ++this->tasks_pushed;
+void ThreadPool::push(const function<void()> &task, int node) { this->pushTask(task, nullptr, node); }
+
+void ThreadPool::push(const function<void()> &task, TaskGroup &group, int node) {
+  group.add();
+  this->pushTask(task, &group, node);
+}
+
+void ThreadPool::pushTask(const function<void()> &task, TaskGroup *group, int node) {
+  {
+    unique_lock<mutex> lock(this->counter_mutex);
+    ++this->tasks_pushed;
+  }
+  size_t queue = 0;
   {
+    // Send the task to the queue of its node, or spread the tasks without a node over all queues.
     std::unique_lock<std::mutex> lock(this->queue_mutex);
-    this->tasks.emplace(move(task));
+    if (node >= 0 && node < static_cast<int>(this->tasks.size())) {
+      queue = node;
+    } else {
+      queue = this->next_queue;
+      this->next_queue = (this->next_queue + 1) % this->tasks.size();
+    }
+    this->tasks[queue].emplace(task, group);
   }
-  this->cv.notify_one();
+  this->cvs[queue].notify_one();
 }
 
+int ThreadPool::nNodes() { return static_cast<int>(this->tasks.size()); }
+
+int ThreadPool::nThreads() { return static_cast<int>(this->threads.size()); }
+
 void ThreadPool::synchronize() {
-  std::unique_lock<std::mutex> lock(this->counter_mutex);
-  bool stop = (this->tasks_pushed == this->tasks_finished);
-  lock.unlock();
-  while (!stop) {
-    lock.lock();
-    stop = (this->tasks_pushed == this->tasks_finished);
-    lock.unlock();
+  RELAB_TRACE("ThreadPool::synchronize");
+
+  // Sleep until the workers report that all tasks are complete, instead of spinning on a CPU they may need.
+  unique_lock<mutex> lock(this->counter_mutex);
+  this->finished_cv.wait(lock, [this] { return this->tasks_pushed == this->tasks_finished; });
+}
+
+void ThreadPool::parallelFor(int n, const function<void(int, int)> &task, int min_chunk_size) {
+  // Process small ranges on the calling thread, since sending them to the workers would cost more than it saves.
+  int n_chunks = std::min(static_cast<int>(this->threads.size()), n / std::max(min_chunk_size, 1));
+  if (n_chunks <= 1) {
+    task(0, n);
+    return;
+  }
+
+  // Send one chunk to each thread, and wait for all the chunks to be processed.
+  TaskGroup group;
+  int chunk_size = (n + n_chunks - 1) / n_chunks;
+  for (int begin = 0; begin < n; begin += chunk_size) {
+    int end = std::min(begin + chunk_size, n);
+    this->push([&task, begin, end] { task(begin, end); }, group);
   }
+  group.wait();
 }
 }  // namespace relab::helpers
@@ -2,6 +2,10 @@
 
 #include "helpers/debug.hpp"
 
+#include <functional>
+#include <numeric>
+#include <vector>
+
 namespace relab::helpers {
 
 torch::Device getDevice() {
@@ -22,4 +26,8 @@ bool tensorsAreEqual(const torch::Tensor tensor_1, const torch::Tensor tensor_2)
   }
   return torch::all(torch::eq(tensor_1, tensor_2)).item<bool>();
 }
+
+int64_t nElements(const std::vector<int64_t> &shape) {
+  return std::accumulate(shape.begin(), shape.end(), int64_t(1), std::multiplies<int64_t>());
+}
 }  // namespace relab::helpers
@@ -0,0 +1,177 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "helpers/trace.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace relab::helpers {
+
+namespace {
+
+/**
+ * @brief A class giving an index to the thread owning it, which is released
+ * for other threads when the thread exits.
+ */
+class ThreadIndex {
+ private:
+  // The indices released by the threads that exited, and the number of indices given so far.
+  static std::mutex &mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+  static std::vector<int> &freeIndices() {
+    static std::vector<int> free_indices;
+    return free_indices;
+  }
+  static int n_indices;
+
+ public:
+  int index;
+
+  ThreadIndex() {
+    std::lock_guard<std::mutex> lock(mutex());
+    if (freeIndices().size() == 0) {
+      this->index = n_indices++;
+    } else {
+      this->index = freeIndices().back();
+      freeIndices().pop_back();
+    }
+  }
+
+  ~ThreadIndex() {
+    std::lock_guard<std::mutex> lock(mutex());
+    freeIndices().push_back(this->index);
+  }
+};
+
+int ThreadIndex::n_indices = 0;
+}  // namespace
+
+/**
+ * Implementation of the Tracer methods.
+ */
+
+Tracer::Tracer() : enabled(false), start_time(steady_clock::now()), capacity(0), n_events(0) {}
+
+Tracer &Tracer::global() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::start(int capacity) {
+  if (capacity < 0) {
+    throw std::runtime_error("The capacity of the tracer must not be negative.");
+  }
+  std::lock_guard<std::mutex> lock(this->events_mutex);
+  this->events = std::make_unique<TraceSlot[]>(capacity);
+  this->capacity = capacity;
+  this->n_events.store(0, std::memory_order_relaxed);
+  this->enabled.store(true, std::memory_order_release);
+}
+
+void Tracer::stop() { this->enabled.store(false, std::memory_order_release); }
+
+bool Tracer::isEnabled() const { return this->enabled.load(std::memory_order_relaxed); }
+
+int64_t Tracer::now() const { return duration_cast<nanoseconds>(steady_clock::now() - this->start_time).count(); }
+
+void Tracer::record(const char *name, int64_t start, int64_t duration) {
+  if (this->capacity == 0) {
+    return;
+  }
+
+  // Claim a slot of the ring buffer, and write the span in it. The slot's sequence number is cleared while the span
+  // is written, so that a partially written span is never retrieved.
+  uint64_t i = this->n_events.fetch_add(1, std::memory_order_relaxed);
+  TraceSlot &slot = this->events[i % this->capacity];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.event = {name, threadIndex(), start, duration};
+  slot.sequence.store(i + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const std::string &name) {
+  int thread = threadIndex();
+  std::lock_guard<std::mutex> lock(this->events_mutex);
+  this->thread_names[thread] = name;
+}
+
+int Tracer::threadIndex() {
+  thread_local ThreadIndex thread_index;
+  return thread_index.index;
+}
+
+std::vector<TraceEvent> Tracer::getEvents() {
+  std::lock_guard<std::mutex> lock(this->events_mutex);
+  std::vector<TraceEvent> events;
+  uint64_t n_events = this->n_events.load(std::memory_order_acquire);
+  uint64_t first = (n_events > this->capacity) ? n_events - this->capacity : 0;
+  for (uint64_t i = first; i < n_events; i++) {
+    // Skip the spans still being written, or overwritten by a more recent span while being copied.
+    TraceSlot &slot = this->events[i % this->capacity];
+    if (slot.sequence.load(std::memory_order_acquire) != i + 1) {
+      continue;
+    }
+    TraceEvent event = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == i + 1) {
+      events.push_back(event);
+    }
+  }
+  return events;
+}
+
+std::string Tracer::toJson() {
+  auto events = this->getEvents();
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  // Write the metadata events naming the threads.
+  bool first = true;
+  {
+    std::lock_guard<std::mutex> lock(this->events_mutex);
+    for (auto &[thread, name] : this->thread_names) {
+      json << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread
+           << ",\"args\":{\"name\":\"" << name << "\"}}";
+      first = false;
+    }
+  }
+
+  // Write the spans as complete events, whose times are in microseconds.
+  for (auto &event : events) {
+    json << (first ? "" : ",") << "{\"name\":\"" << event.name << "\",\"cat\":\"relab\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+         << event.thread << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+    first = false;
+  }
+  json << "]}";
+  return json.str();
+}
+
+void Tracer::save(const std::string &path) {
+  std::ofstream file(path);
+  file << this->toJson();
+}
+
+/**
+ * Implementation of the TraceSpan methods.
+ */
+
+TraceSpan::TraceSpan(const char *name) : name(name) {
+  Tracer &tracer = Tracer::global();
+  this->start_time = tracer.isEnabled() ? tracer.now() : -1;
+}
+
+TraceSpan::~TraceSpan() {
+  Tracer &tracer = Tracer::global();
+  if (this->start_time >= 0 && tracer.isEnabled()) {
+    tracer.record(this->name, this->start_time, tracer.now() - this->start_time);
+  }
+}
+}  // namespace relab::helpers
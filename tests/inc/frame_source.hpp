@@ -0,0 +1,177 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#ifndef TESTS_INC_FRAME_SOURCE_HPP_
+#define TESTS_INC_FRAME_SOURCE_HPP_
+
+#include <torch/extension.h>
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "agents/memory/experience.hpp"
+
+namespace relab::test::impl {
+
+using relab::agents::memory::Experience;
+
+/**
+ * Enumeration of the games that can be imitated by a frame source.
+ */
+enum class Game {
+  PONG = 0,     // Two paddles exchanging a ball, the episode ends when a player scores 21 points.
+  BREAKOUT = 1  // A paddle bouncing a ball into bricks, the episode ends when all lives are lost.
+};
+
+/**
+ * @brief A class procedurally generating frames that imitate preprocessed
+ * Atari frames.
+ *
+ * @details
+ * The frames are grayscale images drawn from a small palette, with static
+ * walls and score displays, and a few sprites moving from one frame to the
+ * next. Their entropy, motion and episode lengths are therefore close to the
+ * ones of real Atari games, unlike constant or uniformly random frames that
+ * compress either too well or not at all. The same seed always produces the
+ * same frames.
+ */
+class FrameSource {
+ private:
+  Game game;
+  int screen_size;
+  std::mt19937 generator;
+  std::vector<float> screen;
+
+  // The position and velocity of the ball.
+  float ball_x;
+  float ball_y;
+  float ball_dx;
+  float ball_dy;
+
+  // The position of the player's paddle, and of the opponent's paddle in Pong.
+  float paddle;
+  float opponent;
+
+  // The scores of the opponent and of the player, the remaining lives and bricks in Breakout.
+  int scores[2];
+  int lives;
+  std::vector<bool> bricks;
+  int n_bricks;
+
+  // Whether the episode has ended.
+  bool done;
+
+  // The last frames returned as part of an observation.
+  std::deque<torch::Tensor> last_frames;
+
+ public:
+  /**
+   * Create a frame source.
+   * @param game the game to imitate
+   * @param seed the seed of the random number generator
+   * @param screen_size the size of the square frames
+   */
+  FrameSource(Game game = Game::PONG, int seed = 0, int screen_size = 84);
+
+  /**
+   * Start a new episode.
+   */
+  void reset();
+
+  /**
+   * Move the game forward by one frame, nothing happens if the episode has ended.
+   * @param action the action performed by the player: 0 (no-op), 1 (up or left) or 2 (down or right)
+   * @return the reward received by the player
+   */
+  float step(int action);
+
+  /**
+   * Retrieve the current frame.
+   * @return the frame, whose pixels are in [0, 1]
+   */
+  torch::Tensor frame();
+
+  /**
+   * Check whether the episode has ended.
+   * @return true if the episode has ended, false otherwise
+   */
+  bool isDone();
+
+  /**
+   * Select an action the way an imperfect player would, i.e., follow the ball
+   * most of the time and act randomly otherwise.
+   * @return the action
+   */
+  int sampleAction();
+
+  /**
+   * Retrieve the next experiences, new episodes are started whenever an
+   * episode ends. Successive calls return consecutive experiences, as long as
+   * the stack size does not change.
+   * @param n the number of experiences
+   * @param stack_size the number of frames per observation
+   * @param frame_skip the number of times each action is repeated
+   * @return the experiences
+   */
+  std::vector<Experience> getExperiences(int n, int stack_size = 4, int frame_skip = 1);
+
+  /**
+   * Retrieve the next frames, new episodes are started whenever an episode ends.
+   * @param n the number of frames
+   * @return the frames
+   */
+  std::vector<torch::Tensor> getFrames(int n);
+
+ private:
+  /**
+   * Throw the ball from the middle of the screen in a random direction.
+   */
+  void serve();
+
+  /**
+   * Move the game forward by one frame.
+   * @param action the action performed by the player
+   * @return the reward received by the player
+   */
+  float stepPong(int action);
+
+  /**
+   * Move the game forward by one frame.
+   * @param action the action performed by the player
+   * @return the reward received by the player
+   */
+  float stepBreakout(int action);
+
+  /**
+   * Draw the current state of the game on the screen.
+   */
+  void render();
+
+  /**
+   * Fill a rectangle of the screen, the parts outside the screen are ignored.
+   * @param x the column of the rectangle's left side
+   * @param y the row of the rectangle's top side
+   * @param width the rectangle's width
+   * @param height the rectangle's height
+   * @param value the value of the rectangle's pixels
+   */
+  void fillRectangle(int x, int y, int width, int height, float value);
+
+  /**
+   * Draw a number using a 3x5 pixel font.
+   * @param number the number to draw
+   * @param x the column of the number's left side
+   * @param y the row of the number's top side
+   * @param value the value of the number's pixels
+   */
+  void drawNumber(int number, int x, int y, float value);
+};
+
+}  // namespace relab::test::impl
+
+namespace relab::test {
+using impl::FrameSource;
+using impl::Game;
+}  // namespace relab::test
+
+#endif  // TESTS_INC_FRAME_SOURCE_HPP_
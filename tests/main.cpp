@@ -9,8 +9,10 @@
 
 #include "agents/memory/experience.hpp"
 #include "agents/memory/replay_buffer.hpp"
+#include "frame_source.hpp"
 
 using namespace relab::agents::memory;
+using namespace relab::test;
 
 /**
  * This main is provided for debugging purposes.
@@ -21,17 +23,15 @@ int main(int argc, char *argv[]) {
   auto capacity = 1000000;
   auto buffer = std::make_shared<ReplayBuffer>(capacity = capacity);
 
-  // Append an experience to the replay buffer.
-  for (auto i = 0; i < 2 * capacity; i++) {
+  // Append experiences imitating a game of Pong to the replay buffer.
+  auto source = FrameSource(Game::PONG);
+  for (auto i = 0; i < 2 * capacity; i += 1000) {
     if (i == capacity) {
       std::cout << "buffer is full!" << std::endl;
     }
-    auto obs = torch::zeros({4, 84, 84});
-    auto next_obs = torch::ones({4, 84, 84});
-    auto action = 0;
-    auto reward = 1.0;
-    auto done = false;
-    buffer->append(Experience(obs, action, reward, done, next_obs));
+    for (auto experience : source.getExperiences(1000)) {
+      buffer->append(experience);
+    }
   }
   std::cout << "after append!" << std::endl;
 
@@ -3,9 +3,14 @@
 #include "agents/memory/test_frame_buffer.hpp"
 #include <torch/extension.h>
 
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "frame_source.hpp"
 #include "relab_test.hpp"
 
 using namespace relab::agents::memory;
@@ -68,6 +73,35 @@ TEST_P(TestFrameBuffer, TestStoringAndRetrievalMultipleEpisodes) {
   }
 }
 
+TEST_P(TestFrameBuffer, TestStoringAndRetrievalWithDeduplication) {
+  // Create a frame buffer whose deduplication window spans several episodes.
+  auto buffer = FrameBuffer(
+      params.capacity, params.frame_skip, params.n_steps, params.stack_size, 84, CompressorType::ZLIB, 1,
+      2 * params.capacity * params.stack_size
+  );
+
+  // Create the experiences at time t, where the first observation of each
+  // episode duplicates the frames of the previous episodes.
+  auto experiences = getExperiences(observations, 2 * params.capacity - 1, params.capacity);
+
+  // Create the multistep experiences at time t (experiences expected to be
+  // returned by the frame buffer).
+  auto results = getResultExperiences(observations, params.gamma, params.n_steps, 2 * params.capacity, params.capacity);
+
+  // Fill the buffer with experiences, effectively replacing the first episode.
+  for (int t = 0; t < 2 * params.capacity - 1; t++) {
+    buffer.append(experiences[t]);
+  }
+
+  // Check that the experiences in the frame buffer are as expected.
+  auto indices = torch::arange(params.capacity);
+  auto [obs_t, obs_tn] = buffer[indices];
+  for (int t = 0; t < params.capacity - params.n_steps + 1; t++) {
+    EXPECT_EQ_TENSOR(results[params.capacity - params.n_steps + t].obs, obs_t[t]);
+    EXPECT_EQ_TENSOR(results[params.capacity - params.n_steps + t].next_obs, obs_tn[t]);
+  }
+}
+
 TEST_P(TestFrameBuffer, TestStoringAndRetrieval) {
   // Create the experiences at time t.
   auto experiences = getExperiences(observations, observations.size() - 1);
@@ -104,6 +138,121 @@ TEST_P(TestFrameBuffer, TestStoringAndRetrieval) {
   }
 }
 
+TEST_P(TestFrameBuffer, TestStoringAndRetrievalOfNewestFrames) {
+  // Create the experiences at time t, whose next observations only contain the frames added to the buffer.
+  int n_frames = std::min(params.frame_skip, params.stack_size);
+  std::vector<Experience> experiences;
+  for (auto &experience : getExperiences(observations, observations.size() - 1)) {
+    experiences.push_back(Experience::fromNewestFrames(
+        experience.obs, experience.action, experience.reward, experience.done, experience.next_obs, n_frames
+    ));
+  }
+
+  // Create the multistep experiences at time t (experiences expected to be
+  // returned by the replay buffer).
+  auto results = getResultExperiences(observations, params.gamma, params.n_steps, 2 * params.capacity);
+
+  // Fill the buffer with experiences.
+  int n_experiences = params.capacity + params.n_steps - 1;
+  for (int t = 0; t < n_experiences; t++) {
+    EXPECT_EQ(experiences[t].next_obs.size(0), n_frames);
+    buffer->append(experiences[t]);
+  }
+
+  // Check that experiences in the frame buffer are as expected.
+  auto indices = torch::arange(params.capacity);
+  auto [obs_t, obs_tn] = (*buffer)[indices];
+  for (int t = 0; t < params.capacity; t++) {
+    EXPECT_EQ_TENSOR(results[t].obs, obs_t[t]);
+    EXPECT_EQ_TENSOR(results[t].next_obs, obs_tn[t]);
+  }
+
+  // Check that next observations missing some of the newest frames are rejected.
+  if (n_frames > 1) {
+    auto experience = Experience::fromNewestFrames(
+        experiences[0].obs, 0, 0, false, observations[n_experiences + 1], n_frames - 1
+    );
+    EXPECT_THROW(buffer->append(experience), std::runtime_error);
+  }
+}
+
+TEST_P(TestFrameBuffer, TestStoringAndRetrievalWithDeltaCompression) {
+  // Create a frame buffer compressing the difference between consecutive frames.
+  auto buffer = FrameBuffer(
+      params.capacity, params.frame_skip, params.n_steps, params.stack_size, 84, CompressorType::DELTA
+  );
+
+  // Create the experiences at time t.
+  auto experiences = getExperiences(observations, observations.size() - 1);
+
+  // Create the multistep experiences at time t (experiences expected to be
+  // returned by the replay buffer).
+  auto results = getResultExperiences(observations, params.gamma, params.n_steps, 2 * params.capacity);
+
+  // Fill the buffer with experiences.
+  int n_experiences = params.capacity + params.n_steps - 1;
+  for (int t = 0; t < n_experiences; t++) {
+    buffer.append(experiences[t]);
+  }
+
+  // Check that experiences in the frame buffer are as expected.
+  auto indices = torch::arange(params.capacity);
+  auto [obs_t, obs_tn] = buffer[indices];
+  for (int t = 0; t < params.capacity; t++) {
+    EXPECT_EQ_TENSOR(results[t].obs, obs_t[t]);
+    EXPECT_EQ_TENSOR(results[t].next_obs, obs_tn[t]);
+  }
+
+  // Keep pushing experiences to the buffer, effectively replacing all
+  // experiences and evicting keyframes from the frame buffer.
+  for (int t = 0; t < params.capacity; t++) {
+    buffer.append(experiences[t + n_experiences]);
+  }
+
+  // Check that the new experiences in the frame buffer are as expected.
+  std::tie(obs_t, obs_tn) = buffer[indices];
+  for (int t = 0; t < params.capacity; t++) {
+    EXPECT_EQ_TENSOR(results[params.capacity + t].obs, obs_t[t]);
+    EXPECT_EQ_TENSOR(results[params.capacity + t].next_obs, obs_tn[t]);
+  }
+}
+
+TEST_P(TestFrameBuffer, TestStoringAndRetrievalWithDictionary) {
+  // Create a frame buffer training its compression dictionary on the first three frames.
+  auto buffer = FrameBuffer(
+      params.capacity, params.frame_skip, params.n_steps, params.stack_size, 84, CompressorType::ZLIB, 1, 0, 3
+  );
+
+  // Create the experiences at time t.
+  auto experiences = getExperiences(observations, observations.size() - 1);
+
+  // Create the multistep experiences at time t (experiences expected to be
+  // returned by the replay buffer).
+  auto results = getResultExperiences(observations, params.gamma, params.n_steps, 2 * params.capacity);
+
+  // Fill the buffer with experiences, some of which are encoded before the dictionary is trained.
+  int n_experiences = params.capacity + params.n_steps - 1;
+  for (int t = 0; t < n_experiences; t++) {
+    buffer.append(experiences[t]);
+  }
+
+  // Save the frame buffer, and load it in a frame buffer without dictionary.
+  std::stringstream ss;
+  buffer.save(ss);
+  auto loaded_buffer = FrameBuffer(10, 10, 10, 10);
+  loaded_buffer.load(ss);
+
+  // Check that experiences in both frame buffers are as expected.
+  auto indices = torch::arange(params.capacity);
+  for (auto current_buffer : {&buffer, &loaded_buffer}) {
+    auto [obs_t, obs_tn] = (*current_buffer)[indices];
+    for (int t = 0; t < params.capacity; t++) {
+      EXPECT_EQ_TENSOR(results[t].obs, obs_t[t]);
+      EXPECT_EQ_TENSOR(results[t].next_obs, obs_tn[t]);
+    }
+  }
+}
+
 TEST_P(TestFrameBuffer, TestSaveAndLoad) {
   // Create the experiences at time t.
   auto experiences = getExperiences(observations, observations.size() - 1);
@@ -136,6 +285,139 @@ INSTANTIATE_TEST_SUITE_P(
     )
 );
 
+TEST(TestFrameBuffer, TestDeduplicationOfStaticFrames) {
+  // Create a frame buffer deduplicating frames, and experiences whose frames are all identical.
+  int capacity = 8;
+  auto buffer = FrameBuffer(capacity, 1, 1, 4, 84, CompressorType::ZLIB, 1, 4);
+  auto observation = torch::ones({4, 84, 84}) / 2;
+
+  // Fill the buffer with experiences.
+  for (int t = 0; t < 2 * capacity; t++) {
+    buffer.append(Experience(observation, t, t, false, observation));
+  }
+
+  // Check that all the observations in the frame buffer are as expected.
+  auto [obs_t, obs_tn] = buffer[torch::arange(capacity)];
+  for (int t = 0; t < capacity; t++) {
+    EXPECT_EQ_TENSOR(observation, obs_t[t]);
+    EXPECT_EQ_TENSOR(observation, obs_tn[t]);
+  }
+
+  // Check that the last frames share the same encoded tensor, i.e., the 20th and last frame is a duplicate.
+  EXPECT_EQ(buffer.getEncodedFrame(18).data_ptr(), buffer.getEncodedFrame(19).data_ptr());
+
+  // Save and load the frame buffer, and check that the encoded tensor is still shared.
+  std::stringstream ss;
+  buffer.save(ss);
+  auto loaded_buffer = FrameBuffer(10, 10, 10, 10);
+  loaded_buffer.load(ss);
+  EXPECT_EQ(buffer, loaded_buffer);
+  EXPECT_EQ(loaded_buffer.getEncodedFrame(18).data_ptr(), loaded_buffer.getEncodedFrame(19).data_ptr());
+  EXPECT_EQ(loaded_buffer.memoryStats()["compressed_frames"], buffer.memoryStats()["compressed_frames"]);
+}
+
+TEST(TestFrameBuffer, TestStoringAndRetrievalOfGameFrames) {
+  for (auto type : {CompressorType::RAW, CompressorType::ZLIB, CompressorType::DELTA}) {
+    for (auto game : {Game::PONG, Game::BREAKOUT}) {
+      // Create a frame buffer, and a frame source generating several episodes of a game.
+      int capacity = 100;
+      auto buffer = FrameBuffer(capacity, 1, 1, 4, 84, type, 1, 4);
+      auto source = FrameSource(game);
+
+      // Fill the buffer with experiences, which are generated a few at a time to bound memory usage.
+      std::vector<Experience> experiences;
+      for (int i = 0; i < 30; i++) {
+        experiences = source.getExperiences(capacity);
+        for (auto experience : experiences) {
+          buffer.append(experience);
+        }
+      }
+
+      // Check that the last experiences are stored in the frame buffer.
+      auto [obs_t, obs_tn] = buffer[torch::arange(capacity)];
+      for (int t = 0; t < capacity; t++) {
+        EXPECT_EQ_TENSOR(experiences[t].obs, obs_t[t]);
+        EXPECT_EQ_TENSOR(experiences[t].next_obs, obs_tn[t]);
+      }
+    }
+  }
+}
+
+TEST(TestFrameBuffer, TestRetrievalOfShorterAndStridedStacks) {
+  for (auto type : {CompressorType::RAW, CompressorType::ZLIB, CompressorType::DELTA}) {
+    // Create a frame buffer storing observations of six frames, and fill it with game frames.
+    int capacity = 50;
+    int stack_size = 6;
+    auto buffer = FrameBuffer(capacity, 1, 1, stack_size, 84, type);
+    auto source = FrameSource(Game::PONG);
+    for (auto experience : source.getExperiences(capacity, stack_size)) {
+      buffer.append(experience);
+    }
+
+    // Check that the stacks are the frames of the full observations ending with their newest frame.
+    auto indices = torch::arange(capacity);
+    auto [obs_t, obs_tn] = buffer[indices];
+    for (auto [n_frames, stride] : std::vector<std::pair<int, int>>{{1, 1}, {3, 1}, {3, 2}, {2, 5}, {6, 1}}) {
+      auto frame_indices = torch::arange(stack_size - 1 - (n_frames - 1) * stride, stack_size, stride);
+      auto [stack_t, stack_tn] = buffer.getObservations(indices, n_frames, stride);
+      ASSERT_EQ(stack_t.size(1), n_frames);
+      EXPECT_EQ_TENSOR(obs_t.index_select(1, frame_indices), stack_t);
+      EXPECT_EQ_TENSOR(obs_tn.index_select(1, frame_indices), stack_tn);
+    }
+
+    // Check that stacks reaching beyond the stored observations are rejected.
+    EXPECT_THROW(buffer.getObservations(indices, 7), std::runtime_error);
+    EXPECT_THROW(buffer.getObservations(indices, 3, 3), std::runtime_error);
+  }
+}
+
+TEST(TestFrameBuffer, TestStoringAndRetrievalOfRgbAndNonSquareFrames) {
+  std::vector<std::vector<int64_t>> shapes = {{60, 80}, {3, 64, 64}, {3, 48, 32}};
+  for (auto type : {CompressorType::RAW, CompressorType::ZLIB, CompressorType::DELTA}) {
+    for (auto shape : shapes) {
+      for (bool channel_last : {false, true}) {
+        // Create a frame buffer, and the frames of an episode whose pixels take 256 values, as in RGB images.
+        int capacity = 10;
+        int stack_size = 4;
+        auto buffer = FrameBuffer(capacity, 1, 1, stack_size, shape, type);
+        std::vector<int64_t> stack_shape = {stack_size + capacity};
+        stack_shape.insert(stack_shape.end(), shape.begin(), shape.end());
+        auto frames = torch::randint(0, 256, stack_shape, torch::TensorOptions().dtype(torch::kFloat32)) / 255;
+
+        // Fill the buffer with experiences, whose multi-channel frames may be in channel-last order.
+        for (int t = 0; t < capacity; t++) {
+          auto obs = frames.slice(0, t, t + stack_size);
+          auto next_obs = frames.slice(0, t + 1, t + 1 + stack_size);
+          if (channel_last == true && shape.size() == 3) {
+            obs = obs.permute({0, 2, 3, 1});
+            next_obs = next_obs.permute({0, 2, 3, 1});
+          }
+          buffer.append(Experience(obs, t, t, false, next_obs));
+        }
+
+        // Check that the observations are retrieved with their channels first.
+        auto [obs_t, obs_tn] = buffer[torch::arange(capacity)];
+        for (int t = 0; t < capacity; t++) {
+          EXPECT_EQ_TENSOR(frames.slice(0, t, t + stack_size), obs_t[t]);
+          EXPECT_EQ_TENSOR(frames.slice(0, t + 1, t + 1 + stack_size), obs_tn[t]);
+        }
+
+        // Check that the frame shape is saved and loaded with the frames.
+        std::stringstream ss;
+        buffer.save(ss);
+        auto loaded_buffer = FrameBuffer(capacity, 1, 1, stack_size, shape, type);
+        loaded_buffer.load(ss);
+        EXPECT_EQ(buffer, loaded_buffer);
+      }
+    }
+  }
+
+  // Check that frames whose shape differs from the buffer's frames are rejected.
+  auto buffer = FrameBuffer(10, 1, 1, 4, std::vector<int64_t>{3, 64, 64});
+  auto observation = torch::zeros({4, 64, 64});
+  EXPECT_THROW(buffer.append(Experience(observation, 0, 0, false, observation)), std::runtime_error);
+}
+
 TEST(TestFrameBuffer, TestEncodingAndDecoding) {
   // Create a frame buffer.
   auto buffer = FrameBuffer(8, 1, 1, 4);
@@ -153,4 +435,116 @@ TEST(TestFrameBuffer, TestEncodingAndDecoding) {
     EXPECT_EQ_TENSOR(frame, decoded_frame);
   }
 }
+
+TEST(TestFrameBuffer, TestDecodingOfDeltaFrames) {
+  // Create a frame buffer using delta compression, and encode a keyframe followed by a delta frame.
+  auto buffer = FrameBuffer(8, 1, 1, 4, 84, CompressorType::DELTA);
+  auto keyframe = torch::rand({84, 84});
+  auto encoded_keyframe = buffer.encode(keyframe);
+  auto encoded_frame = buffer.encode(torch::rand({84, 84}));
+
+  // Check that only the keyframe can be decoded on its own.
+  EXPECT_EQ_TENSOR(keyframe, buffer.decode(encoded_keyframe));
+  EXPECT_THROW(buffer.decode(encoded_frame), std::runtime_error);
+}
+
+TEST(TestFrameBuffer, TestSavingAndLoadingOfCompressors) {
+  // Create a frame buffer whose compressor is trained on its first frames, and add experiences to it.
+  auto buffer = FrameBuffer(8, 1, 1, 4, 84, CompressorType::ZLIB, 1, 0, 4);
+  for (int t = 0; t < 8; t++) {
+    auto observation = torch::rand({4, 84, 84});
+    buffer.append(Experience(observation, t, t, false, observation));
+  }
+
+  // Check that the trained dictionary is restored, so that the loaded frames can still be decoded.
+  std::stringstream ss;
+  buffer.save(ss);
+  auto loaded_buffer = FrameBuffer(8, 1, 1, 4, 84, CompressorType::ZLIB);
+  loaded_buffer.load(ss);
+  EXPECT_EQ(buffer, loaded_buffer);
+  auto [obs_t, obs_tn] = buffer[torch::arange(8)];
+  auto [loaded_obs_t, loaded_obs_tn] = loaded_buffer[torch::arange(8)];
+  EXPECT_EQ_TENSOR(obs_t, loaded_obs_t);
+  EXPECT_EQ_TENSOR(obs_tn, loaded_obs_tn);
+
+  // Check that a checkpoint saved by a compressor of another type is rejected.
+  std::stringstream raw_ss;
+  FrameBuffer(8, 1, 1, 4, 84, CompressorType::RAW).save(raw_ss);
+  EXPECT_THROW(loaded_buffer.load(raw_ss), std::runtime_error);
+}
+
+TEST(TestFrameBuffer, TestClearingForgetsTheTrainedDictionary) {
+  // Create a frame buffer whose compressor is trained on its first frames, and encode a frame with the dictionary.
+  auto buffer = FrameBuffer(8, 1, 1, 4, 84, CompressorType::ZLIB, 1, 0, 4);
+  for (int t = 0; t < 8; t++) {
+    auto observation = torch::rand({4, 84, 84});
+    buffer.append(Experience(observation, t, t, false, observation));
+  }
+  auto encoded_frame = buffer.encode(torch::rand({84, 84}));
+
+  // Check that the cleared buffer no longer decodes frames compressed with the stale dictionary.
+  buffer.clear();
+  EXPECT_THROW(buffer.decode(encoded_frame), std::runtime_error);
+
+  // Check that the cleared buffer trains a new dictionary, and decodes the frames compressed with it.
+  std::vector<torch::Tensor> observations;
+  for (int t = 0; t < 8; t++) {
+    observations.push_back(torch::rand({4, 84, 84}));
+    buffer.append(Experience(observations.back(), t, t, false, observations.back()));
+  }
+  auto [obs_t, obs_tn] = buffer[torch::arange(4, 8)];
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ_TENSOR(obs_t[i], observations[i + 4]);
+  }
+}
+
+TEST(TestFrameBuffer, TestLoadingFramesOfAnotherShape) {
+  // Create a frame buffer storing frames of another size than the buffer loading its checkpoint.
+  auto buffer = FrameBuffer(8, 1, 1, 4, 64, CompressorType::ZLIB);
+  for (int t = 0; t < 8; t++) {
+    auto observation = torch::rand({4, 64, 64});
+    buffer.append(Experience(observation, t, t, false, observation));
+  }
+
+  // Check that the loaded buffer compresses and decodes frames of the checkpoint's shape.
+  std::stringstream ss;
+  buffer.save(ss);
+  auto loaded_buffer = FrameBuffer(8, 1, 1, 4, 84, CompressorType::ZLIB);
+  loaded_buffer.load(ss);
+  auto [obs_t, obs_tn] = buffer[torch::arange(8)];
+  auto [loaded_obs_t, loaded_obs_tn] = loaded_buffer[torch::arange(8)];
+  EXPECT_EQ_TENSOR(obs_t, loaded_obs_t);
+  EXPECT_EQ_TENSOR(obs_tn, loaded_obs_tn);
+  auto frame = torch::rand({64, 64});
+  EXPECT_EQ_TENSOR(loaded_buffer.decode(loaded_buffer.encode(frame)), frame);
+}
+
+TEST(TestFrameBuffer, TestEncodingAndDecodingFromMultipleThreads) {
+  // Create a frame buffer.
+  auto buffer = FrameBuffer(8, 1, 1, 4);
+
+  // Encode and decode frames from several threads sharing the same compressor.
+  int n_threads = 4;
+  std::vector<std::vector<torch::Tensor>> frames(n_threads);
+  std::vector<std::vector<torch::Tensor>> decoded_frames(n_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n_threads; i++) {
+    threads.push_back(std::thread([&buffer, &frames, &decoded_frames, i]() {
+      for (int j = 0; j < 64; j++) {
+        frames[i].push_back(torch::rand({84, 84}));
+        decoded_frames[i].push_back(buffer.decode(buffer.encode(frames[i].back())));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Check that the initial and decoded frames are identical.
+  for (int i = 0; i < n_threads; i++) {
+    for (size_t j = 0; j < frames[i].size(); j++) {
+      EXPECT_EQ_TENSOR(frames[i][j], decoded_frames[i][j]);
+    }
+  }
+}
 }  // namespace relab::test::agents::memory
@@ -3,13 +3,19 @@
 #include "agents/memory/test_priority_tree.hpp"
 #include <torch/extension.h>
 
+#include <cmath>
 #include <memory>
+#include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "helpers/thread_pool.hpp"
+
 #include "relab_test.hpp"
 
 using namespace relab::agents::memory;
+using namespace relab::helpers;
 
 namespace relab::test::agents::memory {
 
@@ -48,6 +54,7 @@ TEST_P(TestPriorityTree, TestClear) {
   EXPECT_EQ(priority_tree->size(), 0);
   EXPECT_EQ(priority_tree->maxTreeToStr(), "[[0.0, 0.0], [0.0]]");
   EXPECT_EQ(priority_tree->sumTreeToStr(), "[[0.0, 0.0], [0.0]]");
+  EXPECT_EQ(priority_tree->minTreeToStr(), "[[inf, inf], [inf]]");
 }
 
 TEST_P(TestPriorityTree, TestSaveAndLoad) {
@@ -68,6 +75,58 @@ TEST_P(TestPriorityTree, TestSaveAndLoad) {
   EXPECT_EQ(*priority_tree, loaded_priority_tree);
 }
 
+TEST_P(TestPriorityTree, TestSaveAndLoadCompressed) {
+  // Add all elements to the priority tree.
+  for (auto element : params.elements) {
+    priority_tree->append(element);
+  }
+
+  // Save the priority tree without its sum-tree and max-tree.
+  std::stringstream ss;
+  priority_tree->save(ss, true);
+
+  // Load the priority tree, rebuilding its sum-tree and max-tree.
+  auto loaded_priority_tree = PriorityTree(10, 10, 10);
+  loaded_priority_tree.load(ss, true);
+
+  // Check that the saved and loaded priority trees are identical.
+  EXPECT_EQ(*priority_tree, loaded_priority_tree);
+}
+
+TEST_P(TestPriorityTree, TestSumWithFenwickTree) {
+  // Arrange.
+  auto priority_tree = PriorityTree(4, 1.0, 2, SumTreeType::FENWICK);
+
+  // Act.
+  for (auto element : params.elements) {
+    priority_tree.append(element);
+  }
+
+  // Assert.
+  EXPECT_EQ(priority_tree.sum(), params.result);
+}
+
+TEST_P(TestPriorityTree, TestSaveAndLoadWithFenwickTree) {
+  // Add all elements to the priority tree.
+  auto priority_tree = PriorityTree(4, 1.0, 2, SumTreeType::FENWICK);
+  for (auto element : params.elements) {
+    priority_tree.append(element);
+  }
+
+  // Save the priority tree, with and without its Fenwick tree.
+  std::stringstream ss;
+  priority_tree.save(ss);
+  priority_tree.save(ss, true);
+
+  // Load the priority tree twice, the second time rebuilding its Fenwick tree from the priorities.
+  auto loaded_priority_tree = PriorityTree(10, 10, 10);
+  loaded_priority_tree.load(ss);
+  EXPECT_EQ(priority_tree, loaded_priority_tree);
+  auto loaded_compressed_priority_tree = PriorityTree(10, 10, 10);
+  loaded_compressed_priority_tree.load(ss, true);
+  EXPECT_EQ(priority_tree, loaded_compressed_priority_tree);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     UnitTests, TestPriorityTree,
     testing::Values(
@@ -103,6 +162,204 @@ INSTANTIATE_TEST_SUITE_P(
     )
 );
 
+TEST(TestPriorityTree, TestMin) {
+  // Arrange.
+  auto priority_tree = PriorityTree(4, 1.0, 2);
+
+  // Act and assert.
+  EXPECT_EQ(priority_tree.min(), 1.0);
+  for (auto element : {1000, 10, 100}) {
+    priority_tree.append(element);
+  }
+  EXPECT_EQ(priority_tree.min(), 10);
+  for (auto element : {5, 999}) {
+    priority_tree.append(element);
+  }
+  EXPECT_EQ(priority_tree.min(), 5);
+  priority_tree.set(2, 50);
+  EXPECT_EQ(priority_tree.min(), 10);
+  priority_tree.set(0, 0.5);
+  EXPECT_EQ(priority_tree.min(), 0.5);
+  EXPECT_EQ(priority_tree.minTreeToStr(), "[[0.5, 50.0], [0.5]]");
+}
+
+TEST(TestPriorityTree, TestImportanceWeights) {
+  // Arrange.
+  auto priority_tree = PriorityTree(4, 1.0, 2);
+  for (auto element : {1, 2, 4, 8}) {
+    priority_tree.append(element);
+  }
+
+  // Act.
+  auto weights = priority_tree.importanceWeights(torch::arange(4), 0.5);
+
+  // Assert.
+  std::vector<float> results = {1.0, 1.0 / std::sqrt(2.0), 0.5, 1.0 / std::sqrt(8.0)};
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_TRUE(abs(weights[i].item<float>() - results[i]) < TEST_EPSILON);
+  }
+}
+
+TEST(TestPriorityTree, TestImportanceWeightsOfZeroPriorities) {
+  // Arrange.
+  auto priority_tree = PriorityTree(4, 1.0, 2);
+  for (auto element : {0, 1, 0, 4}) {
+    priority_tree.append(element);
+  }
+
+  // Act.
+  auto weights = priority_tree.importanceWeights(torch::arange(4), 0.5);
+
+  // Assert.
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(std::isfinite(weights[i].item<float>()));
+    EXPECT_LE(weights[i].item<float>(), 1.0);
+  }
+  EXPECT_EQ(weights[0].item<float>(), 1.0);
+  EXPECT_EQ(weights[2].item<float>(), 1.0);
+  EXPECT_TRUE(weights[1].item<float>() > weights[3].item<float>());
+}
+
+TEST(TestPriorityTree, TestImportanceWeightsByRank) {
+  // Arrange.
+  auto priority_tree = PriorityTree(4, 1.0, 2, SumTreeType::N_ARY, PrioritizationType::RANK, 0.5);
+  for (auto element : {1, 2, 4, 8}) {
+    priority_tree.append(element);
+  }
+
+  // Act.
+  auto weights = priority_tree.importanceWeights(torch::arange(4), 2.0);
+
+  // Assert.
+  std::vector<float> results = {1.0, 0.75, 0.5, 0.25};
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_TRUE(abs(weights[i].item<float>() - results[i]) < TEST_EPSILON);
+  }
+}
+
+TEST(TestPriorityTree, TestSamplingFromAnEmptyTreeIsRejected) {
+  for (auto prioritization : {PrioritizationType::PROPORTIONAL, PrioritizationType::RANK}) {
+    auto priority_tree = PriorityTree(4, 1.0, 2, SumTreeType::N_ARY, prioritization);
+    EXPECT_THROW(priority_tree.sampleIndices(2), std::runtime_error);
+  }
+}
+
+TEST(TestPriorityTree, TestSampleIndicesByRank) {
+  // Arrange.
+  int capacity = 4;
+  auto priority_tree = PriorityTree(capacity, 1.0, 2, SumTreeType::N_ARY, PrioritizationType::RANK, 1.0);
+
+  // Act.
+  for (auto element : {1, 8, 2, 4, 3}) {
+    priority_tree.append(element);
+  }
+  auto indices = priority_tree.sampleIndices(50000);
+
+  // Assert.
+  torch::Tensor probs = indices.bincount(torch::ones_like(indices), capacity).to(torch::kFloat32);
+  auto total = probs.sum();
+  for (int i = 0; i < capacity; i++) {
+    probs[i] /= total;
+  }
+  std::vector<float> results = {12.0 / 25.0, 3.0 / 25.0, 6.0 / 25.0, 4.0 / 25.0};
+  for (int i = 0; i < capacity; i++) {
+    EXPECT_TRUE(abs(probs[i].item<float>() - results[i]) < 0.01);
+  }
+}
+
+TEST(TestPriorityTree, TestSaveAndLoadByRank) {
+  // Arrange.
+  auto priority_tree = PriorityTree(4, 1.0, 2, SumTreeType::N_ARY, PrioritizationType::RANK, 0.5);
+  for (auto element : {1, 2, 4, 8, 3}) {
+    priority_tree.append(element);
+  }
+
+  // Act.
+  std::stringstream ss;
+  priority_tree.save(ss, true);
+  auto loaded_priority_tree = PriorityTree(10, 10, 10);
+  loaded_priority_tree.load(ss, true);
+
+  // Assert.
+  EXPECT_EQ(priority_tree, loaded_priority_tree);
+  auto weights = priority_tree.importanceWeights(torch::arange(4), 1.0);
+  auto loaded_weights = loaded_priority_tree.importanceWeights(torch::arange(4), 1.0);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(weights[i].item<float>(), loaded_weights[i].item<float>());
+  }
+}
+
+TEST(TestPriorityTree, TestSumAfterManyUpdates) {
+  for (auto sum_tree_type : {SumTreeType::N_ARY, SumTreeType::FENWICK}) {
+    // Arrange.
+    int capacity = 16;
+    auto priority_tree = PriorityTree(capacity, 1.0, 2, sum_tree_type);
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> uniform(0.0, 1.0);
+    for (int i = 0; i < capacity; i++) {
+      priority_tree.append(uniform(generator));
+    }
+
+    // Act.
+    for (int i = 0; i < 100000; i++) {
+      priority_tree.set(i % capacity, MAX_PRIORITY * uniform(generator));
+      priority_tree.set(i % capacity, uniform(generator));
+    }
+
+    // Assert.
+    double total = 0;
+    for (int i = 0; i < capacity; i++) {
+      total += priority_tree.get(i);
+    }
+    EXPECT_TRUE(abs(priority_tree.sum() - total) < TEST_EPSILON);
+  }
+}
+
+TEST(TestPriorityTree, TestAssignAll) {
+  for (auto sum_tree_type : {SumTreeType::N_ARY, SumTreeType::FENWICK}) {
+    // Arrange.
+    int capacity = 100000;
+    auto priority_tree = PriorityTree(capacity, 1.0, 10, sum_tree_type);
+    auto assigned_priority_tree = PriorityTree(capacity, 1.0, 10, sum_tree_type);
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> uniform(0.0, 1.0);
+    for (int i = 0; i < capacity + capacity / 2; i++) {
+      priority_tree.append(uniform(generator));
+      assigned_priority_tree.append(1.0);
+    }
+
+    // Act.
+    torch::Tensor priorities = torch::zeros({capacity});
+    float *priorities_ptr = priorities.data_ptr<float>();
+    for (int i = 0; i < capacity; i++) {
+      priorities_ptr[i] = priority_tree.get(i);
+    }
+    assigned_priority_tree.setThreadPool(std::make_shared<ThreadPool>(4));
+    assigned_priority_tree.assignAll(priorities);
+
+    // Assert.
+    EXPECT_TRUE(abs(priority_tree.sum() - assigned_priority_tree.sum()) < 1e-3);
+    EXPECT_EQ(priority_tree.max(), assigned_priority_tree.max());
+    EXPECT_EQ(priority_tree.min(), assigned_priority_tree.min());
+    for (int i = 0; i < capacity; i += 997) {
+      EXPECT_EQ(priority_tree.get(i), assigned_priority_tree.get(i));
+    }
+    EXPECT_EQ(priority_tree.maxTreeToStr(3), assigned_priority_tree.maxTreeToStr(3));
+    EXPECT_EQ(priority_tree.minTreeToStr(3), assigned_priority_tree.minTreeToStr(3));
+    EXPECT_EQ(priority_tree.sumTreeToStr(3), assigned_priority_tree.sumTreeToStr(3));
+
+    // Check that a compressed checkpoint is rebuilt with the thread pool of the loading tree.
+    std::stringstream ss;
+    assigned_priority_tree.save(ss, true);
+    auto loaded_priority_tree = PriorityTree(capacity, 1.0, 10, sum_tree_type);
+    loaded_priority_tree.setThreadPool(std::make_shared<ThreadPool>(4));
+    loaded_priority_tree.load(ss, true);
+    EXPECT_EQ(priority_tree.maxTreeToStr(3), loaded_priority_tree.maxTreeToStr(3));
+    EXPECT_EQ(priority_tree.minTreeToStr(3), loaded_priority_tree.minTreeToStr(3));
+    EXPECT_EQ(priority_tree.sumTreeToStr(3), loaded_priority_tree.sumTreeToStr(3));
+  }
+}
+
 PriorityTreeParameters4::PriorityTreeParameters4(
     const std::initializer_list<float> &elements, const std::string &sum_result, const std::string &max_result,
     int length_result
@@ -326,6 +583,20 @@ TEST_P(TestPriorityTree9, TestTowerSampling) {
   EXPECT_EQ(priority_tree.towerSampling(params.priority), params.result);
 }
 
+TEST_P(TestPriorityTree9, TestTowerSamplingWithFenwickTree) {
+  // Arrange.
+  auto params = GetParam();
+  auto priority_tree = PriorityTree(params.capacity, 1.0, params.n_children, SumTreeType::FENWICK);
+
+  // Act.
+  for (auto element : params.elements) {
+    priority_tree.append(element);
+  }
+
+  // Assert.
+  EXPECT_EQ(priority_tree.towerSampling(params.priority), params.result);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     UnitTests, TestPriorityTree9,
     testing::Values(
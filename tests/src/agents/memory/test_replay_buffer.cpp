@@ -4,9 +4,14 @@
 #include <gtest/gtest.h>
 #include <torch/extension.h>
 
+#include <map>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 
 #include "agents/memory/compressors.hpp"
+#include "helpers/serialize.hpp"
 #include "helpers/torch.hpp"
 
 #include "relab_test.hpp"
@@ -111,6 +116,33 @@ TEST_P(TestReplayBuffer, TestStoringAndRetrieval) {
   compareExperiences(batch, results.begin() + params.capacity, params.capacity);
 }
 
+TEST_P(TestReplayBuffer, TestStoringAndRetrievalOneFrameAtATime) {
+  // Create the experiences at time t, which span several episodes.
+  auto experiences = getExperiences(observations, 2 * params.capacity - 1, params.capacity);
+
+  // Create the multistep experiences at time t (experiences expected to be
+  // returned by the replay buffer).
+  auto results = getResultExperiences(observations, params.gamma, params.n_steps, 2 * params.capacity, params.capacity);
+
+  // Check that steps cannot be added before the first episode begins.
+  auto &first = experiences[0];
+  EXPECT_THROW(buffer->appendStep(first.next_obs[-1], first.action, first.reward, first.done), std::runtime_error);
+
+  // Fill the buffer with the newest frame of each experience.
+  for (int t = 0; t < params.capacity; t++) {
+    auto &experience = experiences[t];
+    if (t == 0 || experiences[t - 1].done == true) {
+      buffer->beginEpisode(experience.obs);
+    }
+    buffer->appendStep(experience.next_obs[-1], experience.action, experience.reward, experience.done);
+  }
+
+  // Check that experiences in the replay buffer are as expected.
+  auto indices = torch::arange(params.capacity);
+  auto batch = buffer->getExperiences(indices);
+  compareExperiences(batch, results.begin(), params.capacity);
+}
+
 TEST_P(TestReplayBuffer, TestSaveAndLoad) {
   // Create the experiences at time t.
   auto experiences = getExperiences(observations, observations.size() - 1);
@@ -133,6 +165,114 @@ TEST_P(TestReplayBuffer, TestSaveAndLoad) {
   EXPECT_EQ(*buffer, loaded_buffer);
 }
 
+TEST_P(TestReplayBuffer, TestSaveAndLoadCompressed) {
+  // Create a replay buffer saving compressed checkpoints.
+  params.args["compress_checkpoint"] = 1;
+  auto buffer = ReplayBuffer(
+      params.capacity, params.batch_size, params.frame_skip, params.stack_size, params.screen_size, params.comp_type,
+      params.args
+  );
+
+  // Fill the buffer with experiences.
+  auto experiences = getExperiences(observations, observations.size() - 1);
+  int n_experiences = params.capacity + params.n_steps - 1;
+  for (int t = 0; t < n_experiences; t++) {
+    buffer.append(experiences[t]);
+  }
+
+  // Save the replay buffer.
+  std::stringstream ss;
+  buffer.saveToFile(ss);
+
+  // Load the replay buffer.
+  auto loaded_buffer = ReplayBuffer();
+  loaded_buffer.loadFromFile(ss);
+
+  // Check that the saved and loaded replay buffers are identical.
+  EXPECT_EQ(buffer, loaded_buffer);
+}
+
+TEST(TestReplayBuffer, TestLoadCheckpointWithoutVersion) {
+  // Create a replay buffer, and add an episode made of a single experience.
+  auto frame_t = torch::full({1, 84, 84}, 0.25);
+  auto frame_tn = torch::full({1, 84, 84}, 0.75);
+  auto buffer = ReplayBuffer(4, 2, 1, 1, 84, CompressorType::ZLIB);
+  buffer.append(Experience(frame_t, 3, 2, true, frame_tn));
+
+  // Write the same buffer in the format used before checkpoints were versioned, i.e., without header, without
+  // compressor state, and with the original priority tree fields.
+  std::stringstream ss;
+  save_value(false, ss);
+  for (int value : {4, 2, 1, 1}) {
+    save_value(value, ss);
+  }
+  save_value(0.99f, ss);
+  save_value(1, ss);
+  save_value(1.0f, ss);
+  save_value(10, ss);
+  save_value(1.0f, ss);
+  save_value(1.0f, ss);
+
+  // The frame buffer, whose storage contains the two encoded frames.
+  auto compressor = Compressor::create(84, 84, CompressorType::ZLIB);
+  for (int value : {1, 1, 4, 1, 84, 4, 4, 100000}) {
+    save_value(value, ss);
+  }
+  save_vector<torch::Tensor, float>({compressor->encode(frame_t[0]), compressor->encode(frame_tn[0])}, ss);
+  for (int value : {0, 1, 0, 1}) {
+    save_value(value, ss);
+  }
+  save_vector<int>({0, 0, 0, 0}, ss);
+  save_vector<int>({1, 0, 0, 0}, ss);
+  for (int value : {1, 2, 0}) {
+    save_value(value, ss);
+  }
+  save_value(true, ss);
+
+  // The data buffer, and its priority tree whose sum-tree and max-tree are rebuilt when loading.
+  save_value(4, ss);
+  save_value(1, ss);
+  save_value(0.99f, ss);
+  for (int value : {1, 0, 1, 0, 1, 0}) {
+    save_value(value, ss);
+  }
+  save_tensor<int>(torch::tensor({3, 0, 0, 0}, torch::kInt), ss);
+  save_tensor<float>(torch::tensor({2.0f, 0.0f, 0.0f, 0.0f}), ss);
+  save_tensor<bool>(torch::tensor({true, false, false, false}), ss);
+  save_value(1.0f, ss);
+  for (int value : {4, 10, 1, 1}) {
+    save_value(value, ss);
+  }
+  save_value(false, ss);
+  save_tensor<float>(torch::tensor({1.0f, 0.0f, 0.0f, 0.0f}), ss);
+  save_vector<double>({0.0}, ss);
+  save_vector<torch::Tensor, float>({torch::zeros({1})}, ss);
+  save_value(1, ss);
+  save_tensor<int64_t>(torch::zeros({0}, torch::kInt64), ss);
+
+  // Load the checkpoint.
+  auto loaded_buffer = ReplayBuffer();
+  loaded_buffer.loadFromFile(ss);
+
+  // Check that the loaded buffer contains the experience, and that its trees are rebuilt from the priorities.
+  ASSERT_EQ(loaded_buffer.size(), 1);
+  auto indices = torch::tensor({0}, torch::kInt64);
+  auto [obs, actions, rewards, dones, next_obs] = loaded_buffer.getExperiences(indices);
+  EXPECT_EQ_TENSOR(frame_t, obs[0]);
+  EXPECT_EQ_TENSOR(frame_tn, next_obs[0]);
+  EXPECT_EQ(actions[0].item<int>(), 3);
+  EXPECT_EQ(rewards[0].item<float>(), 2);
+  EXPECT_EQ(dones[0].item<bool>(), true);
+  EXPECT_EQ(loaded_buffer.getPriorities()->sum(), 1);
+  EXPECT_EQ(loaded_buffer.getPriorities()->max(), 1);
+
+  // Check that a checkpoint with an unknown format version is rejected.
+  std::stringstream future_ss;
+  save_value(CHECKPOINT_MAGIC, future_ss);
+  save_value(CHECKPOINT_VERSION + 1, future_ss);
+  EXPECT_THROW(loaded_buffer.loadFromFile(future_ss), std::runtime_error);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     UnitTests, TestReplayBuffer,
     testing::Values(
@@ -143,6 +283,52 @@ INSTANTIATE_TEST_SUITE_P(
     )
 );
 
+TEST(TestReplayBuffer, TestMemoryStats) {
+  // Add three experiences of the same episode to a buffer storing uncompressed frames, i.e., the four frames of the
+  // first observation and the newest frame of each next observation.
+  int capacity = 8;
+  auto buffer = ReplayBuffer(capacity, 2, 1, 4, 84, CompressorType::RAW);
+  for (int t = 0; t < 3; t++) {
+    buffer.append(Experience(torch::rand({4, 84, 84}), t, t, false, torch::rand({4, 84, 84})));
+  }
+
+  // Check the memory used by the frames, which are stored as they are.
+  auto stats = buffer.memoryStats();
+  double frame_size = 84 * 84 * sizeof(float);
+  EXPECT_EQ(stats["n_frames"], 7);
+  EXPECT_EQ(stats["compressed_frames"], 7 * frame_size);
+  EXPECT_EQ(stats["uncompressed_frames"], 7 * frame_size);
+  EXPECT_EQ(stats["compression_ratio"], 1);
+  EXPECT_EQ(stats["frame_metadata"], 7 * (sizeof(c10::TensorImpl) + sizeof(c10::StorageImpl)));
+  EXPECT_GE(stats["frame_handles"], capacity * sizeof(torch::Tensor));
+
+  // Check the total, and that only the frames and their headers are projected to grow until the buffer is full.
+  double total = 0;
+  for (auto key : {"compressed_frames", "frame_metadata", "frame_handles", "references", "data", "priority_trees"}) {
+    total += stats[key];
+  }
+  EXPECT_EQ(stats["total"], total);
+  double growth = static_cast<double>(capacity) / 3 - 1;
+  EXPECT_DOUBLE_EQ(stats["projected_total"], total + growth * (stats["compressed_frames"] + stats["frame_metadata"]));
+}
+
+TEST(TestReplayBuffer, TestSharedPoolOfBuffersWithDifferentBatchSizes) {
+  // Create two buffers with different batch sizes, which decode their frames with the shared thread pool.
+  std::map<std::string, float> args = {{"shared_pool", 1}};
+  auto small_buffer = ReplayBuffer(16, 2, 1, 4, 84, CompressorType::ZLIB, args);
+  auto large_buffer = ReplayBuffer(16, 8, 1, 4, 84, CompressorType::ZLIB, args);
+
+  // Check that both buffers sample batches of their own size.
+  for (auto buffer : {&small_buffer, &large_buffer}) {
+    for (int t = 0; t < 16; t++) {
+      auto observation = torch::rand({4, 84, 84});
+      buffer->append(Experience(observation, t, t, false, observation));
+    }
+  }
+  EXPECT_EQ(std::get<0>(small_buffer.sample()).size(0), 2);
+  EXPECT_EQ(std::get<0>(large_buffer.sample()).size(0), 8);
+}
+
 TEST(TestReplayBuffer, TestReport) {
   // Arrange.
   auto params = ReplayBufferParameters(true, 2);
@@ -174,6 +360,29 @@ TEST(TestReplayBuffer, TestReport) {
   }
 }
 
+TEST(TestReplayBuffer, TestReportAll) {
+  // Arrange.
+  auto params = ReplayBufferParameters(true, 2);
+  auto buffer = ReplayBuffer(
+      params.capacity, params.batch_size, params.frame_skip, params.stack_size, params.screen_size, params.comp_type,
+      params.args
+  );
+  auto observations = getObservations(11, params.frame_skip, params.stack_size);
+  auto experiences = getExperiences(observations, 10);
+
+  // Acts.
+  for (int t = 0; t < params.capacity + 2; t++) {
+    buffer.append(experiences[t]);
+  }
+  auto loss = torch::arange(buffer.size()).to(torch::kFloat32).to(getDevice());
+  buffer.reportAll(loss);
+
+  // Assert.
+  for (int i = 0; i < buffer.size(); i++) {
+    EXPECT_TRUE(std::abs(buffer.getPriority(i) - i) < 0.0001);
+  }
+}
+
 /**
  * Implementation of the TestReplayBuffer2 test suite.
  */
@@ -0,0 +1,233 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <torch/extension.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "agents/memory/replay_buffer.hpp"
+#include "agents/memory/replay_client.hpp"
+#include "agents/memory/replay_server.hpp"
+
+#include "relab_test.hpp"
+
+using namespace relab::agents::memory;
+
+namespace relab::test::agents::memory {
+
+TEST(TestReplayServer, TestAppendAndSample) {
+  // Arrange.
+  auto observations = getObservations(21);
+  auto experiences = getExperiences(observations, 20);
+  auto buffer = std::make_shared<ReplayBuffer>(32, 8);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  ReplayClient client("/tmp/relab_test_replay_server.sock");
+
+  // Act.
+  client.append(std::vector<Experience>(experiences.begin(), experiences.begin() + 10));
+  client.append(std::vector<Experience>(experiences.begin() + 10, experiences.end()));
+  int size = client.size();
+  auto [obs, actions, rewards, dones, next_obs] = client.sample();
+  server.stop();
+  serving.join();
+
+  // Assert.
+  EXPECT_EQ(size, 20);
+  EXPECT_EQ(buffer->size(), 20);
+  ASSERT_EQ(actions.size(0), 8);
+  for (int i = 0; i < 8; i++) {
+    int t = actions[i].item<int>();
+    EXPECT_EQ_TENSOR(obs[i], experiences[t].obs);
+    EXPECT_EQ_TENSOR(next_obs[i], experiences[t].next_obs);
+    EXPECT_TRUE(std::abs(rewards[i].item<float>() - experiences[t].reward) < TEST_EPSILON);
+    EXPECT_EQ(dones[i].item<bool>(), experiences[t].done);
+  }
+}
+
+TEST(TestReplayServer, TestPipelinedSampleAndReport) {
+  // Arrange.
+  auto observations = getObservations(21);
+  auto experiences = getExperiences(observations, 20);
+  std::map<std::string, float> args = {{"initial_priority", 1}, {"omega_is", 0.5}};
+  auto buffer = std::make_shared<ReplayBuffer>(32, 4, 1, 4, 84, CompressorType::ZLIB, args);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  ReplayClient client("/tmp/relab_test_replay_server.sock");
+  client.append(experiences);
+
+  // Act: request the next batch before reporting the loss of the current one.
+  client.requestSample();
+  auto first_batch = client.receiveSample();
+  client.requestSample();
+  auto loss = torch::full({4}, 2.0);
+  auto new_loss = client.report(loss);
+  auto second_batch = client.receiveSample();
+  server.stop();
+  serving.join();
+
+  // Assert: the loss was reported for the first batch, whose actions are the indices of its experiences.
+  EXPECT_EQ(new_loss.size(0), 4);
+  auto first_actions = std::get<1>(first_batch);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(std::abs(buffer->getPriority(first_actions[i].item<int>()) - (2.0 + 1e-5)) < TEST_EPSILON);
+  }
+  EXPECT_EQ(std::get<1>(second_batch).size(0), 4);
+}
+
+TEST(TestReplayServer, TestInterleavedEpisodesOfTwoClients) {
+  // Arrange: each client plays two episodes of five steps, whose frames are offset by the client index, and sends
+  // them in pieces interleaved with the pieces of the other client. The action of each experience identifies its
+  // client and step.
+  int episode_length = 5;
+  auto observations = getObservations(episode_length + 1);
+  std::vector<std::vector<Experience>> episodes(2);
+  for (int c = 0; c < 2; c++) {
+    for (int t = 0; t < episode_length; t++) {
+      bool done = (t == episode_length - 1);
+      episodes[c].push_back(Experience(observations[t] + c, 100 * c + t, t, done, observations[t + 1] + c));
+    }
+  }
+  auto buffer = std::make_shared<ReplayBuffer>(64, 16);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  std::vector<std::unique_ptr<ReplayClient>> clients;
+  for (int c = 0; c < 2; c++) {
+    clients.push_back(std::make_unique<ReplayClient>("/tmp/relab_test_replay_server.sock"));
+  }
+
+  // Act.
+  for (int episode = 0; episode < 2; episode++) {
+    for (int c = 0; c < 2; c++) {
+      clients[c]->append(std::vector<Experience>(episodes[c].begin(), episodes[c].begin() + 3));
+      clients[c]->size();
+    }
+    for (int c = 0; c < 2; c++) {
+      clients[c]->append(std::vector<Experience>(episodes[c].begin() + 3, episodes[c].end()));
+      clients[c]->size();
+    }
+  }
+  int size = clients[0]->size();
+  auto [obs, actions, rewards, dones, next_obs] = clients[0]->sample();
+  server.stop();
+  serving.join();
+
+  // Assert: the sampled observations are the ones sent by the client of each experience.
+  EXPECT_EQ(size, 4 * episode_length);
+  ASSERT_EQ(actions.size(0), 16);
+  for (int i = 0; i < 16; i++) {
+    int c = actions[i].item<int>() / 100;
+    int t = actions[i].item<int>() % 100;
+    EXPECT_EQ_TENSOR(obs[i], (observations[t] + c));
+    EXPECT_EQ_TENSOR(next_obs[i], (observations[t + 1] + c));
+  }
+}
+
+TEST(TestReplayServer, TestReportAfterTheBufferIsFull) {
+  // Arrange.
+  auto observations = getObservations(11);
+  auto experiences = getExperiences(observations, 10);
+  std::map<std::string, float> args = {{"initial_priority", 1}};
+  auto buffer = std::make_shared<ReplayBuffer>(8, 4, 1, 4, 84, CompressorType::ZLIB, args);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  ReplayClient client("/tmp/relab_test_replay_server.sock");
+  client.append(std::vector<Experience>(experiences.begin(), experiences.begin() + 8));
+
+  // Act: append experiences evicting the two oldest ones between the sample and the report.
+  auto actions = std::get<1>(client.sample());
+  client.append(std::vector<Experience>(experiences.begin() + 8, experiences.end()));
+  auto loss = torch::full({4}, 2.0);
+  auto new_loss = client.report(loss);
+  server.stop();
+  serving.join();
+
+  // Assert: the priorities of the sampled experiences are updated where they now are, and the loss of the evicted
+  // experiences is returned unchanged.
+  ASSERT_EQ(new_loss.size(0), 4);
+  for (int i = 0; i < 4; i++) {
+    int t = actions[i].item<int>();
+    if (t < 2) {
+      EXPECT_EQ(new_loss[i].item<float>(), 2.0);
+    } else {
+      EXPECT_TRUE(std::abs(buffer->getPriority(t - 2) - (2.0 + 1e-5)) < TEST_EPSILON);
+    }
+  }
+}
+
+TEST(TestReplayServer, TestAppendWhileASampleIsPending) {
+  // Arrange.
+  auto observations = getObservations(41);
+  auto experiences = getExperiences(observations, 40);
+  auto buffer = std::make_shared<ReplayBuffer>(64, 32);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  ReplayClient client("/tmp/relab_test_replay_server.sock");
+  client.append(std::vector<Experience>(experiences.begin(), experiences.begin() + 20));
+
+  // Act: request a batch larger than the socket buffers, and append experiences before receiving it.
+  client.requestSample();
+  client.append(std::vector<Experience>(experiences.begin() + 20, experiences.end()));
+  auto batch = client.receiveSample();
+  int size = client.size();
+  server.stop();
+  serving.join();
+
+  // Assert.
+  EXPECT_EQ(std::get<1>(batch).size(0), 32);
+  EXPECT_EQ(size, 40);
+}
+
+TEST(TestReplayServer, TestOversizedRequestIsRejected) {
+  // Arrange.
+  auto buffer = std::make_shared<ReplayBuffer>(32, 4);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  ReplayClient client("/tmp/relab_test_replay_server.sock");
+
+  // Act: send the header of a request whose payload is too large to be allocated.
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, "/tmp/relab_test_replay_server.sock", sizeof(address.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(fd, (struct sockaddr *)&address, sizeof(address)), 0);
+  std::string header;
+  appendMessage(header, MessageType::SIZE);
+  int64_t size = MAX_PAYLOAD_SIZE + 1;
+  std::memcpy(header.data() + sizeof(int32_t), &size, sizeof(size));
+  ASSERT_EQ(send(fd, header.data(), header.size(), 0), static_cast<ssize_t>(header.size()));
+
+  // Assert: the connection is closed, and the other clients are still served.
+  char byte;
+  EXPECT_EQ(recv(fd, &byte, 1, 0), 0);
+  close(fd);
+  EXPECT_EQ(client.size(), 0);
+  server.stop();
+  serving.join();
+}
+
+TEST(TestReplayServer, TestReportWithoutSample) {
+  // Arrange.
+  auto buffer = std::make_shared<ReplayBuffer>(32, 4);
+  ReplayServer server("/tmp/relab_test_replay_server.sock", buffer);
+  std::thread serving([&server]() { server.serve(); });
+  ReplayClient client("/tmp/relab_test_replay_server.sock");
+
+  // Act and assert.
+  auto loss = torch::ones({4});
+  EXPECT_THROW(client.report(loss), std::runtime_error);
+  EXPECT_EQ(client.size(), 0);
+  server.stop();
+  serving.join();
+}
+}  // namespace relab::test::agents::memory
@@ -0,0 +1,106 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <torch/extension.h>
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "agents/memory/sharded_replay_buffer.hpp"
+
+#include "relab_test.hpp"
+
+using namespace relab::agents::memory;
+
+namespace relab::test::agents::memory {
+
+/**
+ * Fill a sharded replay buffer with two actors, the actions of the second actor being offset by 100.
+ * @param buffer the sharded replay buffer
+ * @param observations the observations used to create the experiences
+ * @param n the number of experiences of each actor
+ */
+static void fillWithTwoActors(ShardedReplayBuffer &buffer, const std::vector<torch::Tensor> &observations, int n) {
+  std::vector<std::thread> actors;
+  for (int actor = 0; actor < 2; actor++) {
+    actors.emplace_back([&buffer, &observations, actor, n]() {
+      for (int t = 0; t < n; t++) {
+        buffer.append(Experience(observations[t], t + 100 * actor, t, false, observations[t + 1]), actor);
+      }
+    });
+  }
+  for (auto &actor : actors) {
+    actor.join();
+  }
+}
+
+TEST(TestShardedReplayBuffer, TestAppendAndSample) {
+  // Arrange.
+  auto observations = getObservations(21);
+  auto buffer = ShardedReplayBuffer(2, 64, 16);
+
+  // Act.
+  fillWithTwoActors(buffer, observations, 20);
+  auto [obs, actions, rewards, dones, next_obs] = buffer.sample();
+
+  // Assert.
+  EXPECT_EQ(buffer.size(), 40);
+  EXPECT_EQ(buffer.getShard(0)->size(), 20);
+  EXPECT_EQ(buffer.getShard(1)->size(), 20);
+  ASSERT_EQ(actions.size(0), 16);
+  for (int i = 0; i < 16; i++) {
+    int t = actions[i].item<int>() % 100;
+    EXPECT_EQ_TENSOR(obs[i], observations[t]);
+    EXPECT_EQ_TENSOR(next_obs[i], observations[t + 1]);
+    EXPECT_TRUE(std::abs(rewards[i].item<float>() - t) < TEST_EPSILON);
+  }
+}
+
+TEST(TestShardedReplayBuffer, TestShardsAreSampledAccordingToTheirPriorities) {
+  // Arrange.
+  auto observations = getObservations(11);
+  std::map<std::string, float> args = {{"initial_priority", 1}};
+  auto buffer = ShardedReplayBuffer(2, 32, 32, 1, 4, 84, CompressorType::ZLIB, args);
+  fillWithTwoActors(buffer, observations, 10);
+  for (int i = 0; i < 10; i++) {
+    buffer.getShard(0)->getPriorities()->set(i, 3);
+  }
+
+  // Act.
+  int n_first_shard = 0;
+  int n_experiences = 0;
+  for (int i = 0; i < 200; i++) {
+    auto actions = std::get<1>(buffer.sample());
+    n_first_shard += (actions < 100).sum().item<int>();
+    n_experiences += actions.size(0);
+  }
+
+  // Assert: the first shard holds three quarters of the total priority.
+  EXPECT_NEAR(static_cast<double>(n_first_shard) / n_experiences, 0.75, 0.03);
+}
+
+TEST(TestShardedReplayBuffer, TestReportNormalizesWeightsOverAllShards) {
+  // Arrange.
+  auto observations = getObservations(11);
+  std::map<std::string, float> args = {{"initial_priority", 1}, {"omega_is", 1}};
+  auto buffer = ShardedReplayBuffer(2, 32, 32, 1, 4, 84, CompressorType::ZLIB, args);
+  fillWithTwoActors(buffer, observations, 10);
+  for (int i = 0; i < 10; i++) {
+    buffer.getShard(1)->getPriorities()->set(i, 4);
+  }
+
+  // Act.
+  auto actions = std::get<1>(buffer.sample());
+  auto loss = torch::ones({actions.size(0)});
+  auto new_loss = buffer.report(loss);
+
+  // Assert: the weights are (priority / smallest priority)^-omega_is.
+  ASSERT_EQ(new_loss.size(0), actions.size(0));
+  for (int i = 0; i < actions.size(0); i++) {
+    float weight = (actions[i].item<int>() < 100) ? 1.0 : 0.25;
+    EXPECT_NEAR(new_loss[i].item<float>(), weight, 0.001);
+  }
+}
+}  // namespace relab::test::agents::memory
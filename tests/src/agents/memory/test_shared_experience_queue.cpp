@@ -0,0 +1,167 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <torch/extension.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "agents/memory/replay_buffer.hpp"
+#include "agents/memory/sharded_replay_buffer.hpp"
+#include "agents/memory/shared_experience_queue.hpp"
+
+#include "relab_test.hpp"
+
+using namespace relab::agents::memory;
+
+namespace relab::test::agents::memory {
+
+TEST(TestSharedExperienceQueue, TestPushAndPopThroughTwoMappings) {
+  // Arrange.
+  auto observations = getObservations(6);
+  auto experiences = getExperiences(observations, 5);
+  SharedExperienceQueue learner_queue("/relab_test_queue_mappings", 8);
+  SharedExperienceQueue actor_queue("/relab_test_queue_mappings", 0, 0, 0, false);
+
+  // Act.
+  for (int t = 0; t < 5; t++) {
+    EXPECT_TRUE(actor_queue.push(experiences[t]));
+  }
+
+  // Assert.
+  EXPECT_EQ(actor_queue.capacity(), 8);
+  EXPECT_EQ(learner_queue.size(), 5);
+  for (int t = 0; t < 5; t++) {
+    auto experience = learner_queue.pop();
+    ASSERT_TRUE(experience.has_value());
+    EXPECT_EQ_TENSOR(experience->obs, experiences[t].obs);
+    EXPECT_EQ_TENSOR(experience->next_obs, experiences[t].next_obs);
+    EXPECT_EQ(experience->action, experiences[t].action);
+    EXPECT_EQ(experience->reward, experiences[t].reward);
+    EXPECT_EQ(experience->done, experiences[t].done);
+  }
+  EXPECT_FALSE(learner_queue.pop().has_value());
+}
+
+TEST(TestSharedExperienceQueue, TestFullAndEmptyQueue) {
+  // Arrange.
+  auto observations = getObservations(4);
+  auto experiences = getExperiences(observations, 3);
+  SharedExperienceQueue queue("/relab_test_queue_bounds", 2);
+
+  // Act and assert.
+  EXPECT_FALSE(queue.pop().has_value());
+  EXPECT_TRUE(queue.push(experiences[0]));
+  EXPECT_TRUE(queue.push(experiences[1]));
+  EXPECT_FALSE(queue.push(experiences[2]));
+  EXPECT_EQ(queue.pop()->action, experiences[0].action);
+  EXPECT_TRUE(queue.push(experiences[2]));
+  EXPECT_EQ(queue.pop()->action, experiences[1].action);
+  EXPECT_EQ(queue.pop()->action, experiences[2].action);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(TestSharedExperienceQueue, TestPushAndPopOfTheNewestFrames) {
+  // Arrange.
+  auto observations = getObservations(2);
+  auto experience = Experience::fromNewestFrames(observations[0], 3, 1, false, observations[1], 1);
+  SharedExperienceQueue queue("/relab_test_queue_newest_frames", 2);
+
+  // Act.
+  EXPECT_TRUE(queue.push(experience));
+  auto popped_experience = queue.pop();
+
+  // Assert: only the newest frame is stored, and an observation with more frames than a stack is rejected.
+  ASSERT_TRUE(popped_experience.has_value());
+  EXPECT_EQ(popped_experience->next_obs.size(0), 1);
+  EXPECT_EQ_TENSOR(popped_experience->next_obs, experience.next_obs);
+  auto too_many_frames = torch::cat({observations[1], observations[1]});
+  EXPECT_THROW(queue.push(Experience(observations[0], 3, 1, false, too_many_frames)), std::runtime_error);
+}
+
+TEST(TestSharedExperienceQueue, TestTruncatedSegmentIsRejected) {
+  // Arrange: shrink the segment of a queue, so that its last slots are not backed by memory.
+  SharedExperienceQueue queue("/relab_test_queue_truncated", 8);
+  int fd = shm_open("/relab_test_queue_truncated", O_RDWR, 0600);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(ftruncate(fd, sizeof(relab::agents::memory::impl::QueueHeader) + 64), 0);
+  close(fd);
+
+  // Act and assert.
+  EXPECT_THROW(SharedExperienceQueue("/relab_test_queue_truncated", 0, 0, 0, false), std::runtime_error);
+}
+
+TEST(TestSharedExperienceQueue, TestDrainOfInterleavedActors) {
+  // Arrange: each actor plays two episodes of five steps, whose frames are offset by the actor index, and the actors
+  // push their experiences in turn. The action of each experience identifies its actor, episode and step.
+  int n_actors = 3;
+  int episode_length = 5;
+  auto observations = getObservations(episode_length + 1);
+  SharedExperienceQueue queue("/relab_test_queue_interleaved", 64);
+  for (int episode = 0; episode < 2; episode++) {
+    for (int t = 0; t < episode_length; t++) {
+      for (int actor = 0; actor < n_actors; actor++) {
+        bool done = (t == episode_length - 1);
+        int action = 100 * actor + 10 * episode + t;
+        Experience experience(observations[t] + actor, action, t, done, observations[t + 1] + actor);
+        EXPECT_TRUE(queue.push(experience, actor));
+      }
+    }
+  }
+
+  // Act.
+  auto buffer = ShardedReplayBuffer(n_actors, 96, 32);
+  int n_drained = buffer.drain(queue);
+
+  // Assert: the sampled observations are the ones pushed by the actor of each experience.
+  EXPECT_EQ(n_drained, 2 * n_actors * episode_length);
+  EXPECT_EQ(buffer.size(), 2 * n_actors * episode_length);
+  for (int i = 0; i < 4; i++) {
+    auto [obs, actions, rewards, dones, next_obs] = buffer.sample();
+    for (int j = 0; j < actions.size(0); j++) {
+      int action = actions[j].item<int>();
+      int actor = action / 100;
+      int t = action % 10;
+      EXPECT_EQ_TENSOR(obs[j], (observations[t] + actor));
+      EXPECT_EQ_TENSOR(next_obs[j], (observations[t + 1] + actor));
+    }
+  }
+}
+
+TEST(TestSharedExperienceQueue, TestDrainOfAnotherActorIsRejected) {
+  // Arrange.
+  auto observations = getObservations(2);
+  auto buffer = ReplayBuffer(16, 4, 1, 4, 84, CompressorType::ZLIB);
+  SharedExperienceQueue queue("/relab_test_queue_other_actor", 4);
+  queue.push(Experience(observations[0], 0, 0, false, observations[1]), 1);
+
+  // Act and assert.
+  EXPECT_THROW(buffer.drain(queue), std::runtime_error);
+}
+
+TEST(TestSharedExperienceQueue, TestDrainIntoReplayBuffer) {
+  // Arrange.
+  auto observations = getObservations(11);
+  auto experiences = getExperiences(observations, 10);
+  auto buffer = ReplayBuffer(16, 4, 1, 4, 84, CompressorType::ZLIB);
+  SharedExperienceQueue queue("/relab_test_queue_drain", 16);
+  for (int t = 0; t < 10; t++) {
+    queue.push(experiences[t]);
+  }
+
+  // Act.
+  int n_drained = buffer.drain(queue, 4);
+  int n_remaining = buffer.drain(queue);
+
+  // Assert.
+  EXPECT_EQ(n_drained, 4);
+  EXPECT_EQ(n_remaining, 6);
+  EXPECT_EQ(buffer.size(), 10);
+  EXPECT_EQ(queue.size(), 0);
+  auto indices = torch::arange(10);
+  compareExperiences(buffer.getExperiences(indices), experiences.begin(), 10);
+}
+}  // namespace relab::test::agents::memory
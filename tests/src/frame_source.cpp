@@ -0,0 +1,317 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include "frame_source.hpp"
+#include <torch/extension.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <vector>
+
+// The palette of the frames, i.e., the gray levels of Atari frames after preprocessing.
+#define BACKGROUND 0.34f
+#define WALL 0.56f
+#define SPRITE 0.93f
+#define PADDLE 0.58f
+#define SCORE 0.78f
+
+// The size of the sprites and the height of the score display.
+#define BALL_SIZE 2
+#define PADDLE_LENGTH 8
+#define PADDLE_WIDTH 2
+#define SCORE_HEIGHT 12
+
+// The number of points ending a game of Pong, and the number of lives in Breakout.
+#define MAX_SCORE 21
+#define N_LIVES 5
+
+// The number of brick rows and the size of each brick in Breakout.
+#define N_BRICK_ROWS 6
+#define BRICK_WIDTH 4
+#define BRICK_HEIGHT 2
+
+namespace relab::test::impl {
+
+// The 3x5 font used to draw the scores, each digit is a 15 bits mask read row by row.
+static const int FONT[10] = {0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF};
+
+FrameSource::FrameSource(Game game, int seed, int screen_size) :
+    game(game), screen_size(screen_size), generator(seed), screen(screen_size * screen_size) {
+  this->reset();
+}
+
+void FrameSource::reset() {
+  this->last_frames.clear();
+  this->scores[0] = 0;
+  this->scores[1] = 0;
+  this->lives = N_LIVES;
+  this->done = false;
+
+  // Place the paddles in the middle of their range.
+  this->paddle = (this->screen_size - PADDLE_LENGTH) / 2.0f;
+  this->opponent = this->paddle;
+
+  // Add all the bricks.
+  int n_columns = (this->screen_size - 4) / BRICK_WIDTH;
+  this->bricks.assign(N_BRICK_ROWS * n_columns, true);
+  this->n_bricks = this->bricks.size();
+
+  this->serve();
+  this->render();
+}
+
+void FrameSource::serve() {
+  std::uniform_real_distribution<float> uniform(-1, 1);
+  std::bernoulli_distribution coin(0.5);
+  this->ball_x = this->screen_size / 2.0f;
+  if (this->game == Game::PONG) {
+    this->ball_y = (SCORE_HEIGHT + this->screen_size) / 2.0f;
+    this->ball_dx = coin(this->generator) ? 1.5f : -1.5f;
+    this->ball_dy = uniform(this->generator);
+  } else {
+    this->ball_y = SCORE_HEIGHT + 8 + N_BRICK_ROWS * BRICK_HEIGHT + 4;
+    this->ball_dx = uniform(this->generator);
+    this->ball_dy = 1.5f;
+  }
+}
+
+float FrameSource::step(int action) {
+  if (this->done == true) {
+    return 0;
+  }
+  float reward = (this->game == Game::PONG) ? this->stepPong(action) : this->stepBreakout(action);
+  this->render();
+  return reward;
+}
+
+float FrameSource::stepPong(int action) {
+  int top = SCORE_HEIGHT + 2;
+  int bottom = this->screen_size - 2 - BALL_SIZE;
+  int max_paddle = this->screen_size - 2 - PADDLE_LENGTH;
+  int opponent_x = 8;
+  int paddle_x = this->screen_size - 8 - PADDLE_WIDTH;
+
+  // Move the player's paddle, and the opponent's paddle toward the ball with a limited speed.
+  this->paddle += (action == 1) ? -2 : (action == 2) ? 2 : 0;
+  this->paddle = std::clamp(this->paddle, static_cast<float>(top), static_cast<float>(max_paddle));
+  float target = this->ball_y + BALL_SIZE / 2.0f - PADDLE_LENGTH / 2.0f;
+  this->opponent += std::clamp(target - this->opponent, -1.25f, 1.25f);
+  this->opponent = std::clamp(this->opponent, static_cast<float>(top), static_cast<float>(max_paddle));
+
+  // Move the ball, and bounce on the walls.
+  this->ball_x += this->ball_dx;
+  this->ball_y += this->ball_dy;
+  if (this->ball_y < top || this->ball_y > bottom) {
+    this->ball_y = std::clamp(this->ball_y, static_cast<float>(top), static_cast<float>(bottom));
+    this->ball_dy = -this->ball_dy;
+  }
+
+  // Bounce on the paddles, the ball's vertical speed depends on where it hits the paddle.
+  auto hits = [this](float paddle_y) {
+    float offset = this->ball_y + BALL_SIZE / 2.0f - (paddle_y + PADDLE_LENGTH / 2.0f);
+    return (std::abs(offset) <= (PADDLE_LENGTH + BALL_SIZE) / 2.0f) ? offset : NAN;
+  };
+  if (this->ball_dx > 0 && this->ball_x + BALL_SIZE >= paddle_x && this->ball_x < paddle_x + PADDLE_WIDTH) {
+    float offset = hits(this->paddle);
+    if (std::isnan(offset) == false) {
+      this->ball_dx = -this->ball_dx;
+      this->ball_dy = std::clamp(offset / 2, -2.0f, 2.0f);
+    }
+  } else if (this->ball_dx < 0 && this->ball_x <= opponent_x + PADDLE_WIDTH && this->ball_x + BALL_SIZE > opponent_x) {
+    float offset = hits(this->opponent);
+    if (std::isnan(offset) == false) {
+      this->ball_dx = -this->ball_dx;
+      this->ball_dy = std::clamp(offset / 2, -2.0f, 2.0f);
+    }
+  }
+
+  // Give a point to the player who did not miss the ball.
+  float reward = 0;
+  if (this->ball_x < 0 || this->ball_x > this->screen_size - BALL_SIZE) {
+    reward = (this->ball_x < 0) ? 1 : -1;
+    this->scores[(this->ball_x < 0) ? 1 : 0] += 1;
+    this->done = (std::max(this->scores[0], this->scores[1]) >= MAX_SCORE);
+    this->serve();
+  }
+  return reward;
+}
+
+float FrameSource::stepBreakout(int action) {
+  int left = 2;
+  int right = this->screen_size - 2 - BALL_SIZE;
+  int top = SCORE_HEIGHT + 2;
+  int paddle_y = this->screen_size - 6;
+  int bricks_y = SCORE_HEIGHT + 8;
+  int n_columns = (this->screen_size - 4) / BRICK_WIDTH;
+
+  // Move the player's paddle.
+  this->paddle += (action == 1) ? -2 : (action == 2) ? 2 : 0;
+  float max_paddle = right + BALL_SIZE - PADDLE_LENGTH;
+  this->paddle = std::clamp(this->paddle, static_cast<float>(left), max_paddle);
+
+  // Move the ball, and bounce on the walls.
+  this->ball_x += this->ball_dx;
+  this->ball_y += this->ball_dy;
+  if (this->ball_x < left || this->ball_x > right) {
+    this->ball_x = std::clamp(this->ball_x, static_cast<float>(left), static_cast<float>(right));
+    this->ball_dx = -this->ball_dx;
+  }
+  if (this->ball_y < top) {
+    this->ball_y = top;
+    this->ball_dy = -this->ball_dy;
+  }
+
+  // Break the brick hit by the ball, higher bricks give larger rewards.
+  float reward = 0;
+  int row = static_cast<int>(this->ball_y + BALL_SIZE / 2.0f - bricks_y) / BRICK_HEIGHT;
+  int column = static_cast<int>(this->ball_x + BALL_SIZE / 2.0f - 2) / BRICK_WIDTH;
+  if (this->ball_y + BALL_SIZE / 2.0f >= bricks_y && row < N_BRICK_ROWS && column >= 0 && column < n_columns) {
+    int index = row * n_columns + column;
+    if (this->bricks[index] == true) {
+      this->bricks[index] = false;
+      this->n_bricks -= 1;
+      this->ball_dy = -this->ball_dy;
+      reward = 1 + (N_BRICK_ROWS - 1 - row) / 2;
+      this->scores[1] += static_cast<int>(reward);
+    }
+  }
+
+  // Bounce on the paddle, the ball's horizontal speed depends on where it hits the paddle.
+  if (this->ball_dy > 0 && this->ball_y + BALL_SIZE >= paddle_y && this->ball_y < paddle_y + PADDLE_WIDTH) {
+    float offset = this->ball_x + BALL_SIZE / 2.0f - (this->paddle + PADDLE_LENGTH / 2.0f);
+    if (std::abs(offset) <= (PADDLE_LENGTH + BALL_SIZE) / 2.0f) {
+      this->ball_dy = -this->ball_dy;
+      this->ball_dx = std::clamp(offset / 2, -2.0f, 2.0f);
+    }
+  }
+
+  // Lose a life when the ball is missed, the episode ends when all lives or bricks are gone.
+  if (this->ball_y > this->screen_size) {
+    this->lives -= 1;
+    this->serve();
+  }
+  this->done = (this->lives == 0 || this->n_bricks == 0);
+  return reward;
+}
+
+void FrameSource::render() {
+  std::fill(this->screen.begin(), this->screen.end(), BACKGROUND);
+  int size = this->screen_size;
+
+  if (this->game == Game::PONG) {
+    // Draw the scores, the walls and the paddles.
+    this->drawNumber(this->scores[0], size / 4, 3, SCORE);
+    this->drawNumber(this->scores[1], 3 * size / 4, 3, SCORE);
+    this->fillRectangle(0, SCORE_HEIGHT, size, 2, WALL);
+    this->fillRectangle(0, size - 2, size, 2, WALL);
+    this->fillRectangle(8, std::lround(this->opponent), PADDLE_WIDTH, PADDLE_LENGTH, PADDLE);
+    this->fillRectangle(size - 8 - PADDLE_WIDTH, std::lround(this->paddle), PADDLE_WIDTH, PADDLE_LENGTH, PADDLE);
+  } else {
+    // Draw the score, the remaining lives, the walls, the bricks and the paddle.
+    this->drawNumber(this->scores[1], size / 4, 3, SCORE);
+    this->drawNumber(this->lives, 3 * size / 4, 3, SCORE);
+    this->fillRectangle(0, SCORE_HEIGHT, size, 2, WALL);
+    this->fillRectangle(0, SCORE_HEIGHT, 2, size - SCORE_HEIGHT, WALL);
+    this->fillRectangle(size - 2, SCORE_HEIGHT, 2, size - SCORE_HEIGHT, WALL);
+    int n_columns = (size - 4) / BRICK_WIDTH;
+    for (int i = 0; i < static_cast<int>(this->bricks.size()); i++) {
+      if (this->bricks[i] == true) {
+        int row = i / n_columns;
+        int x = 2 + (i % n_columns) * BRICK_WIDTH;
+        this->fillRectangle(x, SCORE_HEIGHT + 8 + row * BRICK_HEIGHT, BRICK_WIDTH, BRICK_HEIGHT, 0.9f - 0.1f * row);
+      }
+    }
+    this->fillRectangle(std::lround(this->paddle), size - 6, PADDLE_LENGTH, PADDLE_WIDTH, PADDLE);
+  }
+
+  // Draw the ball.
+  this->fillRectangle(std::lround(this->ball_x), std::lround(this->ball_y), BALL_SIZE, BALL_SIZE, SPRITE);
+}
+
+void FrameSource::fillRectangle(int x, int y, int width, int height, float value) {
+  int x_end = std::min(x + width, this->screen_size);
+  int y_end = std::min(y + height, this->screen_size);
+  for (int i = std::max(y, 0); i < y_end; i++) {
+    for (int j = std::max(x, 0); j < x_end; j++) {
+      this->screen[i * this->screen_size + j] = value;
+    }
+  }
+}
+
+void FrameSource::drawNumber(int number, int x, int y, float value) {
+  std::string digits = std::to_string(number);
+  for (size_t k = 0; k < digits.size(); k++) {
+    int mask = FONT[digits[k] - '0'];
+    for (int i = 0; i < 15; i++) {
+      if ((mask >> (14 - i)) & 1) {
+        this->fillRectangle(x + 4 * k + i % 3, y + i / 3, 1, 1, value);
+      }
+    }
+  }
+}
+
+torch::Tensor FrameSource::frame() {
+  return torch::from_blob(this->screen.data(), {this->screen_size, this->screen_size}).clone();
+}
+
+bool FrameSource::isDone() { return this->done; }
+
+int FrameSource::sampleAction() {
+  // Act randomly some of the time.
+  std::uniform_int_distribution<int> random_action(0, 2);
+  std::bernoulli_distribution follow_ball(0.7);
+  if (follow_ball(this->generator) == false) {
+    return random_action(this->generator);
+  }
+
+  // Otherwise, move the paddle toward the ball.
+  float ball = (this->game == Game::PONG) ? this->ball_y : this->ball_x;
+  float offset = ball + BALL_SIZE / 2.0f - (this->paddle + PADDLE_LENGTH / 2.0f);
+  return (std::abs(offset) < 2) ? 0 : (offset < 0) ? 1 : 2;
+}
+
+std::vector<Experience> FrameSource::getExperiences(int n, int stack_size, int frame_skip) {
+  // The last frames, which are all equal to the first frame at the beginning of an episode.
+  auto &frames = this->last_frames;
+  if (static_cast<int>(frames.size()) != stack_size) {
+    frames.assign(stack_size, this->frame());
+  }
+  auto stack = [&frames]() { return torch::stack(std::vector<torch::Tensor>(frames.begin(), frames.end())); };
+
+  std::vector<Experience> experiences;
+  while (static_cast<int>(experiences.size()) < n) {
+    // Repeat the action, the observation is shifted by one frame after each repetition.
+    auto obs = stack();
+    int action = this->sampleAction();
+    float reward = 0;
+    for (int i = 0; i < frame_skip; i++) {
+      reward += this->step(action);
+      frames.pop_front();
+      frames.push_back(this->frame());
+    }
+    bool done = this->isDone();
+    experiences.push_back(Experience(obs, action, reward, done, stack()));
+
+    // Start a new episode if needed.
+    if (done == true) {
+      this->reset();
+      frames.assign(stack_size, this->frame());
+    }
+  }
+  return experiences;
+}
+
+std::vector<torch::Tensor> FrameSource::getFrames(int n) {
+  std::vector<torch::Tensor> frames;
+  for (int i = 0; i < n; i++) {
+    frames.push_back(this->frame());
+    this->step(this->sampleAction());
+    if (this->isDone() == true) {
+      this->reset();
+    }
+  }
+  return frames;
+}
+
+}  // namespace relab::test::impl
@@ -0,0 +1,80 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <experimental/filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "helpers/numa.hpp"
+#include "helpers/thread_pool.hpp"
+
+using namespace relab::helpers;
+using namespace std::experimental::filesystem;
+
+namespace relab::test::helpers {
+
+TEST(TestNuma, TestParseCpuList) {
+  EXPECT_EQ(NumaTopology::parseCpuList("0-3,8,10-11\n"), std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(NumaTopology::parseCpuList(""), std::vector<int>());
+}
+
+TEST(TestNuma, TestReadTopologyFromSysfs) {
+  // Arrange: two nodes with CPUs, and a node with memory only.
+  path sysfs = temp_directory_path() / "relab_test_numa";
+  remove_all(sysfs);
+  std::vector<std::string> cpu_lists = {"0-1,4", "2-3", ""};
+  for (size_t i = 0; i < cpu_lists.size(); i++) {
+    create_directories(sysfs / ("node" + std::to_string(i)));
+    std::ofstream(sysfs / ("node" + std::to_string(i)) / "cpulist") << cpu_lists[i] << std::endl;
+  }
+  std::ofstream(sysfs / "possible") << "0-2" << std::endl;
+
+  // Act.
+  NumaTopology topology(sysfs.string());
+  remove_all(sysfs);
+
+  // Assert.
+  ASSERT_EQ(topology.nNodes(), 2);
+  EXPECT_EQ(topology.cpus(0), std::vector<int>({0, 1, 4}));
+  EXPECT_EQ(topology.cpus(1), std::vector<int>({2, 3}));
+  EXPECT_EQ(topology.nodeOfCpu(4), 0);
+  EXPECT_EQ(topology.nodeOfCpu(3), 1);
+  EXPECT_EQ(topology.nodeOfCpu(5), -1);
+}
+
+TEST(TestNuma, TestFallbackToSingleNode) {
+  // Act.
+  NumaTopology topology("/relab/no/such/directory");
+  int value = 0;
+
+  // Assert.
+  ASSERT_EQ(topology.nNodes(), 1);
+  int n_cpus = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  EXPECT_EQ(static_cast<int>(topology.cpus(0).size()), n_cpus);
+  EXPECT_EQ(topology.nodeOfAddress(&value), 0);
+  EXPECT_FALSE(topology.pinCurrentThread(0));
+  EXPECT_FALSE(topology.preferNode(0));
+}
+
+TEST(TestNuma, TestNumaAwareThreadPoolRunsAllTasks) {
+  // Arrange.
+  ThreadPool pool(4, true);
+  std::atomic<int> n_tasks(0);
+
+  // Act.
+  for (int i = 0; i < 100; i++) {
+    pool.push([&n_tasks] { n_tasks.fetch_add(1); }, i % (pool.nNodes() + 1) - 1);
+  }
+  pool.synchronize();
+
+  // Assert.
+  int n_nodes = NumaTopology::global().nNodes();
+  EXPECT_EQ(pool.nNodes(), (n_nodes <= 4) ? n_nodes : 1);
+  EXPECT_EQ(n_tasks.load(), 100);
+}
+}  // namespace relab::test::helpers
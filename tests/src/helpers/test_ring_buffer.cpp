@@ -0,0 +1,90 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "helpers/ring_buffer.hpp"
+#include "helpers/serialize.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::test::helpers {
+
+TEST(TestRingBuffer, TestPushDiscardsElementsAtTheOtherEnd) {
+  // Arrange.
+  RingBuffer<int> queue(3);
+
+  // Act.
+  for (int element : {1, 2, 3, 4, 5}) {
+    queue.push_back(element);
+  }
+  queue.push_front(0);
+
+  // Assert.
+  ASSERT_EQ(queue.size(), 3);
+  EXPECT_EQ(queue[0], 0);
+  EXPECT_EQ(queue[1], 3);
+  EXPECT_EQ(queue[2], 4);
+  EXPECT_EQ(queue.front(), 0);
+  EXPECT_EQ(queue.back(), 4);
+}
+
+TEST(TestRingBuffer, TestPopAndClear) {
+  // Arrange.
+  RingBuffer<float> queue(4);
+  for (float element : {1.0f, 2.0f, 3.0f, 4.0f}) {
+    queue.push_front(element);
+  }
+
+  // Act.
+  queue.pop_front();
+  queue.pop_back();
+  queue[0] += 10;
+
+  // Assert.
+  ASSERT_EQ(queue.size(), 2);
+  EXPECT_EQ(queue.get(0), 13.0f);
+  EXPECT_EQ(queue.get(1), 2.0f);
+  queue.clear();
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(TestRingBuffer, TestSaveAndLoad) {
+  // Arrange.
+  RingBuffer<bool> queue(3);
+  for (bool element : {true, false, false, true}) {
+    queue.push_back(element);
+  }
+
+  // Act.
+  std::stringstream ss;
+  queue.save(ss);
+  RingBuffer<bool> loaded_queue(1);
+  loaded_queue.load(ss);
+
+  // Assert.
+  EXPECT_EQ(queue, loaded_queue);
+  loaded_queue.push_back(false);
+  EXPECT_NE(queue, loaded_queue);
+}
+
+TEST(TestRingBuffer, TestSaveFormat) {
+  // Arrange.
+  RingBuffer<int> queue(2);
+  for (int element : {7, 8, 9}) {
+    queue.push_back(element);
+  }
+  std::stringstream expected_ss;
+  for (int value : {2, 2, 8, 9}) {
+    save_value(value, expected_ss);
+  }
+
+  // Act.
+  std::stringstream queue_ss;
+  queue.save(queue_ss);
+
+  // Assert.
+  EXPECT_EQ(queue_ss.str(), expected_ss.str());
+}
+}  // namespace relab::test::helpers
@@ -0,0 +1,81 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "helpers/stats.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::test::helpers {
+
+TEST(TestStats, TestHistogramPercentiles) {
+  // Record the latencies from 1 to 100000 nanoseconds.
+  Histogram histogram;
+  for (uint64_t i = 1; i <= 100000; i++) {
+    histogram.record(i);
+  }
+
+  // Check that the percentiles are within the histogram's precision.
+  EXPECT_EQ(histogram.count(), 100000);
+  for (auto percentage : {1.0, 50.0, 90.0, 99.0, 100.0}) {
+    EXPECT_NEAR(histogram.percentile(percentage), 1000 * percentage, 0.07 * 1000 * percentage);
+  }
+
+  // Check that the summary is expressed in microseconds.
+  auto summary = histogram.summary();
+  EXPECT_EQ(summary["count"], 100000);
+  EXPECT_NEAR(summary["mean_us"], 50.0005, 1e-6);
+  EXPECT_EQ(summary["max_us"], 100);
+}
+
+TEST(TestStats, TestHistogramSmallValuesAndClear) {
+  // Record small latencies, which have a bucket of their own.
+  Histogram histogram;
+  for (uint64_t i = 0; i < Histogram::N_SUB_BUCKETS; i++) {
+    histogram.record(i);
+    EXPECT_EQ(histogram.percentile(100), i);
+  }
+
+  // Check that clearing the histogram removes all latencies.
+  histogram.clear();
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.percentile(50), 0);
+}
+
+TEST(TestStats, TestHistogramConcurrentRecording) {
+  // Record latencies from several threads at once.
+  Histogram histogram;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.push_back(std::thread([&histogram]() {
+      for (uint64_t j = 0; j < 10000; j++) {
+        histogram.record(j);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Check that no latency was lost.
+  EXPECT_EQ(histogram.count(), 40000);
+  EXPECT_EQ(histogram.summary()["max_us"], 9.999);
+}
+
+TEST(TestStats, TestStatsSummaryOnlyContainsRecordedOperations) {
+  // Record the latency of a single operation.
+  Stats stats;
+  stats[Operation::SAMPLE].record(1000);
+
+  // Check that only this operation is summarized.
+  auto summary = stats.summary();
+  EXPECT_EQ(summary.size(), 1);
+  EXPECT_EQ(summary["sample"]["count"], 1);
+  EXPECT_EQ(Stats::name(Operation::APPEND), "append");
+  EXPECT_EQ(Stats::name(Operation::LOAD), "load");
+}
+}  // namespace relab::test::helpers
@@ -0,0 +1,115 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "helpers/thread_pool.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::test::helpers {
+
+TEST(TestThreadPool, TestSynchronizeWaitsForAllTasks) {
+  // Arrange.
+  ThreadPool pool(3);
+  std::atomic<int> n_tasks(0);
+
+  // Act.
+  for (int i = 0; i < 30; i++) {
+    pool.push([&n_tasks] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      n_tasks.fetch_add(1);
+    });
+  }
+  pool.synchronize();
+
+  // Assert.
+  EXPECT_EQ(pool.nThreads(), 3);
+  EXPECT_EQ(n_tasks.load(), 30);
+}
+
+TEST(TestThreadPool, TestGroupWaitsOnlyForItsTasks) {
+  // Arrange.
+  ThreadPool pool(2);
+  std::atomic<bool> released(false);
+  std::atomic<int> n_tasks(0);
+  TaskGroup group;
+
+  // Act.
+  pool.push([&released] {
+    while (released.load() == false) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  for (int i = 0; i < 10; i++) {
+    pool.push([&n_tasks] { n_tasks.fetch_add(1); }, group);
+  }
+  group.wait();
+  bool blocked = (released.load() == false);
+  released.store(true);
+  pool.synchronize();
+
+  // Assert.
+  EXPECT_TRUE(blocked);
+  EXPECT_EQ(n_tasks.load(), 10);
+}
+
+TEST(TestThreadPool, TestWorkersArePinnedToTheAllowedCpus) {
+  // Arrange.
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int cpu = 0;
+  while (CPU_ISSET(cpu, &allowed) == 0) {
+    ++cpu;
+  }
+  std::vector<int> cpus = {cpu};
+  ThreadPool pool(2, false, cpus);
+  std::mutex mutex;
+  std::set<int> used_cpus;
+
+  // Act.
+  for (int i = 0; i < 20; i++) {
+    pool.push([&mutex, &used_cpus] {
+      std::lock_guard<std::mutex> lock(mutex);
+      used_cpus.insert(sched_getcpu());
+    });
+  }
+  pool.synchronize();
+
+  // Assert.
+  EXPECT_EQ(used_cpus, std::set<int>({cpu}));
+}
+
+TEST(TestThreadPool, TestSharedPoolIsReusedWhileAlive) {
+  // Act.
+  auto first = ThreadPool::shared(2);
+  auto second = ThreadPool::shared(2);
+  bool same_pool = (first == second);
+  first.reset();
+  second.reset();
+  auto third = ThreadPool::shared(5);
+
+  // Assert.
+  EXPECT_TRUE(same_pool);
+  EXPECT_EQ(third->nThreads(), 5);
+}
+
+TEST(TestThreadPool, TestConflictingSharedPoolIsRejected) {
+  // Arrange.
+  auto pool = ThreadPool::shared(2);
+
+  // Act and Assert.
+  EXPECT_THROW(ThreadPool::shared(5), std::runtime_error);
+  EXPECT_THROW(ThreadPool::shared(2, false, {0}), std::runtime_error);
+}
+}  // namespace relab::test::helpers
@@ -0,0 +1,105 @@
+// Copyright 2025 Theophile Champion. No Rights Reserved.
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "helpers/thread_pool.hpp"
+#include "helpers/trace.hpp"
+
+using namespace relab::helpers;
+
+namespace relab::test::helpers {
+
+TEST(TestTrace, TestNoSpansAreRecordedWhenDisabled) {
+  // Record a span while tracing is disabled.
+  Tracer &tracer = Tracer::global();
+  tracer.start(10);
+  tracer.stop();
+  { RELAB_TRACE("disabled"); }
+
+  // Check that no span was recorded.
+  EXPECT_EQ(tracer.getEvents().size(), 0);
+}
+
+TEST(TestTrace, TestRingBufferKeepsTheMostRecentSpans) {
+  // Record more spans than the ring buffer can store.
+  Tracer &tracer = Tracer::global();
+  tracer.start(4);
+  for (int i = 0; i < 10; i++) {
+    tracer.record("span", i, 1);
+  }
+  tracer.stop();
+
+  // Check that only the most recent spans are kept, from the oldest to the most recent.
+  auto events = tracer.getEvents();
+  ASSERT_EQ(events.size(), 4);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(events[i].start, 6 + i);
+  }
+}
+
+TEST(TestTrace, TestNegativeCapacityIsRejected) { EXPECT_THROW(Tracer::global().start(-1), std::runtime_error); }
+
+TEST(TestTrace, TestSpansAreRecordedFromMultipleThreads) {
+  // Record spans from several threads at once.
+  Tracer &tracer = Tracer::global();
+  tracer.start(1000);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&tracer]() {
+      for (int j = 0; j < 100; j++) {
+        tracer.record("span", j, 1);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  tracer.stop();
+
+  // Check that no span was lost.
+  EXPECT_EQ(tracer.getEvents().size(), 400);
+}
+
+TEST(TestTrace, TestThreadIndicesAreReused) {
+  // Retrieve the index of a thread that then exits.
+  int index = -1;
+  std::thread([&index]() { index = Tracer::threadIndex(); }).join();
+
+  // Check that the index is given to the next thread, so that the thread names do not accumulate.
+  int next_index = -1;
+  std::thread([&next_index]() { next_index = Tracer::threadIndex(); }).join();
+  EXPECT_EQ(index, next_index);
+}
+
+TEST(TestTrace, TestThreadPoolWorkersHaveTheirOwnTrack) {
+  // Execute a task in a thread pool while tracing is enabled.
+  Tracer &tracer = Tracer::global();
+  tracer.start(100);
+  {
+    ThreadPool pool(1);
+    pool.push([]() { RELAB_TRACE("work"); });
+    pool.synchronize();
+  }
+  tracer.stop();
+
+  // Check that the spans are recorded on the worker's track, and that the worker is named.
+  int main_thread = Tracer::threadIndex();
+  bool found_work = false;
+  for (auto &event : tracer.getEvents()) {
+    if (std::string(event.name) == "work") {
+      EXPECT_NE(event.thread, main_thread);
+      found_work = true;
+    }
+  }
+  EXPECT_TRUE(found_work);
+  auto json = tracer.toJson();
+  EXPECT_NE(json.find("\"ThreadPool worker 0\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"ThreadPool::task\",\"cat\":\"relab\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"ThreadPool::synchronize\""), std::string::npos);
+}
+}  // namespace relab::test::helpers